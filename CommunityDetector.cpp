@@ -0,0 +1,387 @@
+#include "CommunityDetector.h"
+#include "GraphAnalytics.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+
+namespace {
+    void atomicAdd(std::atomic<double>& target, double value) {
+        double current = target.load(std::memory_order_relaxed);
+        while (!target.compare_exchange_weak(current, current + value, std::memory_order_relaxed)) {
+        }
+    }
+}
+
+void CommunityDetector::WeightMap::reset(size_t expected) {
+    size_t capacity = 16;
+    while (capacity < expected * 2) capacity <<= 1;
+
+    for (int slot : usedSlots) keys[slot] = -1;
+    usedSlots.clear();
+
+    if (keys.size() < capacity) {
+        keys.assign(capacity, -1);
+        values.resize(capacity);
+        mask = capacity - 1;
+    }
+}
+
+void CommunityDetector::WeightMap::add(int key, double weight) {
+    size_t slot = ((unsigned)key * 2654435761u) & mask;
+    while (keys[slot] != -1 && keys[slot] != key) {
+        slot = (slot + 1) & mask;
+    }
+    if (keys[slot] == -1) {
+        keys[slot] = key;
+        values[slot] = 0.0;
+        usedSlots.push_back((int)slot);
+    }
+    values[slot] += weight;
+}
+
+double CommunityDetector::WeightMap::get(int key) const {
+    size_t slot = ((unsigned)key * 2654435761u) & mask;
+    while (keys[slot] != -1) {
+        if (keys[slot] == key) return values[slot];
+        slot = (slot + 1) & mask;
+    }
+    return 0.0;
+}
+
+void CommunityDetector::clear() {
+    community.clear();
+    communitySizes.clear();
+    communityCount = 0;
+    modularity = 0.0;
+    levels = 0;
+}
+
+void CommunityDetector::buildBaseLevel(const Graph& graph) {
+    const int n = (int)graph.nodes.size();
+    const std::vector<Edge>& edges = graph.edges;
+    std::atomic<int>* cursor = assignment.get();
+
+    parallelFor(n, 16384, [&](size_t begin, size_t end, int) {
+        for (size_t v = begin; v < end; ++v) cursor[v].store(0, std::memory_order_relaxed);
+    });
+    parallelFor(edges.size(), 16384, [&](size_t begin, size_t end, int) {
+        for (size_t i = begin; i < end; ++i) {
+            const Edge& e = edges[i];
+            if (e.from < 0 || e.from >= n || e.to < 0 || e.to >= n || e.from == e.to) continue;
+            cursor[e.from].fetch_add(1, std::memory_order_relaxed);
+            cursor[e.to].fetch_add(1, std::memory_order_relaxed);
+        }
+    });
+
+    baseOffsets.resize(n + 1);
+    baseOffsets[0] = 0;
+    for (int v = 0; v < n; ++v) {
+        baseOffsets[v + 1] = baseOffsets[v] + cursor[v].load(std::memory_order_relaxed);
+        cursor[v].store(baseOffsets[v], std::memory_order_relaxed);
+    }
+    baseTargets.resize(baseOffsets[n]);
+    baseWeights.resize(baseOffsets[n]);
+
+    parallelFor(edges.size(), 16384, [&](size_t begin, size_t end, int) {
+        for (size_t i = begin; i < end; ++i) {
+            const Edge& e = edges[i];
+            if (e.from < 0 || e.from >= n || e.to < 0 || e.to >= n || e.from == e.to) continue;
+            float w = e.weight > 0.0f ? e.weight : 0.0f;
+            int a = cursor[e.from].fetch_add(1, std::memory_order_relaxed);
+            int b = cursor[e.to].fetch_add(1, std::memory_order_relaxed);
+            baseTargets[a] = e.to;
+            baseWeights[a] = w;
+            baseTargets[b] = e.from;
+            baseWeights[b] = w;
+        }
+    });
+
+    useBaseLevel();
+}
+
+void CommunityDetector::useBaseLevel() {
+    curOffsets = baseOffsets.data();
+    curTargets = baseTargets.data();
+    curWeights = baseWeights.data();
+}
+
+double CommunityDetector::computeStrength(int n) {
+    strength.resize(n);
+    parallelFor(n, 4096, [&](size_t begin, size_t end, int) {
+        for (size_t v = begin; v < end; ++v) {
+            double sum = 0.0;
+            for (int i = curOffsets[v]; i < curOffsets[v + 1]; ++i) sum += curWeights[i];
+            strength[v] = sum;
+        }
+    });
+
+    double total = 0.0;
+    for (int v = 0; v < n; ++v) total += strength[v];
+    return total;
+}
+
+int CommunityDetector::moveNodes(int n, double totalWeight, const int* initial) {
+    std::atomic<int>* assign = assignment.get();
+    std::atomic<double>* tot = totals.get();
+    std::atomic<unsigned char>* active = activeFlags.get();
+    const double gamma = resolution;
+    const int workers = ThreadPool::instance().size();
+
+    parallelFor(n, 16384, [&](size_t begin, size_t end, int) {
+        for (size_t v = begin; v < end; ++v) {
+            assign[v].store(initial ? initial[v] : (int)v, std::memory_order_relaxed);
+            tot[v].store(initial ? 0.0 : strength[v], std::memory_order_relaxed);
+            active[v].store(1, std::memory_order_relaxed);
+        }
+    });
+    if (initial) {
+        for (int v = 0; v < n; ++v) {
+            tot[initial[v]].store(tot[initial[v]].load(std::memory_order_relaxed) + strength[v], std::memory_order_relaxed);
+        }
+    }
+
+    int totalMoved = 0;
+    std::vector<int> localMoved(workers);
+    for (int sweep = 0; sweep < maxSweeps; ++sweep) {
+        std::fill(localMoved.begin(), localMoved.end(), 0);
+
+        parallelFor(n, 512, [&](size_t begin, size_t end, int worker) {
+            WeightMap& map = maps[worker];
+            int moved = 0;
+            for (size_t v = begin; v < end; ++v) {
+                // Only nodes whose neighbourhood changed since their last visit can move.
+                if (!active[v].load(std::memory_order_relaxed)) continue;
+                active[v].store(0, std::memory_order_relaxed);
+
+                double kv = strength[v];
+                if (kv <= 0.0) continue;
+
+                int own = assign[v].load(std::memory_order_relaxed);
+                map.reset(curOffsets[v + 1] - curOffsets[v]);
+                for (int i = curOffsets[v]; i < curOffsets[v + 1]; ++i) {
+                    if (curTargets[i] == (int)v) continue;
+                    map.add(assign[curTargets[i]].load(std::memory_order_relaxed), curWeights[i]);
+                }
+
+                // Gain of joining C, up to a common factor: w(v,C) - gamma * k_v * tot(C) / 2m,
+                // with v itself taken out of its current community.
+                double ownTotal = tot[own].load(std::memory_order_relaxed) - kv;
+                double bestGain = map.get(own) - gamma * kv * ownTotal / totalWeight;
+                int best = own;
+                for (int slot : map.usedSlots) {
+                    int c = map.keys[slot];
+                    if (c == own) continue;
+                    double gain = map.values[slot] - gamma * kv * tot[c].load(std::memory_order_relaxed) / totalWeight;
+                    if (gain > bestGain + 1e-12 || (gain > bestGain - 1e-12 && best != own && c < best)) {
+                        bestGain = gain;
+                        best = c;
+                    }
+                }
+
+                if (best != own) {
+                    atomicAdd(tot[own], -kv);
+                    atomicAdd(tot[best], kv);
+                    assign[v].store(best, std::memory_order_relaxed);
+                    for (int i = curOffsets[v]; i < curOffsets[v + 1]; ++i) {
+                        active[curTargets[i]].store(1, std::memory_order_relaxed);
+                    }
+                    moved++;
+                }
+            }
+            localMoved[worker] += moved;
+        });
+
+        int moved = 0;
+        for (int w = 0; w < workers; ++w) moved += localMoved[w];
+        totalMoved += moved;
+        if (moved == 0 || moved < minMovedFraction * n) break;
+    }
+    return totalMoved;
+}
+
+int CommunityDetector::aggregate(int n) {
+    std::atomic<int>* assign = assignment.get();
+
+    // Dense ids for the surviving communities.
+    renumber.assign(n, -1);
+    for (int v = 0; v < n; ++v) {
+        renumber[assign[v].load(std::memory_order_relaxed)] = 0;
+    }
+    int k = 0;
+    for (int c = 0; c < n; ++c) {
+        if (renumber[c] == 0) renumber[c] = k++;
+    }
+    if (k == n) return n;
+
+    // Group level nodes by community.
+    memberOffsets.assign(k + 1, 0);
+    for (int v = 0; v < n; ++v) {
+        memberOffsets[renumber[assign[v].load(std::memory_order_relaxed)] + 1]++;
+    }
+    for (int c = 0; c < k; ++c) memberOffsets[c + 1] += memberOffsets[c];
+    members.resize(n);
+    {
+        std::vector<int> cursor(memberOffsets.begin(), memberOffsets.end() - 1);
+        for (int v = 0; v < n; ++v) {
+            members[cursor[renumber[assign[v].load(std::memory_order_relaxed)]]++] = v;
+        }
+    }
+
+    // Two passes over each community: count distinct neighbour communities,
+    // then write the merged coarse adjacency.
+    nextOffsets.assign(k + 1, 0);
+    auto accumulate = [&](WeightMap& map, int c) {
+        size_t expected = 0;
+        for (int m = memberOffsets[c]; m < memberOffsets[c + 1]; ++m) {
+            int v = members[m];
+            expected += curOffsets[v + 1] - curOffsets[v];
+        }
+        map.reset(expected);
+        for (int m = memberOffsets[c]; m < memberOffsets[c + 1]; ++m) {
+            int v = members[m];
+            for (int i = curOffsets[v]; i < curOffsets[v + 1]; ++i) {
+                map.add(renumber[assign[curTargets[i]].load(std::memory_order_relaxed)], curWeights[i]);
+            }
+        }
+    };
+
+    parallelFor(k, 64, [&](size_t begin, size_t end, int worker) {
+        for (size_t c = begin; c < end; ++c) {
+            accumulate(maps[worker], (int)c);
+            nextOffsets[c + 1] = (int)maps[worker].usedSlots.size();
+        }
+    });
+    for (int c = 0; c < k; ++c) nextOffsets[c + 1] += nextOffsets[c];
+    nextTargets.resize(nextOffsets[k]);
+    nextWeights.resize(nextOffsets[k]);
+
+    parallelFor(k, 64, [&](size_t begin, size_t end, int worker) {
+        WeightMap& map = maps[worker];
+        for (size_t c = begin; c < end; ++c) {
+            accumulate(map, (int)c);
+            int out = nextOffsets[c];
+            for (int slot : map.usedSlots) {
+                nextTargets[out] = map.keys[slot];
+                nextWeights[out] = (float)map.values[slot];
+                out++;
+            }
+        }
+    });
+
+    offsets.swap(nextOffsets);
+    targets.swap(nextTargets);
+    weights.swap(nextWeights);
+    curOffsets = offsets.data();
+    curTargets = targets.data();
+    curWeights = weights.data();
+    return k;
+}
+
+void CommunityDetector::detect(const Graph& graph) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    clear();
+
+    const int n = (int)graph.nodes.size();
+    if (n == 0) return;
+
+    if (scratchSize < (size_t)n) {
+        assignment.reset(new std::atomic<int>[n]);
+        totals.reset(new std::atomic<double>[n]);
+        activeFlags.reset(new std::atomic<unsigned char>[n]);
+        scratchSize = n;
+    }
+    maps.resize(ThreadPool::instance().size());
+
+    buildBaseLevel(graph);
+
+    community.resize(n);
+    for (int v = 0; v < n; ++v) community[v] = v;
+
+    int levelSize = n;
+    double totalWeight = 0.0;
+    for (levels = 0; levels < maxLevels; ++levels) {
+        totalWeight = computeStrength(levelSize);
+        if (totalWeight <= 0.0) break;
+
+        if (moveNodes(levelSize, totalWeight, nullptr) == 0) break;
+
+        int k = aggregate(levelSize);
+        if (k == levelSize) break;
+
+        std::atomic<int>* assign = assignment.get();
+        parallelFor(n, 16384, [&](size_t begin, size_t end, int) {
+            for (size_t v = begin; v < end; ++v) {
+                community[v] = renumber[assign[community[v]].load(std::memory_order_relaxed)];
+            }
+        });
+        levelSize = k;
+    }
+
+    // Louvain cannot split a community once it has been aggregated, so give
+    // single nodes one last chance to move between the final communities.
+    if (levels > 0 && totalWeight > 0.0) {
+        useBaseLevel();
+        computeStrength(n);
+        moveNodes(n, totalWeight, community.data());
+        std::atomic<int>* assign = assignment.get();
+        for (int v = 0; v < n; ++v) community[v] = assign[v].load(std::memory_order_relaxed);
+        levelSize = aggregate(n);
+        if (levelSize < n) {
+            parallelFor(n, 16384, [&](size_t begin, size_t end, int) {
+                for (size_t v = begin; v < end; ++v) community[v] = renumber[community[v]];
+            });
+        }
+    }
+
+    // Modularity of the final partition, read off the last coarse level where
+    // every node is one community: Q = sum_C in(C)/2m - gamma * (tot(C)/2m)^2.
+    strength.resize(levelSize);
+    modularity = 0.0;
+    totalWeight = 0.0;
+    for (int c = 0; c < levelSize; ++c) {
+        double inside = 0.0, total = 0.0;
+        for (int i = curOffsets[c]; i < curOffsets[c + 1]; ++i) {
+            total += curWeights[i];
+            if (curTargets[i] == c) inside += curWeights[i];
+        }
+        strength[c] = total;
+        totalWeight += total;
+        modularity += inside;
+    }
+    if (totalWeight > 0.0) {
+        double expected = 0.0;
+        for (int c = 0; c < levelSize; ++c) expected += strength[c] * strength[c];
+        modularity = modularity / totalWeight - resolution * expected / (totalWeight * totalWeight);
+    }
+    else {
+        modularity = 0.0;
+    }
+
+    // Relabel so that id 0 is the largest community.
+    std::vector<int> sizes(levelSize, 0);
+    for (int v = 0; v < n; ++v) sizes[community[v]]++;
+    std::vector<int> order(levelSize);
+    for (int c = 0; c < levelSize; ++c) order[c] = c;
+    std::sort(order.begin(), order.end(), [&](int a, int b) {
+        return sizes[a] != sizes[b] ? sizes[a] > sizes[b] : a < b;
+    });
+    renumber.assign(levelSize, 0);
+    communitySizes.resize(levelSize);
+    for (int i = 0; i < levelSize; ++i) {
+        renumber[order[i]] = i;
+        communitySizes[i] = sizes[order[i]];
+    }
+    parallelFor(n, 16384, [&](size_t begin, size_t end, int) {
+        for (size_t v = begin; v < end; ++v) community[v] = renumber[community[v]];
+    });
+    communityCount = levelSize;
+
+    detectMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void CommunityDetector::buildNodeColors(std::vector<glm::vec3>& colors) const {
+    colors.resize(community.size());
+    parallelFor(community.size(), 16384, [&](size_t begin, size_t end, int) {
+        for (size_t v = begin; v < end; ++v) colors[v] = categoricalColor(community[v]);
+    });
+}
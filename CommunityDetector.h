@@ -0,0 +1,80 @@
+#pragma once
+#include "Graph.h"
+#include <atomic>
+#include <memory>
+#include <vector>
+
+// Multithreaded Louvain community detection over Graph::edges, using the
+// edge weights. Each level runs parallel local moving (asynchronous moves
+// with atomic community totals) followed by a parallel aggregation of the
+// communities into a coarser weighted graph.
+class CommunityDetector {
+public:
+    std::vector<int> community;        // per node, 0 = largest community
+    std::vector<int> communitySizes;
+    int communityCount = 0;
+    double modularity = 0.0;
+    int levels = 0;
+    double detectMs = 0.0;
+
+    float resolution = 1.0f;
+    int maxLevels = 10;
+    int maxSweeps = 32;
+    double minMovedFraction = 0.001;  // stop sweeping a level below this
+
+    bool valid() const { return !community.empty(); }
+
+    void clear();
+    void detect(const Graph& graph);
+
+    void buildNodeColors(std::vector<glm::vec3>& colors) const;
+
+private:
+    // Open-addressing community -> weight map, one per worker.
+    struct WeightMap {
+        std::vector<int> keys;
+        std::vector<double> values;
+        std::vector<int> usedSlots;
+        size_t mask = 0;
+
+        void reset(size_t expected);
+        void add(int key, double weight);
+        double get(int key) const;
+    };
+
+    // Weighted CSR of the input graph, kept for the final refinement pass.
+    std::vector<int> baseOffsets;
+    std::vector<int> baseTargets;
+    std::vector<float> baseWeights;
+
+    // Coarse levels; self entries hold intra-community weight.
+    std::vector<int> offsets;
+    std::vector<int> targets;
+    std::vector<float> weights;
+
+    std::vector<int> nextOffsets;
+    std::vector<int> nextTargets;
+    std::vector<float> nextWeights;
+
+    // The level being worked on: the base arrays or the coarse ones.
+    const int* curOffsets = nullptr;
+    const int* curTargets = nullptr;
+    const float* curWeights = nullptr;
+
+    std::vector<double> strength;
+    std::vector<int> renumber;
+    std::vector<int> members;
+    std::vector<int> memberOffsets;
+    std::vector<WeightMap> maps;
+
+    std::unique_ptr<std::atomic<int>[]> assignment;
+    std::unique_ptr<std::atomic<double>[]> totals;
+    std::unique_ptr<std::atomic<unsigned char>[]> activeFlags;
+    size_t scratchSize = 0;
+
+    void buildBaseLevel(const Graph& graph);
+    void useBaseLevel();
+    double computeStrength(int n);
+    int moveNodes(int n, double totalWeight, const int* initial);
+    int aggregate(int n);
+};
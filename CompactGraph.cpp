@@ -0,0 +1,456 @@
+#include "CompactGraph.h"
+#include "Graph.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+namespace {
+    const float maxRepulsionDistance = 15.0f;
+    // Where nodes are denser than Graph's cut-off assumes, repulsion is cut
+    // off after this many mean node spacings instead, and no node moves more
+    // than maxStepSpacings spacings per step.
+    const float repulsionSpacings = 2.5f;
+    const float maxStepSpacings = 1.0f;
+    const int cellBias = 1 << 20;
+
+    inline uint64_t packCell(int x, int y, int z) {
+        return ((uint64_t)(x + cellBias) << 42) | ((uint64_t)(y + cellBias) << 21) | (uint64_t)(z + cellBias);
+    }
+
+    // Clamped so that far-away (or non-finite) coordinates still map into
+    // the 21 bits per axis of packCell.
+    inline int cellCoord(float value, float cellSize) {
+        float cell = std::floor(value / cellSize);
+        if (!(cell > -(float)(cellBias - 2))) return -(cellBias - 2);
+        if (cell > (float)(cellBias - 2)) return cellBias - 2;
+        return (int)cell;
+    }
+
+    // Average distance between neighbouring nodes if they filled the
+    // bounding box evenly; at least extent / n so that flat or linear
+    // layouts do not collapse it to zero.
+    float meanSpacing(const glm::vec3& minPos, const glm::vec3& maxPos, size_t n, bool is3D) {
+        glm::vec3 extent = maxPos - minPos;
+        float largest = std::max(extent.x, std::max(extent.y, extent.z));
+        float spacing = is3D && extent.z > 0.0f
+            ? std::cbrt((double)extent.x * extent.y * extent.z / n)
+            : std::sqrt((double)extent.x * extent.y / n);
+        spacing = std::max(spacing, largest / n);
+        return std::isfinite(spacing) && spacing > 0.0f ? spacing : maxRepulsionDistance;
+    }
+
+    template <typename T>
+    void freeVector(std::vector<T>& v) {
+        std::vector<T>().swap(v);
+    }
+}
+
+unsigned int CompactGraph::nextSeed() const {
+    if (seed != 0) {
+        return seed;
+    }
+    std::random_device rd;
+    return rd();
+}
+
+void CompactGraph::clear() {
+    freeVector(positions);
+    freeVector(edgeIndices);
+    freeVector(weights);
+    releaseScratch();
+}
+
+void CompactGraph::addEdge(uint32_t from, uint32_t to, float weight) {
+    if (from == to || from >= positions.size() || to >= positions.size()) return;
+
+    if (weight != 1.0f && weights.empty()) {
+        weights.assign(edgeCount(), 1.0f);
+    }
+    edgeIndices.push_back(from);
+    edgeIndices.push_back(to);
+    if (!weights.empty()) weights.push_back(weight);
+}
+
+void CompactGraph::assign(const Graph& graph) {
+    clear();
+    is3D = graph.is3D;
+    repulsionStrength = graph.repulsionStrength;
+    attractionStrength = graph.attractionStrength;
+
+    positions.resize(graph.nodes.size());
+    for (size_t i = 0; i < graph.nodes.size(); ++i) {
+        positions[i] = graph.nodes[i].position;
+    }
+    edgeIndices.reserve(graph.edges.size() * 2);
+    for (const auto& edge : graph.edges) {
+        addEdge(edge.from, edge.to, edge.weight);
+    }
+}
+
+void CompactGraph::generateRandomGraph(int nodeCount, float averageDegree) {
+    clear();
+    if (nodeCount < 2) return;
+
+    std::mt19937 gen(nextSeed());
+    std::uniform_real_distribution<float> pos_dist(-1.0f, 1.0f);
+
+    positions.resize(nodeCount);
+    for (auto& pos : positions) {
+        pos.x = pos_dist(gen) * 5.0f;
+        pos.y = pos_dist(gen) * 5.0f;
+        pos.z = is3D ? pos_dist(gen) * 5.0f : 0.0f;
+    }
+
+    uint64_t maxEdges = (uint64_t)nodeCount * (nodeCount - 1) / 2;
+    uint64_t target = std::min(maxEdges, (uint64_t)((double)nodeCount * averageDegree * 0.5));
+
+    // Draw endpoint pairs, then sort + unique to drop duplicates; top up
+    // until the target is reached.
+    std::uniform_int_distribution<uint32_t> node_dist(0, nodeCount - 1);
+    std::vector<uint64_t> keys;
+    keys.reserve(target);
+    while (keys.size() < target) {
+        size_t missing = target - keys.size();
+        for (size_t i = 0; i < missing; ++i) {
+            uint32_t a = node_dist(gen);
+            uint32_t b = node_dist(gen);
+            if (a == b) continue;
+            if (a > b) std::swap(a, b);
+            keys.push_back(((uint64_t)a << 32) | b);
+        }
+        std::sort(keys.begin(), keys.end());
+        keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    }
+
+    edgeIndices.resize(keys.size() * 2);
+    for (size_t i = 0; i < keys.size(); ++i) {
+        edgeIndices[2 * i] = (uint32_t)(keys[i] >> 32);
+        edgeIndices[2 * i + 1] = (uint32_t)keys[i];
+    }
+}
+
+void CompactGraph::generateGridGraph(int rows, int cols) {
+    clear();
+
+    positions.resize((size_t)rows * cols);
+    edgeIndices.reserve((size_t)rows * cols * (is3D ? 6 : 4));
+
+    for (int r = 0; r < rows; ++r) {
+        for (int c = 0; c < cols; ++c) {
+            glm::vec3& pos = positions[(size_t)r * cols + c];
+            pos = glm::vec3(c * 1.5f - (cols - 1) * 0.75f,
+                r * 1.5f - (rows - 1) * 0.75f,
+                is3D ? (r + c) * 0.5f - (rows + cols) * 0.25f : 0.0f);
+        }
+    }
+    for (int r = 0; r < rows; ++r) {
+        for (int c = 0; c < cols; ++c) {
+            uint32_t current = (uint32_t)r * cols + c;
+
+            if (c < cols - 1) {
+                addEdge(current, current + 1);
+            }
+
+            if (r < rows - 1) {
+                addEdge(current, current + cols);
+            }
+
+            if (is3D && r < rows - 1 && c < cols - 1) {
+                addEdge(current, current + cols + 1);
+            }
+        }
+    }
+}
+
+void CompactGraph::generateRingGraph(int nodeCount) {
+    clear();
+    if (nodeCount < 1) return;
+
+    std::mt19937 gen(nextSeed());
+    std::normal_distribution<float> noise_dist(0.0f, 0.1f);
+
+    positions.resize(nodeCount);
+    for (int i = 0; i < nodeCount; ++i) {
+        float angle = 2.0f * M_PI * i / nodeCount;
+        glm::vec3 pos(cos(angle) * 5.0f, sin(angle) * 5.0f, is3D ? sin(angle * 2.0f) * 2.0f : 0.0f);
+
+        pos.x += noise_dist(gen);
+        pos.y += noise_dist(gen);
+        if (is3D) pos.z += noise_dist(gen);
+        positions[i] = pos;
+    }
+
+    edgeIndices.reserve((size_t)nodeCount * 2);
+    for (int i = 0; i < nodeCount; ++i) {
+        addEdge(i, (i + 1) % nodeCount);
+    }
+}
+
+void CompactGraph::generateStarGraph(int nodeCount) {
+    clear();
+    if (nodeCount < 1) return;
+
+    std::mt19937 gen(nextSeed());
+    std::uniform_real_distribution<float> angle_dist(0.0f, 2.0f * M_PI);
+    std::uniform_real_distribution<float> z_dist(-1.0f, 1.0f);
+
+    positions.resize(nodeCount);
+    positions[0] = glm::vec3(0.0f);
+    edgeIndices.reserve((size_t)(nodeCount - 1) * 2);
+
+    for (int i = 1; i < nodeCount; ++i) {
+        if (is3D) {
+            float z = z_dist(gen);
+            float r = sqrt(1.0f - z * z);
+            float angle = angle_dist(gen);
+            positions[i] = glm::vec3(r * cos(angle), r * sin(angle), z) * 5.0f;
+        }
+        else {
+            float angle = angle_dist(gen);
+            positions[i] = glm::vec3(cos(angle) * 5.0f, sin(angle) * 5.0f, 0.0f);
+        }
+        addEdge(0, i);
+    }
+}
+
+void CompactGraph::sortIntoCells(float cellSize) {
+    const size_t n = positions.size();
+    cellOrder.resize(n);
+    cellKeys.resize(n);
+
+    parallelFor(n, 4096, [&](size_t begin, size_t end, int) {
+        for (size_t i = begin; i < end; ++i) {
+            cellOrder[i] = (uint32_t)i;
+            cellKeys[i] = packCell(cellCoord(positions[i].x, cellSize),
+                cellCoord(positions[i].y, cellSize), cellCoord(positions[i].z, cellSize));
+        }
+    });
+
+    std::sort(cellOrder.begin(), cellOrder.end(), [&](uint32_t a, uint32_t b) {
+        return cellKeys[a] < cellKeys[b] || (cellKeys[a] == cellKeys[b] && a < b);
+    });
+
+    // Re-use cellKeys as the sorted key column for the range lookups, and
+    // keep a copy of the positions in the same order so a cell's nodes are
+    // contiguous in memory.
+    std::vector<uint64_t> sorted(n);
+    cellPositions.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        sorted[i] = cellKeys[cellOrder[i]];
+        cellPositions[i] = positions[cellOrder[i]];
+    }
+    cellKeys.swap(sorted);
+
+    cellStarts.clear();
+    for (size_t i = 0; i < n; ++i) {
+        if (i == 0 || cellKeys[i] != cellKeys[i - 1]) cellStarts.push_back((uint32_t)i);
+    }
+    cellStarts.push_back((uint32_t)n);
+}
+
+float CompactGraph::updateLayout(float deltaTime) {
+    const size_t n = positions.size();
+    if (n == 0) return 0.0f;
+
+    velocity.resize(n, glm::vec3(0.0f));
+    force.resize(n);
+
+    glm::vec3 minPos, maxPos;
+    bounds(minPos, maxPos);
+    const float spacing = meanSpacing(minPos, maxPos, n, is3D);
+    const float cutoff = std::min(maxRepulsionDistance, repulsionSpacings * spacing);
+    const float maxStep = maxStepSpacings * spacing;
+    const float cellSize = cutoff;
+    sortIntoCells(cellSize);
+
+    // One task per run of cells: the 27 neighbouring ranges are looked up
+    // once per cell, and each node's force is written by its own cell only.
+    const size_t cells = cellStarts.size() - 1;
+    parallelFor(cells, 64, [&](size_t begin, size_t end, int) {
+        std::pair<uint32_t, uint32_t> ranges[27];
+        for (size_t c = begin; c < end; ++c) {
+            const uint32_t first = cellStarts[c], last = cellStarts[c + 1];
+            const glm::vec3 anchor = cellPositions[first];
+            int cx = cellCoord(anchor.x, cellSize);
+            int cy = cellCoord(anchor.y, cellSize);
+            int cz = cellCoord(anchor.z, cellSize);
+
+            int rangeCount = 0;
+            for (int dx = -1; dx <= 1; ++dx) {
+                for (int dy = -1; dy <= 1; ++dy) {
+                    for (int dz = -1; dz <= 1; ++dz) {
+                        uint64_t key = packCell(cx + dx, cy + dy, cz + dz);
+                        auto range = std::equal_range(cellKeys.begin(), cellKeys.end(), key);
+                        if (range.first != range.second) {
+                            ranges[rangeCount++] = std::make_pair((uint32_t)(range.first - cellKeys.begin()),
+                                (uint32_t)(range.second - cellKeys.begin()));
+                        }
+                    }
+                }
+            }
+
+            for (uint32_t k = first; k < last; ++k) {
+                const glm::vec3 p = cellPositions[k];
+                glm::vec3 sum(0.0f);
+                for (int r = 0; r < rangeCount; ++r) {
+                    for (uint32_t other = ranges[r].first; other < ranges[r].second; ++other) {
+                        glm::vec3 diff = p - cellPositions[other];
+                        float distance = glm::length(diff);
+                        if (distance > 0.001f && distance < cutoff) {
+                            sum += diff / distance * (repulsionStrength / (distance * distance));
+                        }
+                    }
+                }
+                force[cellOrder[k]] = sum;
+            }
+        }
+    });
+
+    // Scattering into both endpoints would race, so attraction stays serial;
+    // it is a single streaming pass over the packed endpoint array.
+    const size_t m = edgeCount();
+    if (attractionPass) {
+        attractionPass(positions, force);
+    }
+    else {
+        for (size_t e = 0; e < m; ++e) {
+            uint32_t from = edgeIndices[2 * e];
+            uint32_t to = edgeIndices[2 * e + 1];
+            glm::vec3 diff = positions[to] - positions[from];
+            float distance = glm::length(diff);
+
+            if (distance > 0.001f) {
+                glm::vec3 f = diff / distance * (attractionStrength * distance * distance);
+                force[from] += f;
+                force[to] -= f;
+            }
+        }
+    }
+
+    // Per-worker sums, merged after the pass.
+    std::vector<LayoutStepStats> local(ThreadPool::instance().size());
+    parallelFor(n, 4096, [&](size_t begin, size_t end, int worker) {
+        LayoutStepStats stats = local[worker];
+        for (size_t i = begin; i < end; ++i) {
+            stats.totalForce += glm::length(force[i]);
+            velocity[i] += force[i] * deltaTime;
+            velocity[i] *= 0.9f;
+            glm::vec3 step = velocity[i] * deltaTime;
+            float stepLength = glm::length(step);
+            if (stepLength > maxStep) {
+                step *= maxStep / stepLength;
+                velocity[i] = step / deltaTime;
+                stepLength = maxStep;
+            }
+            positions[i] += step;
+            stats.maxDisplacement = std::max(stats.maxDisplacement, stepLength);
+            stats.meanDisplacement += stepLength;
+            stats.kineticEnergy += 0.5 * glm::dot(velocity[i], velocity[i]);
+        }
+        local[worker] = stats;
+    });
+
+    lastStepStats = LayoutStepStats();
+    for (const auto& stats : local) {
+        lastStepStats.kineticEnergy += stats.kineticEnergy;
+        lastStepStats.totalForce += stats.totalForce;
+        lastStepStats.maxDisplacement = std::max(lastStepStats.maxDisplacement, stats.maxDisplacement);
+        lastStepStats.meanDisplacement += stats.meanDisplacement;
+    }
+    lastStepStats.meanDisplacement /= n;
+    lastStepStats.nodes = n;
+    return lastStepStats.maxDisplacement;
+}
+
+void CompactGraph::releaseScratch() {
+    freeVector(velocity);
+    freeVector(force);
+    freeVector(cellKeys);
+    freeVector(cellOrder);
+    freeVector(cellStarts);
+    freeVector(cellPositions);
+}
+
+void CompactGraph::bounds(glm::vec3& minPos, glm::vec3& maxPos) const {
+    minPos = maxPos = glm::vec3(0.0f);
+    if (positions.empty()) return;
+
+    int workers = ThreadPool::instance().size();
+    std::vector<glm::vec3> localMin(workers, positions[0]);
+    std::vector<glm::vec3> localMax(workers, positions[0]);
+    parallelFor(positions.size(), 16384, [&](size_t begin, size_t end, int worker) {
+        glm::vec3 lo = localMin[worker];
+        glm::vec3 hi = localMax[worker];
+        for (size_t i = begin; i < end; ++i) {
+            lo = glm::min(lo, positions[i]);
+            hi = glm::max(hi, positions[i]);
+        }
+        localMin[worker] = lo;
+        localMax[worker] = hi;
+    });
+
+    minPos = localMin[0];
+    maxPos = localMax[0];
+    for (int w = 1; w < workers; ++w) {
+        minPos = glm::min(minPos, localMin[w]);
+        maxPos = glm::max(maxPos, localMax[w]);
+    }
+}
+
+void CompactGraph::normalizePositions() {
+    if (positions.empty()) return;
+
+    glm::vec3 min_pos, max_pos;
+    bounds(min_pos, max_pos);
+
+    glm::vec3 center = (min_pos + max_pos) * 0.5f;
+    glm::vec3 size = max_pos - min_pos;
+    float max_size = glm::max(glm::max(size.x, size.y), size.z);
+
+    if (max_size > 0.001f) {
+        float scale = 5.0f / max_size;
+        parallelFor(positions.size(), 16384, [&](size_t begin, size_t end, int) {
+            for (size_t i = begin; i < end; ++i) {
+                positions[i] = (positions[i] - center) * scale;
+            }
+        });
+    }
+}
+
+void CompactGraph::quantizePositions(std::vector<uint16_t>& packed, glm::vec3& origin, glm::vec3& extent) const {
+    glm::vec3 maxPos;
+    bounds(origin, maxPos);
+    extent = maxPos - origin;
+
+    // Flat axes (2D mode) quantize to 0 instead of dividing by zero.
+    glm::vec3 scale(extent.x > 0.0f ? 65535.0f / extent.x : 0.0f,
+        extent.y > 0.0f ? 65535.0f / extent.y : 0.0f,
+        extent.z > 0.0f ? 65535.0f / extent.z : 0.0f);
+
+    packed.resize(positions.size() * 3);
+    parallelFor(positions.size(), 16384, [&](size_t begin, size_t end, int) {
+        for (size_t i = begin; i < end; ++i) {
+            glm::vec3 q = (positions[i] - origin) * scale + glm::vec3(0.5f);
+            packed[3 * i] = (uint16_t)glm::clamp(q.x, 0.0f, 65535.0f);
+            packed[3 * i + 1] = (uint16_t)glm::clamp(q.y, 0.0f, 65535.0f);
+            packed[3 * i + 2] = (uint16_t)glm::clamp(q.z, 0.0f, 65535.0f);
+        }
+    });
+}
+
+size_t CompactGraph::storageBytes() const {
+    return positions.capacity() * sizeof(glm::vec3)
+        + edgeIndices.capacity() * sizeof(uint32_t)
+        + weights.capacity() * sizeof(float);
+}
+
+size_t CompactGraph::scratchBytes() const {
+    return (velocity.capacity() + force.capacity()) * sizeof(glm::vec3)
+        + cellKeys.capacity() * sizeof(uint64_t)
+        + (cellOrder.capacity() + cellStarts.capacity()) * sizeof(uint32_t)
+        + cellPositions.capacity() * sizeof(glm::vec3);
+}
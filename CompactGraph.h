@@ -0,0 +1,80 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include <glm/glm.hpp>
+#include "LayoutStepStats.h"
+
+class Graph;
+
+// Memory-lean graph storage for graphs too large for Graph's per-node and
+// per-edge structs (40 and 12 bytes). Positions are a flat float3 array,
+// edges are packed 32-bit endpoint pairs laid out exactly like the renderer's
+// element buffer, and weights are only stored when they are not all 1.
+// Velocity and force exist only while the layout is running.
+class CompactGraph {
+public:
+    std::vector<glm::vec3> positions;
+    std::vector<uint32_t> edgeIndices;   // from0, to0, from1, to1, ...
+    std::vector<float> weights;          // empty = every edge has weight 1
+
+    bool is3D = true;
+    float repulsionStrength = 100.0f;
+    float attractionStrength = 0.1f;
+    unsigned int seed = 0;  // 0 = non-deterministic (std::random_device)
+
+    // When set, updateLayout calls this instead of walking edgeIndices; it
+    // must add each node's attraction into force[node]. Used for edges that
+    // are streamed from disk (OutOfCoreLayout).
+    std::function<void(const std::vector<glm::vec3>& positions, std::vector<glm::vec3>& force)> attractionPass;
+
+    size_t nodeCount() const { return positions.size(); }
+    size_t edgeCount() const { return edgeIndices.size() / 2; }
+    float weight(size_t edge) const { return weights.empty() ? 1.0f : weights[edge]; }
+
+    void clear();
+
+    // Same shapes and coordinate conventions as Graph's generators. The
+    // random graph draws nodeCount * averageDegree / 2 distinct edges instead
+    // of testing every pair, so it scales to tens of millions of edges.
+    void generateRandomGraph(int nodeCount, float averageDegree);
+    void generateGridGraph(int rows, int cols);
+    void generateRingGraph(int nodeCount);
+    void generateStarGraph(int nodeCount);
+
+    void addEdge(uint32_t from, uint32_t to, float weight = 1.0f);
+    void assign(const Graph& graph);
+
+    // Graph::updateLayout's force model with two changes that keep a step
+    // O(n) however densely the nodes start out (the generators and
+    // normalizePositions put everything in a +-5 box). Repulsion is cut off
+    // at Graph's 15 units or at 2.5 mean node spacings (taken from the
+    // bounding box), whichever is shorter, and evaluated over a uniform grid
+    // of that cell size; and a node moves at most one mean spacing per
+    // step, so overshooting d^2 attraction cannot diverge. Repulsion runs on
+    // the thread pool; the attraction pass is a serial sweep over the edges.
+    float updateLayout(float deltaTime);  // returns the largest node displacement
+    LayoutStepStats lastStepStats;        // of the last updateLayout call
+    void normalizePositions();
+    void releaseScratch();
+
+    void bounds(glm::vec3& minPos, glm::vec3& maxPos) const;
+
+    // 16-bit unsigned normalized x, y, z per node relative to the bounding
+    // box: position = origin + q / 65535 * extent.
+    void quantizePositions(std::vector<uint16_t>& packed, glm::vec3& origin, glm::vec3& extent) const;
+
+    size_t storageBytes() const;
+    size_t scratchBytes() const;
+
+private:
+    std::vector<glm::vec3> velocity;
+    std::vector<glm::vec3> force;
+    std::vector<uint64_t> cellKeys;
+    std::vector<uint32_t> cellOrder;
+    std::vector<uint32_t> cellStarts;        // first sorted index of each occupied cell, then n
+    std::vector<glm::vec3> cellPositions;    // positions in cellOrder
+
+    unsigned int nextSeed() const;
+    void sortIntoCells(float cellSize);
+};
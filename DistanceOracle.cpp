@@ -0,0 +1,337 @@
+#include "DistanceOracle.h"
+#include "Graph.h"
+#include "CompactGraph.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <queue>
+#include <random>
+
+namespace {
+    typedef std::chrono::steady_clock Clock;
+
+    double elapsedMs(Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    const float unreachable = std::numeric_limits<float>::infinity();
+
+    struct HeapEntry {
+        double key;
+        double distance;
+        uint32_t node;
+
+        bool operator>(const HeapEntry& other) const { return key > other.key; }
+    };
+    typedef std::priority_queue<HeapEntry, std::vector<HeapEntry>, std::greater<HeapEntry>> MinHeap;
+}
+
+void DistanceOracle::clear() {
+    offsets.clear();
+    neighbors.clear();
+    weights.clear();
+    landmarkNodes.clear();
+    distance.clear();
+    for (int side = 0; side < 2; ++side) {
+        stamp[side].clear();
+        best[side].clear();
+        parent[side].clear();
+    }
+    potentialStamp.clear();
+    potentialCache.clear();
+    query = 0;
+    lastQuery = QueryStats();
+}
+
+template <typename EndpointsOf, typename WeightOf>
+void DistanceOracle::buildAdjacency(size_t n, size_t m, const EndpointsOf& endpoints, const WeightOf& weightOf) {
+    offsets.assign(n + 1, 0);
+    bool unitWeights = true;
+    uint32_t from, to;
+    for (size_t e = 0; e < m; ++e) {
+        endpoints(e, from, to);
+        if (from >= n || to >= n || from == to) continue;
+        offsets[from + 1]++;
+        offsets[to + 1]++;
+        if (weightOf(e) != 1.0f) unitWeights = false;
+    }
+    for (size_t i = 0; i < n; ++i) offsets[i + 1] += offsets[i];
+
+    neighbors.resize(offsets[n]);
+    if (!unitWeights) weights.resize(offsets[n]);
+    std::vector<size_t> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t e = 0; e < m; ++e) {
+        endpoints(e, from, to);
+        if (from >= n || to >= n || from == to) continue;
+        size_t a = fill[from]++, b = fill[to]++;
+        neighbors[a] = to;
+        neighbors[b] = from;
+        if (!unitWeights) {
+            // Dijkstra needs positive lengths.
+            float w = std::max(weightOf(e), 1e-6f);
+            weights[a] = w;
+            weights[b] = w;
+        }
+    }
+}
+
+void DistanceOracle::build(const Graph& graph) {
+    Clock::time_point start = Clock::now();
+    clear();
+    const std::vector<Edge>& edges = graph.edges;
+    buildAdjacency(graph.nodes.size(), edges.size(),
+        [&](size_t e, uint32_t& from, uint32_t& to) { from = (uint32_t)edges[e].from; to = (uint32_t)edges[e].to; },
+        [&](size_t e) { return edges[e].weight; });
+
+    std::vector<glm::vec3> positions(graph.nodes.size());
+    for (size_t i = 0; i < positions.size(); ++i) positions[i] = graph.nodes[i].position;
+    chooseLandmarks(positions);
+    computeLandmarkDistances();
+    buildMs = elapsedMs(start);
+}
+
+void DistanceOracle::build(const CompactGraph& graph) {
+    Clock::time_point start = Clock::now();
+    clear();
+    buildAdjacency(graph.nodeCount(), graph.edgeCount(),
+        [&](size_t e, uint32_t& from, uint32_t& to) { from = graph.edgeIndices[2 * e]; to = graph.edgeIndices[2 * e + 1]; },
+        [&](size_t e) { return graph.weight(e); });
+    chooseLandmarks(graph.positions);
+    computeLandmarkDistances();
+    buildMs = elapsedMs(start);
+}
+
+void DistanceOracle::chooseLandmarks(const std::vector<glm::vec3>& positions) {
+    const size_t n = positions.size();
+    const size_t k = std::min(n, (size_t)std::max(1, landmarkCount));
+    if (k == 0) return;
+
+    glm::vec3 centroid(0.0f);
+    for (const auto& p : positions) centroid += p;
+    centroid /= (float)n;
+
+    const float twoPi = 6.28318530718f;
+    std::vector<float> farthest(k, -1.0f);
+    std::vector<uint32_t> chosen(k, 0);
+    for (size_t i = 0; i < n; ++i) {
+        float dx = positions[i].x - centroid.x, dy = positions[i].y - centroid.y;
+        float angle = std::atan2(dy, dx) + 0.5f * twoPi;
+        size_t sector = std::min(k - 1, (size_t)(angle / twoPi * k));
+        float r = dx * dx + dy * dy;
+        if (r > farthest[sector]) {
+            farthest[sector] = r;
+            chosen[sector] = (uint32_t)i;
+        }
+    }
+    for (size_t s = 0; s < k; ++s) {
+        if (farthest[s] >= 0.0f) landmarkNodes.push_back(chosen[s]);
+    }
+
+    // Empty sectors (or a layout that has not spread yet): fill up with
+    // random distinct nodes.
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<uint32_t> pick(0, (uint32_t)(n - 1));
+    std::vector<bool> used(n, false);
+    for (uint32_t v : landmarkNodes) used[v] = true;
+    for (size_t attempt = 0; landmarkNodes.size() < k && attempt < 16 * k; ++attempt) {
+        uint32_t v = pick(rng);
+        if (!used[v]) {
+            used[v] = true;
+            landmarkNodes.push_back(v);
+        }
+    }
+}
+
+void DistanceOracle::computeLandmarkDistances() {
+    const size_t n = nodeCount();
+    const size_t k = landmarkNodes.size();
+    std::vector<std::vector<float>> rows(k);
+
+    // One landmark per task; each search only touches its own row.
+    parallelFor(k, 1, [&](size_t begin, size_t end, int) {
+        for (size_t l = begin; l < end; ++l) {
+            std::vector<float>& row = rows[l];
+            row.assign(n, unreachable);
+            const uint32_t source = landmarkNodes[l];
+            row[source] = 0.0f;
+
+            if (weights.empty()) {
+                std::vector<uint32_t> queue(n);
+                size_t head = 0, tail = 0;
+                queue[tail++] = source;
+                while (head < tail) {
+                    uint32_t v = queue[head++];
+                    float next = row[v] + 1.0f;
+                    for (size_t e = offsets[v]; e < offsets[v + 1]; ++e) {
+                        uint32_t w = neighbors[e];
+                        if (row[w] == unreachable) {
+                            row[w] = next;
+                            queue[tail++] = w;
+                        }
+                    }
+                }
+            }
+            else {
+                // Keyed by the float distance itself: half the heap traffic of
+                // the query heaps.
+                typedef std::pair<float, uint32_t> Entry;
+                std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> heap;
+                heap.push(Entry(0.0f, source));
+                while (!heap.empty()) {
+                    const Entry top = heap.top();
+                    heap.pop();
+                    if (top.first > row[top.second]) continue;
+                    for (size_t e = offsets[top.second]; e < offsets[top.second + 1]; ++e) {
+                        uint32_t w = neighbors[e];
+                        float candidate = top.first + weights[e];
+                        if (candidate < row[w]) {
+                            row[w] = candidate;
+                            heap.push(Entry(candidate, w));
+                        }
+                    }
+                }
+            }
+        }
+    });
+
+    distance.resize(n * k);
+    parallelFor(n, 16384, [&](size_t begin, size_t end, int) {
+        for (size_t v = begin; v < end; ++v) {
+            for (size_t l = 0; l < k; ++l) distance[v * k + l] = rows[l][v];
+        }
+    });
+}
+
+bool DistanceOracle::estimate(uint32_t source, uint32_t target, float& lower, float& upper) const {
+    lower = 0.0f;
+    upper = unreachable;
+    const size_t n = nodeCount();
+    if (!valid() || source >= n || target >= n) return false;
+
+    const size_t k = landmarkNodes.size();
+    const float* ds = &distance[source * k];
+    const float* dt = &distance[target * k];
+    for (size_t l = 0; l < k; ++l) {
+        const bool reachS = ds[l] != unreachable, reachT = dt[l] != unreachable;
+        if (reachS != reachT) return false;   // different components
+        if (!reachS) continue;
+        lower = std::max(lower, std::abs(ds[l] - dt[l]));
+        upper = std::min(upper, ds[l] + dt[l]);
+    }
+    return true;
+}
+
+float DistanceOracle::lowerBound(uint32_t a, uint32_t b) const {
+    const size_t k = landmarkNodes.size();
+    const float* da = &distance[a * k];
+    const float* db = &distance[b * k];
+    float bound = 0.0f;
+    for (size_t l = 0; l < k; ++l) {
+        if (da[l] == unreachable || db[l] == unreachable) continue;
+        bound = std::max(bound, std::abs(da[l] - db[l]));
+    }
+    return bound;
+}
+
+bool DistanceOracle::shortestPath(uint32_t source, uint32_t target, std::vector<uint32_t>& path) {
+    Clock::time_point start = Clock::now();
+    path.clear();
+    lastQuery = QueryStats();
+    float lower, upper;
+    if (!estimate(source, target, lower, upper)) {
+        lastQuery.milliseconds = elapsedMs(start);
+        return false;
+    }
+
+    const size_t n = nodeCount();
+    for (int side = 0; side < 2; ++side) {
+        if (stamp[side].size() != n) {
+            stamp[side].assign(n, 0);
+            best[side].resize(n);
+            parent[side].resize(n);
+        }
+    }
+    if (potentialStamp.size() != n) {
+        potentialStamp.assign(n, 0);
+        potentialCache.resize(n);
+    }
+    if (++query == 0) {
+        // Stamp wrap-around: start over with clean arrays.
+        for (int side = 0; side < 2; ++side) std::fill(stamp[side].begin(), stamp[side].end(), 0);
+        std::fill(potentialStamp.begin(), potentialStamp.end(), 0);
+        query = 1;
+    }
+
+    // p(v) = (lower bound to target - lower bound from source) / 2 is
+    // consistent for both directions: the forward search orders by
+    // d(s,v) + p(v), the reverse one by d(v,t) - p(v), and the shortest path
+    // is found once the two heap tops add up to the best meeting length.
+    auto potential = [&](uint32_t v) {
+        if (potentialStamp[v] != query) {
+            potentialStamp[v] = query;
+            potentialCache[v] = 0.5f * (lowerBound(v, target) - lowerBound(source, v));
+        }
+        return (double)potentialCache[v];
+    };
+    auto label = [&](int side, uint32_t v, double d, uint32_t from) {
+        stamp[side][v] = query;
+        best[side][v] = d;
+        parent[side][v] = from;
+    };
+    auto reached = [&](int side, uint32_t v) { return stamp[side][v] == query; };
+
+    MinHeap heap[2];
+    label(0, source, 0.0, source);
+    label(1, target, 0.0, target);
+    heap[0].push({ potential(source), 0.0, source });
+    heap[1].push({ -potential(target), 0.0, target });
+
+    double shortest = std::numeric_limits<double>::infinity();
+    uint32_t meeting = source;
+    if (source == target) shortest = 0.0;
+
+    while (true) {
+        for (int side = 0; side < 2; ++side) {
+            while (!heap[side].empty() && heap[side].top().distance > best[side][heap[side].top().node]) heap[side].pop();
+        }
+        if (heap[0].empty() || heap[1].empty()) break;
+        if (heap[0].top().key + heap[1].top().key >= shortest) break;
+
+        const int side = heap[0].size() <= heap[1].size() ? 0 : 1;
+        const HeapEntry top = heap[side].top();
+        heap[side].pop();
+        ++lastQuery.settled;
+
+        const uint32_t u = top.node;
+        for (size_t e = offsets[u]; e < offsets[u + 1]; ++e) {
+            const uint32_t v = neighbors[e];
+            const double candidate = top.distance + (weights.empty() ? 1.0 : (double)weights[e]);
+            if (reached(side, v) && candidate >= best[side][v]) continue;
+            label(side, v, candidate, u);
+            heap[side].push({ candidate + (side == 0 ? potential(v) : -potential(v)), candidate, v });
+            if (reached(1 - side, v) && candidate + best[1 - side][v] < shortest) {
+                shortest = candidate + best[1 - side][v];
+                meeting = v;
+            }
+        }
+    }
+
+    if (shortest == std::numeric_limits<double>::infinity()) {
+        lastQuery.milliseconds = elapsedMs(start);
+        return false;
+    }
+    for (uint32_t v = meeting; v != source; v = parent[0][v]) path.push_back(v);
+    path.push_back(source);
+    std::reverse(path.begin(), path.end());
+    for (uint32_t v = meeting; v != target; ) {
+        v = parent[1][v];
+        path.push_back(v);
+    }
+
+    lastQuery.length = shortest;
+    lastQuery.hops = path.size() - 1;
+    lastQuery.milliseconds = elapsedMs(start);
+    return true;
+}
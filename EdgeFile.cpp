@@ -0,0 +1,356 @@
+#include "EdgeFile.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    const char edgeFileMagic[8] = { 'T', 'G', 'E', 'D', 'G', 'E', '0', '1' };
+
+    // Buffered reader for text or binary edge lists.
+    class EdgeListReader {
+    public:
+        std::string error;
+
+        ~EdgeListReader() {
+            if (file) std::fclose(file);
+        }
+
+        bool open(const std::string& path) {
+            binary = path.size() > 4 && path.compare(path.size() - 4, 4, ".bin") == 0;
+            file = std::fopen(path.c_str(), "rb");
+            if (!file) error = "cannot open " + path;
+            buffer.resize(1 << 20);
+            return file != nullptr;
+        }
+
+        void rewind() {
+            std::fseek(file, 0, SEEK_SET);
+            position = length = 0;
+        }
+
+        bool next(uint32_t& from, uint32_t& to) {
+            if (binary) {
+                uint32_t pair[2];
+                unsigned char* p = reinterpret_cast<unsigned char*>(pair);
+                for (size_t k = 0; k < sizeof(pair); ++k) {
+                    int c = get();
+                    if (c == EOF) {
+                        if (k != 0) error = "truncated binary edge list";
+                        return false;
+                    }
+                    p[k] = (unsigned char)c;
+                }
+                from = pair[0];
+                to = pair[1];
+                return true;
+            }
+
+            while (true) {
+                int c = get();
+                while (c == ' ' || c == '\t' || c == '\r' || c == '\n') c = get();
+                if (c == EOF) return false;
+                if (c == '#' || c == '%') {
+                    skipLine();
+                    continue;
+                }
+                if (!parseNumber(c, from)) return false;
+                c = get();
+                while (c == ' ' || c == '\t' || c == ',') c = get();
+                if (!parseNumber(c, to)) return false;
+                skipLine();   // an optional weight column is ignored
+                return true;
+            }
+        }
+
+    private:
+        int get() {
+            if (position == length) {
+                length = std::fread(buffer.data(), 1, buffer.size(), file);
+                position = 0;
+                if (length == 0) return EOF;
+            }
+            return (unsigned char)buffer[position++];
+        }
+
+        void skipLine() {
+            int c = get();
+            while (c != '\n' && c != EOF) c = get();
+        }
+
+        // Parses digits starting with `c`; consumes the character after them.
+        bool parseNumber(int c, uint32_t& value) {
+            if (c < '0' || c > '9') {
+                error = "malformed edge list line";
+                return false;
+            }
+            uint64_t v = 0;
+            while (c >= '0' && c <= '9') {
+                v = v * 10 + (uint64_t)(c - '0');
+                if (v > std::numeric_limits<uint32_t>::max()) {
+                    error = "node id does not fit in 32 bits";
+                    return false;
+                }
+                c = get();
+            }
+            value = (uint32_t)v;
+            if (c == '\n') {
+                --position;   // leave the newline for the caller
+            }
+            return true;
+        }
+
+        FILE* file = nullptr;
+        bool binary = false;
+        std::vector<char> buffer;
+        size_t position = 0;
+        size_t length = 0;
+    };
+}
+
+EdgeFile::EdgeFile() {
+    std::memset(&header, 0, sizeof(header));
+}
+
+EdgeFile::~EdgeFile() {
+    close();
+}
+
+bool EdgeFile::build(const std::string& edgeListPath, const std::string& path, size_t memoryBudget, std::string& error) {
+    EdgeListReader reader;
+    if (!reader.open(edgeListPath)) {
+        error = reader.error;
+        return false;
+    }
+
+    // Pass 1: degrees.
+    std::vector<uint64_t> degree;
+    uint64_t edgeCount = 0;
+    uint32_t from, to;
+    while (reader.next(from, to)) {
+        if (from == to) continue;
+        size_t needed = (size_t)std::max(from, to) + 1;
+        if (degree.size() < needed) degree.resize(std::max(needed, degree.size() + degree.size() / 2), 0);
+        degree[from]++;
+        degree[to]++;
+        ++edgeCount;
+    }
+    if (!reader.error.empty()) {
+        error = reader.error;
+        return false;
+    }
+    while (!degree.empty() && degree.back() == 0) degree.pop_back();
+    const size_t n = degree.size();
+    if (n > std::numeric_limits<uint32_t>::max()) {
+        error = "too many nodes";
+        return false;
+    }
+
+    std::vector<uint64_t> offsets(n + 1, 0);
+    for (size_t i = 0; i < n; ++i) offsets[i + 1] = offsets[i] + degree[i];
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        error = "cannot create " + path;
+        return false;
+    }
+    Header header;
+    std::memcpy(header.magic, edgeFileMagic, sizeof(header.magic));
+    header.nodeCount = n;
+    header.edgeCount = edgeCount;
+    header.reserved = 0;
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(offsets.data()), offsets.size() * sizeof(uint64_t));
+    const uint64_t neighborStart = sizeof(Header) + offsets.size() * sizeof(uint64_t);
+
+    // Later passes: fill the lists of a window of nodes that fits in the
+    // budget, write it, move on. degree[] is reused as the fill cursor.
+    const uint64_t budgetEntries = std::max<uint64_t>(1, memoryBudget / sizeof(uint32_t));
+    std::vector<uint32_t> window;
+    size_t first = 0;
+    int passes = 0;
+    while (first < n) {
+        size_t end = first + 1;
+        while (end < n && offsets[end + 1] - offsets[first] <= budgetEntries) ++end;
+        const uint64_t base = offsets[first];
+        window.resize(offsets[end] - base);
+        for (size_t i = first; i < end; ++i) degree[i] = offsets[i] - base;
+
+        reader.rewind();
+        while (reader.next(from, to)) {
+            if (from == to) continue;
+            if (from >= first && from < end) {
+                if (degree[from] >= offsets[from + 1] - base) {
+                    error = "edge list changed while building";
+                    return false;
+                }
+                window[degree[from]++] = to;
+            }
+            if (to >= first && to < end) {
+                if (degree[to] >= offsets[to + 1] - base) {
+                    error = "edge list changed while building";
+                    return false;
+                }
+                window[degree[to]++] = from;
+            }
+        }
+        if (!reader.error.empty()) {
+            error = reader.error;
+            return false;
+        }
+
+        out.seekp((std::streamoff)(neighborStart + base * sizeof(uint32_t)));
+        out.write(reinterpret_cast<const char*>(window.data()), window.size() * sizeof(uint32_t));
+        if (!out.good()) {
+            error = "write failed: " + path;
+            return false;
+        }
+        first = end;
+        ++passes;
+    }
+
+    out.close();
+    if (!out.good()) {
+        error = "write failed: " + path;
+        return false;
+    }
+    std::cout << "Edge file written: " << path << " (" << n << " nodes, " << edgeCount << " edges, "
+              << passes + 1 << " passes over the input)" << std::endl;
+    return true;
+}
+
+bool EdgeFile::open(const std::string& path) {
+    close();
+    error.clear();
+#ifdef _WIN32
+    error = "edge files are not supported on Windows";
+    return false;
+#else
+    fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error = "cannot open " + path + ": " + std::strerror(errno);
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(Header)) {
+        error = "not an edge file: " + path;
+        close();
+        return false;
+    }
+    const uint64_t fileBytes = (uint64_t)info.st_size;
+
+    if (pread(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header)
+        || std::memcmp(header.magic, edgeFileMagic, sizeof(header.magic)) != 0
+        || header.nodeCount > std::numeric_limits<uint32_t>::max()
+        || sizeof(Header) + (header.nodeCount + 1) * sizeof(uint64_t) > fileBytes) {
+        error = "not an edge file: " + path;
+        close();
+        return false;
+    }
+
+    const size_t n = (size_t)header.nodeCount;
+    nodeOffsets.resize(n + 1);
+    char* dst = reinterpret_cast<char*>(nodeOffsets.data());
+    size_t remaining = nodeOffsets.size() * sizeof(uint64_t);
+    off_t at = sizeof(Header);
+    while (remaining > 0) {
+        ssize_t got = pread(fd, dst, remaining, at);
+        if (got <= 0) {
+            error = "cannot read " + path;
+            close();
+            return false;
+        }
+        dst += got;
+        at += got;
+        remaining -= (size_t)got;
+    }
+
+    const uint64_t neighborStart = sizeof(Header) + nodeOffsets.size() * sizeof(uint64_t);
+    bool valid = nodeOffsets[0] == 0 && nodeOffsets[n] == 2 * header.edgeCount
+        && neighborStart + nodeOffsets[n] * sizeof(uint32_t) <= fileBytes;
+    for (size_t i = 0; i < n && valid; ++i) valid = nodeOffsets[i] <= nodeOffsets[i + 1];
+    if (!valid) {
+        error = "corrupt edge file: " + path;
+        close();
+        return false;
+    }
+
+    mappedBytes = (size_t)fileBytes;
+    void* address = mmap(nullptr, mappedBytes, PROT_READ, MAP_SHARED, fd, 0);
+    if (address == MAP_FAILED) {
+        error = std::string("mmap failed: ") + std::strerror(errno);
+        mappedBytes = 0;
+        close();
+        return false;
+    }
+    mapping = address;
+    madvise(mapping, mappedBytes, MADV_SEQUENTIAL);
+    neighborData = reinterpret_cast<const uint32_t*>(static_cast<const char*>(mapping) + neighborStart);
+
+    const uint64_t blockEntries = std::max<uint64_t>(1, blockBytes / sizeof(uint32_t));
+    size_t first = 0;
+    while (first < n) {
+        size_t end = first + 1;
+        while (end < n && nodeOffsets[end + 1] - nodeOffsets[first] <= blockEntries) ++end;
+        Block block;
+        block.firstNode = (uint32_t)first;
+        block.endNode = (uint32_t)end;
+        block.firstEntry = nodeOffsets[first];
+        block.endEntry = nodeOffsets[end];
+        blockList.push_back(block);
+        first = end;
+    }
+    return true;
+#endif
+}
+
+void EdgeFile::close() {
+#ifndef _WIN32
+    if (mapping) munmap(mapping, mappedBytes);
+    if (fd >= 0) ::close(fd);
+#endif
+    mapping = nullptr;
+    mappedBytes = 0;
+    fd = -1;
+    neighborData = nullptr;
+    nodeOffsets.clear();
+    blockList.clear();
+    std::memset(&header, 0, sizeof(header));
+}
+
+void EdgeFile::advise(size_t block, int advice) const {
+#ifndef _WIN32
+    if (!mapping || block >= blockList.size()) return;
+    static const size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+    const char* base = static_cast<const char*>(mapping);
+    size_t begin = (size_t)(reinterpret_cast<const char*>(neighborData + blockList[block].firstEntry) - base);
+    size_t end = (size_t)(reinterpret_cast<const char*>(neighborData + blockList[block].endEntry) - base);
+    begin -= begin % pageSize;
+    if (end > begin) madvise(const_cast<char*>(base) + begin, end - begin, advice);
+#else
+    (void)block;
+    (void)advice;
+#endif
+}
+
+void EdgeFile::prefetch(size_t block) const {
+#ifndef _WIN32
+    advise(block, MADV_WILLNEED);
+#endif
+}
+
+void EdgeFile::release(size_t block) const {
+#ifndef _WIN32
+    advise(block, MADV_DONTNEED);
+#endif
+}
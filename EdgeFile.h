@@ -0,0 +1,77 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Adjacency lists on disk for graphs whose edges do not fit in memory.
+// The file is a CSR: a header, nodeCount + 1 64-bit offsets, then every
+// node's neighbours as 32-bit ids, node by node. Each undirected edge is
+// listed under both endpoints, which costs the same 8 bytes per edge as a
+// pair list but lets a pass over one node's list update only that node.
+//
+// open() memory-maps the file and keeps only the offsets resident. The
+// neighbour array is cut into blocks of about blockBytes along node
+// boundaries; readers walk the blocks in order, prefetch() the next few and
+// release() the ones they are done with, so the process never holds more
+// than a few blocks of the file.
+class EdgeFile {
+public:
+    struct Header {
+        char magic[8];
+        uint64_t nodeCount;
+        uint64_t edgeCount;   // undirected; the file holds 2 * edgeCount entries
+        uint64_t reserved;
+    };
+
+    struct Block {
+        uint32_t firstNode;
+        uint32_t endNode;      // one past the last node
+        uint64_t firstEntry;
+        uint64_t endEntry;
+    };
+
+    size_t blockBytes = 64u << 20;
+
+    EdgeFile();
+    ~EdgeFile();
+    EdgeFile(const EdgeFile&) = delete;
+    EdgeFile& operator=(const EdgeFile&) = delete;
+
+    // Converts an edge list into an edge file without holding the edges in
+    // memory: one pass counts degrees, then each pass over the input fills
+    // as many nodes' lists as fit in memoryBudget bytes and writes them out.
+    // The input is text with one "from to" pair per line (lines starting
+    // with # or % are skipped), or raw little-endian uint32 pairs if the
+    // name ends in ".bin". Self-loops are dropped; duplicates are kept.
+    static bool build(const std::string& edgeListPath, const std::string& path, size_t memoryBudget, std::string& error);
+
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const { return mapping != nullptr; }
+
+    uint64_t nodeCount() const { return header.nodeCount; }
+    uint64_t edgeCount() const { return header.edgeCount; }
+    const std::vector<uint64_t>& offsets() const { return nodeOffsets; }
+    const std::vector<Block>& blocks() const { return blockList; }
+    uint64_t neighborBytes() const { return nodeOffsets.empty() ? 0 : nodeOffsets.back() * sizeof(uint32_t); }
+
+    // Entry k of the neighbour array (k as in offsets()).
+    const uint32_t* neighbors() const { return neighborData; }
+
+    // Read-ahead hint for a block, and drop of its pages from this process.
+    void prefetch(size_t block) const;
+    void release(size_t block) const;
+
+    std::string error;
+
+private:
+    void advise(size_t block, int advice) const;
+
+    Header header;
+    std::vector<uint64_t> nodeOffsets;
+    std::vector<Block> blockList;
+    int fd = -1;
+    void* mapping = nullptr;
+    size_t mappedBytes = 0;
+    const uint32_t* neighborData = nullptr;
+};
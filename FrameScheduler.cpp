@@ -0,0 +1,38 @@
+#include "FrameScheduler.h"
+#include <GLFW/glfw3.h>
+#include <algorithm>
+
+void FrameScheduler::requestRedraw(int frames) {
+    pendingFrames = std::max(pendingFrames, frames);
+}
+
+void FrameScheduler::frameRendered(double now) {
+    lastFrameTime = now;
+    if (pendingFrames > 0) --pendingFrames;
+    ++framesRendered;
+}
+
+bool FrameScheduler::waitForNextFrame() {
+    double start = glfwGetTime();
+
+    if (shouldRender()) {
+        if (maxFps <= 0) {
+            glfwPollEvents();
+            return false;
+        }
+
+        // Sleep out the rest of the frame budget, still handling events.
+        double due = lastFrameTime + 1.0 / maxFps;
+        double now = start;
+        while (now < due) {
+            glfwWaitEventsTimeout(due - now);
+            now = glfwGetTime();
+        }
+        glfwPollEvents();
+        return false;
+    }
+
+    glfwWaitEventsTimeout(idleTimeout);
+    idleSeconds += glfwGetTime() - start;
+    return true;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+// Decides when the main loop draws. Anything that changes the picture calls
+// requestRedraw(); with nothing pending the loop blocks in
+// glfwWaitEventsTimeout instead of spinning. maxFps caps the rate while
+// frames are being requested continuously (0 = uncapped).
+class FrameScheduler {
+public:
+    bool renderOnDemand = true;
+    int maxFps = 0;
+    double idleTimeout = 0.5;   // seconds; bounds the wake-up latency for polled work
+
+    unsigned long long framesRendered = 0;
+    double idleSeconds = 0.0;
+
+    // ImGui reacts to input one frame late, so an event keeps a couple of
+    // frames coming.
+    void requestRedraw(int frames = 2);
+    bool shouldRender() const { return !renderOnDemand || pendingFrames > 0; }
+    void frameRendered(double now);
+
+    // Processes window events, sleeping until the next frame is due.
+    // Returns true if the loop was idle, i.e. the time since the previous
+    // frame should not count as simulation time.
+    bool waitForNextFrame();
+
+private:
+    int pendingFrames = 2;
+    double lastFrameTime = 0.0;
+};
@@ -1,4 +1,5 @@
 #include "Graph.h"
+#include "ThreadPool.h"
 #include <cmath>
 #include <fstream>
 #include <sstream>
@@ -8,14 +9,51 @@
 #define M_PI 3.14159265358979323846
 #endif
 
+namespace {
+    const int cellBias = 1 << 20;
+
+    inline int cellCoord(float value, float cellSize) {
+        float cell = std::floor(value / cellSize);
+        if (!(cell > -(float)(cellBias - 2))) return -(cellBias - 2);
+        if (cell > (float)(cellBias - 2)) return cellBias - 2;
+        return (int)cell;
+    }
+
+    inline unsigned long long packCell(int x, int y, int z) {
+        return ((unsigned long long)(x + cellBias) << 42) | ((unsigned long long)(y + cellBias) << 21)
+            | (unsigned long long)(z + cellBias);
+    }
+}
+
 Graph::Graph() {
     nodes.reserve(500);
     edges.reserve(2500);
 }
 
+std::mt19937 Graph::makeRng(RngStream stream) const {
+    if (seed != 0) {
+        return std::mt19937(seed ^ stream);
+    }
+    std::random_device rd;
+    return std::mt19937(rd());
+}
+
 void Graph::clear() {
     nodes.clear();
     edges.clear();
+    nodeCommunity.clear();
+
+    mutationIndexBuilt = false;
+    adjacency.clear();
+    edgeLookup.clear();
+    idToIndex.clear();
+    activeNodes.clear();
+    activeSteps.clear();
+
+    dirtyNodes.markAll();
+    dirtyEdges.markAll();
+    dirtyDegrees.markAll();
+    ++topologyVersion;
 }
 
 void Graph::generateRandomGraph() {
@@ -24,8 +62,7 @@ void Graph::generateRandomGraph() {
     nodes.reserve(nodeCount);
     edges.reserve(nodeCount * nodeCount / 4);
 
-    std::random_device rd;
-    std::mt19937 gen(rd());
+    std::mt19937 gen = makeRng();
     std::uniform_real_distribution<float> pos_dist(-1.0f, 1.0f);
 
     for (int i = 0; i < nodeCount; ++i) {
@@ -98,8 +135,7 @@ void Graph::generateRingGraph() {
     nodes.reserve(nodeCount);
     edges.reserve(nodeCount);
 
-    std::random_device rd;
-    std::mt19937 gen(rd());
+    std::mt19937 gen = makeRng();
     std::normal_distribution<float> noise_dist(0.0f, 0.1f);
 
     for (int i = 0; i < nodeCount; ++i) {
@@ -134,8 +170,7 @@ void Graph::generateStarGraph() {
 
     nodes.emplace_back(0, glm::vec3(0.0f));
 
-    std::random_device rd;
-    std::mt19937 gen(rd());
+    std::mt19937 gen = makeRng();
     std::uniform_real_distribution<float> angle_dist(0.0f, 2.0f * M_PI);
 
     for (int i = 1; i < nodeCount; ++i) {
@@ -158,8 +193,7 @@ void Graph::generateStarGraph() {
 }
 
 void Graph::generateEdges() {
-    std::random_device rd;
-    std::mt19937 gen(rd());
+    std::mt19937 gen = makeRng(RNG_EDGES);
     std::uniform_real_distribution<float> prob_dist(0.0f, 1.0f);
 
     for (int i = 0; i < nodeCount; ++i) {
@@ -187,15 +221,31 @@ void Graph::addEdge(int from, int to, float weight) {
     edges.emplace_back(from, to, weight);
 }
 
-void Graph::updateLayout(float deltaTime) {
+float Graph::updateLayout(float deltaTime) {
     applyForceDirectedLayout();
 
+    float maxStep = 0.0f;
+    double energy = 0.0, forceSum = 0.0, stepSum = 0.0;
     for (auto& node : nodes) {
+        forceSum += glm::length(node.force);
         node.velocity += node.force * deltaTime;
         node.velocity *= 0.9f;
-        node.position += node.velocity * deltaTime;
+        glm::vec3 step = node.velocity * deltaTime;
+        node.position += step;
         node.force = glm::vec3(0.0f);
+        float stepLength = glm::length(step);
+        maxStep = std::max(maxStep, stepLength);
+        stepSum += stepLength;
+        energy += 0.5 * glm::dot(node.velocity, node.velocity);
     }
+    dirtyNodes.markAll();
+
+    lastStepStats.kineticEnergy = energy;
+    lastStepStats.totalForce = forceSum;
+    lastStepStats.maxDisplacement = maxStep;
+    lastStepStats.meanDisplacement = nodes.empty() ? 0.0 : stepSum / nodes.size();
+    lastStepStats.nodes = nodes.size();
+    return maxStep;
 }
 
 void Graph::applyForceDirectedLayout() {
@@ -219,12 +269,17 @@ void Graph::applyForceDirectedLayout() {
         }
     }
 
+    const bool boostCommunities = communityAttractionBoost > 0.0f && nodeCommunity.size() == nodes.size();
+
     for (const auto& edge : edges) {
         glm::vec3 diff = nodes[edge.to].position - nodes[edge.from].position;
         float distance = glm::length(diff);
 
         if (distance > 0.001f) {
             float force = attractionStrength * distance * distance;
+            if (boostCommunities && sameCommunity(edge.from, edge.to)) {
+                force *= 1.0f + communityAttractionBoost;
+            }
             glm::vec3 direction = glm::normalize(diff);
             nodes[edge.from].force += direction * force;
             nodes[edge.to].force -= direction * force;
@@ -253,7 +308,451 @@ void Graph::normalizePositions() {
         for (auto& node : nodes) {
             node.position = (node.position - center) * scale;
         }
+        dirtyNodes.markAll();
+    }
+}
+
+void DirtyRanges::mark(size_t begin, size_t end) {
+    if (all || begin >= end) return;
+
+    if (!ranges.empty()) {
+        std::pair<size_t, size_t>& last = ranges.back();
+        if (begin <= last.second && end >= last.first) {
+            last.first = std::min(last.first, begin);
+            last.second = std::max(last.second, end);
+            return;
+        }
+    }
+    ranges.emplace_back(begin, end);
+
+    // Scattered updates: fall back to one bounding range.
+    if (ranges.size() > 4096) {
+        std::vector<std::pair<size_t, size_t>> merged = coalesce((size_t)-1, 4096);
+        ranges.swap(merged);
+    }
+}
+
+std::vector<std::pair<size_t, size_t>> DirtyRanges::coalesce(size_t size, size_t gap) const {
+    std::vector<std::pair<size_t, size_t>> result;
+    if (all) {
+        if (size > 0) result.emplace_back(0, size);
+        return result;
+    }
+
+    std::vector<std::pair<size_t, size_t>> sorted(ranges);
+    std::sort(sorted.begin(), sorted.end());
+    for (const auto& range : sorted) {
+        size_t begin = std::min(range.first, size);
+        size_t end = std::min(range.second, size);
+        if (begin >= end) continue;
+        if (!result.empty() && begin <= result.back().second + gap) {
+            result.back().second = std::max(result.back().second, end);
+        }
+        else {
+            result.emplace_back(begin, end);
+        }
+    }
+    return result;
+}
+
+namespace {
+    unsigned long long edgeKey(int a, int b) {
+        if (a > b) std::swap(a, b);
+        return ((unsigned long long)(unsigned int)a << 32) | (unsigned int)b;
+    }
+
+    void replaceNeighbor(std::vector<int>& list, int from, int to) {
+        for (auto& neighbor : list) {
+            if (neighbor == from) {
+                neighbor = to;
+                return;
+            }
+        }
+    }
+
+    void eraseNeighbor(std::vector<int>& list, int neighbor) {
+        for (size_t i = 0; i < list.size(); ++i) {
+            if (list[i] == neighbor) {
+                list[i] = list.back();
+                list.pop_back();
+                return;
+            }
+        }
+    }
+}
+
+void Graph::ensureMutationIndex() {
+    if (mutationIndexBuilt) return;
+
+    adjacency.assign(nodes.size(), std::vector<int>());
+    edgeLookup.clear();
+    edgeLookup.reserve(edges.size());
+    idToIndex.clear();
+    idToIndex.reserve(nodes.size());
+    nextNodeId = 0;
+
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        idToIndex[nodes[i].id] = (int)i;
+        nextNodeId = std::max(nextNodeId, nodes[i].id + 1);
+    }
+    for (size_t e = 0; e < edges.size(); ++e) {
+        adjacency[edges[e].from].push_back(edges[e].to);
+        adjacency[edges[e].to].push_back(edges[e].from);
+        edgeLookup[edgeKey(edges[e].from, edges[e].to)] = (int)e;
+    }
+
+    mutationRng = makeRng(RNG_MUTATIONS);
+    mutationIndexBuilt = true;
+}
+
+int Graph::indexOf(int id) {
+    ensureMutationIndex();
+    std::unordered_map<int, int>::const_iterator it = idToIndex.find(id);
+    return it == idToIndex.end() ? -1 : it->second;
+}
+
+int Graph::degree(int index) {
+    ensureMutationIndex();
+    return index >= 0 && index < (int)adjacency.size() ? (int)adjacency[index].size() : 0;
+}
+
+int Graph::addNode(const glm::vec3& position, int id) {
+    ensureMutationIndex();
+
+    if (id < 0) {
+        id = nextNodeId;
+    }
+    else if (idToIndex.count(id)) {
+        return -1;
+    }
+    nextNodeId = std::max(nextNodeId, id + 1);
+
+    int index = (int)nodes.size();
+    if (nodeCommunity.size() == nodes.size() && !nodeCommunity.empty()) {
+        nodeCommunity.push_back(-1);
+    }
+    nodes.emplace_back(id, position);
+    adjacency.emplace_back();
+    idToIndex[id] = index;
+    nodeCount = (int)nodes.size();
+
+    dirtyNodes.mark(index);
+    dirtyDegrees.mark(index);
+    ++topologyVersion;
+    activateRegion(index, 0);
+    return id;
+}
+
+int Graph::addNodeNear(const std::vector<int>& neighborIds, float weight) {
+    int id = addNode(glm::vec3(0.0f));
+    for (int neighborId : neighborIds) {
+        addEdgeById(id, neighborId, weight);
+    }
+    placeNearNeighbors(id);
+    return id;
+}
+
+bool Graph::placeNearNeighbors(int id) {
+    int index = indexOf(id);
+    if (index < 0 || adjacency[index].empty()) return false;
+
+    glm::vec3 centroid(0.0f);
+    for (int neighbor : adjacency[index]) {
+        centroid += nodes[neighbor].position;
+    }
+    centroid /= (float)adjacency[index].size();
+
+    // Jitter so that several new nodes on the same neighbours do not stack.
+    std::uniform_real_distribution<float> jitter(-0.2f, 0.2f);
+    glm::vec3 offset(jitter(mutationRng), jitter(mutationRng), is3D ? jitter(mutationRng) : 0.0f);
+
+    nodes[index].position = centroid + offset;
+    nodes[index].velocity = glm::vec3(0.0f);
+    dirtyNodes.mark(index);
+    return true;
+}
+
+bool Graph::addEdgeById(int fromId, int toId, float weight) {
+    int from = indexOf(fromId);
+    int to = indexOf(toId);
+    if (from < 0 || to < 0 || from == to) return false;
+
+    unsigned long long key = edgeKey(from, to);
+    if (edgeLookup.count(key)) return false;
+
+    edgeLookup[key] = (int)edges.size();
+    dirtyEdges.mark(edges.size());
+    edges.emplace_back(from, to, weight);
+    adjacency[from].push_back(to);
+    adjacency[to].push_back(from);
+    dirtyDegrees.mark(from);
+    dirtyDegrees.mark(to);
+
+    ++topologyVersion;
+    activateRegion(from, localLayoutHops);
+    activateRegion(to, localLayoutHops);
+    return true;
+}
+
+bool Graph::removeEdgeById(int fromId, int toId) {
+    int from = indexOf(fromId);
+    int to = indexOf(toId);
+    if (from < 0 || to < 0) return false;
+
+    std::unordered_map<unsigned long long, int>::const_iterator it = edgeLookup.find(edgeKey(from, to));
+    if (it == edgeLookup.end()) return false;
+
+    eraseEdgeAt(it->second);
+    ++topologyVersion;
+    activateRegion(from, localLayoutHops);
+    activateRegion(to, localLayoutHops);
+    return true;
+}
+
+bool Graph::removeNode(int id) {
+    int index = indexOf(id);
+    if (index < 0) return false;
+
+    std::vector<int> neighborIds;
+    neighborIds.reserve(adjacency[index].size());
+    while (!adjacency[index].empty()) {
+        int neighbor = adjacency[index].back();
+        neighborIds.push_back(nodes[neighbor].id);
+        eraseEdgeAt(edgeLookup[edgeKey(index, neighbor)]);
+    }
+
+    deactivate(index);
+    int last = (int)nodes.size() - 1;
+    if (index != last) {
+        relocateNode(last, index);
+    }
+
+    nodes.pop_back();
+    adjacency.pop_back();
+    if (nodeCommunity.size() == nodes.size() + 1) nodeCommunity.pop_back();
+    if (activeSteps.size() == nodes.size() + 1) activeSteps.pop_back();
+    idToIndex.erase(id);
+    nodeCount = (int)nodes.size();
+    ++topologyVersion;
+
+    // Let the former neighbours relax into the gap.
+    for (int neighborId : neighborIds) {
+        activateRegion(idToIndex[neighborId], localLayoutHops - 1);
+    }
+    return true;
+}
+
+void Graph::eraseEdgeAt(size_t edgeIndex) {
+    Edge removed = edges[edgeIndex];
+    edgeLookup.erase(edgeKey(removed.from, removed.to));
+    eraseNeighbor(adjacency[removed.from], removed.to);
+    eraseNeighbor(adjacency[removed.to], removed.from);
+    dirtyDegrees.mark(removed.from);
+    dirtyDegrees.mark(removed.to);
+
+    size_t last = edges.size() - 1;
+    if (edgeIndex != last) {
+        edges[edgeIndex] = edges[last];
+        edgeLookup[edgeKey(edges[edgeIndex].from, edges[edgeIndex].to)] = (int)edgeIndex;
+        dirtyEdges.mark(edgeIndex);
+    }
+    edges.pop_back();
+}
+
+void Graph::relocateNode(int from, int to) {
+    nodes[to] = nodes[from];
+    idToIndex[nodes[to].id] = to;
+
+    for (int neighbor : adjacency[from]) {
+        unsigned long long oldKey = edgeKey(from, neighbor);
+        int e = edgeLookup[oldKey];
+        edgeLookup.erase(oldKey);
+
+        if (edges[e].from == from) edges[e].from = to;
+        if (edges[e].to == from) edges[e].to = to;
+        edgeLookup[edgeKey(to, neighbor)] = e;
+        dirtyEdges.mark(e);
+
+        replaceNeighbor(adjacency[neighbor], from, to);
+    }
+    adjacency[to].swap(adjacency[from]);
+
+    if (nodeCommunity.size() == nodes.size()) nodeCommunity[to] = nodeCommunity[from];
+    if (activeSteps.size() == nodes.size()) {
+        activeSteps[to] = activeSteps[from];
+        if (activeSteps[to] > 0) std::replace(activeNodes.begin(), activeNodes.end(), from, to);
+    }
+    dirtyNodes.mark(to);
+    dirtyDegrees.mark(to);
+}
+
+void Graph::activateRegion(int index, int hops) {
+    if (index < 0 || index >= (int)nodes.size()) return;
+    if (activeSteps.size() != nodes.size()) activeSteps.resize(nodes.size(), 0);
+    if (visitStamp.size() < nodes.size()) visitStamp.resize(nodes.size(), 0);
+    if (++currentStamp == 0) {
+        std::fill(visitStamp.begin(), visitStamp.end(), 0);
+        currentStamp = 1;
+    }
+
+    std::vector<int> frontier(1, index);
+    std::vector<int> next;
+    visitStamp[index] = currentStamp;
+    for (int hop = 0; !frontier.empty(); ++hop) {
+        for (int node : frontier) {
+            if (activeSteps[node] == 0) {
+                if ((int)activeNodes.size() >= maxActiveNodes) return;
+                activeNodes.push_back(node);
+            }
+            activeSteps[node] = (unsigned short)std::min(localLayoutSteps, 65535);
+
+            if (hop >= hops) continue;
+            for (int neighbor : adjacency[node]) {
+                if (visitStamp[neighbor] != currentStamp) {
+                    visitStamp[neighbor] = currentStamp;
+                    next.push_back(neighbor);
+                }
+            }
+        }
+        frontier.swap(next);
+        next.clear();
+    }
+}
+
+void Graph::deactivate(int index) {
+    if (index >= (int)activeSteps.size() || activeSteps[index] == 0) return;
+    activeSteps[index] = 0;
+    activeNodes.erase(std::remove(activeNodes.begin(), activeNodes.end(), index), activeNodes.end());
+}
+
+void Graph::buildRepulsionGrid(float cellSize) {
+    const size_t n = nodes.size();
+    std::vector<std::pair<unsigned long long, int>> keyed(n);
+    for (size_t i = 0; i < n; ++i) {
+        const glm::vec3& p = nodes[i].position;
+        keyed[i] = std::make_pair(packCell(cellCoord(p.x, cellSize), cellCoord(p.y, cellSize), cellCoord(p.z, cellSize)), (int)i);
+    }
+    std::sort(keyed.begin(), keyed.end());
+
+    repulsionCells.clear();
+    repulsionKeys.clear();
+    repulsionOrder.resize(n);
+    for (size_t k = 0; k < n; ++k) {
+        const int i = keyed[k].second;
+        repulsionOrder[k] = i;
+        if (k == 0 || keyed[k].first != keyed[k - 1].first) {
+            RepulsionCell cell;
+            cell.first = (int)k;
+            cell.count = 0;
+            cell.centroid = glm::vec3(0.0f);
+            repulsionCells.push_back(cell);
+            repulsionKeys.push_back(keyed[k].first);
+        }
+        repulsionCells.back().count++;
+        repulsionCells.back().centroid += nodes[i].position;
+    }
+    for (auto& cell : repulsionCells) {
+        cell.centroid /= (float)cell.count;
+    }
+}
+
+bool Graph::updateLocalLayout(float deltaTime) {
+    if (activeNodes.empty()) return false;
+    ensureMutationIndex();
+
+    const size_t activeCount = activeNodes.size();
+    const float maxRepulsionDistance = 15.0f;
+    const float maxLocalStep = 1.0f;
+    const bool boostCommunities = communityAttractionBoost > 0.0f && nodeCommunity.size() == nodes.size();
+    localForces.resize(activeCount);
+
+    // Nodes outside the active region stay pinned but still repel the active
+    // ones. Every node is binned into cells of half the cut-off: nodes in the
+    // 27 cells around an active node repel it exactly, the next ring of cells
+    // through their node count at their centroid, and anything farther is
+    // beyond the cut-off.
+    const float cellSize = maxRepulsionDistance * 0.5f;
+    buildRepulsionGrid(cellSize);
+
+    parallelFor(activeCount, 64, [&](size_t begin, size_t end, int) {
+        for (size_t a = begin; a < end; ++a) {
+            int i = activeNodes[a];
+            const glm::vec3 p = nodes[i].position;
+            const int cx = cellCoord(p.x, cellSize), cy = cellCoord(p.y, cellSize), cz = cellCoord(p.z, cellSize);
+            glm::vec3 force(0.0f);
+
+            for (int dx = -2; dx <= 2; ++dx) {
+                for (int dy = -2; dy <= 2; ++dy) {
+                    for (int dz = -2; dz <= 2; ++dz) {
+                        const unsigned long long key = packCell(cx + dx, cy + dy, cz + dz);
+                        std::vector<unsigned long long>::const_iterator found =
+                            std::lower_bound(repulsionKeys.begin(), repulsionKeys.end(), key);
+                        if (found == repulsionKeys.end() || *found != key) continue;
+                        const RepulsionCell& cell = repulsionCells[found - repulsionKeys.begin()];
+
+                        if (std::abs(dx) <= 1 && std::abs(dy) <= 1 && std::abs(dz) <= 1) {
+                            for (int k = cell.first; k < cell.first + cell.count; ++k) {
+                                const int j = repulsionOrder[k];
+                                if (j == i) continue;
+                                glm::vec3 diff = p - nodes[j].position;
+                                float distance = glm::length(diff);
+                                if (distance > 0.001f && distance < maxRepulsionDistance) {
+                                    force += diff / distance * (repulsionStrength / (distance * distance));
+                                }
+                            }
+                            continue;
+                        }
+                        glm::vec3 diff = p - cell.centroid;
+                        float distance = glm::length(diff);
+                        if (distance > 0.001f && distance < maxRepulsionDistance) {
+                            force += diff / distance * (cell.count * repulsionStrength / (distance * distance));
+                        }
+                    }
+                }
+            }
+
+            for (int j : adjacency[i]) {
+                glm::vec3 diff = nodes[j].position - nodes[i].position;
+                float distance = glm::length(diff);
+                if (distance > 0.001f) {
+                    float strength = attractionStrength * distance * distance;
+                    if (boostCommunities && sameCommunity(i, j)) {
+                        strength *= 1.0f + communityAttractionBoost;
+                    }
+                    force += diff / distance * strength;
+                }
+            }
+            localForces[a] = force;
+        }
+    });
+
+    size_t kept = 0;
+    for (size_t a = 0; a < activeCount; ++a) {
+        int i = activeNodes[a];
+        Node& node = nodes[i];
+        node.velocity += localForces[a] * deltaTime;
+        node.velocity *= 0.9f;
+
+        // Pinned neighbours cannot give way, so cap the step to keep freshly
+        // inserted (possibly coincident) nodes from being flung off.
+        glm::vec3 step = node.velocity * deltaTime;
+        float stepLength = glm::length(step);
+        if (stepLength > maxLocalStep) {
+            step *= maxLocalStep / stepLength;
+            node.velocity = step / deltaTime;
+        }
+        node.position += step;
+        dirtyNodes.mark(i);
+
+        if (--activeSteps[i] > 0) {
+            activeNodes[kept++] = i;
+        }
+        else {
+            node.velocity = glm::vec3(0.0f);
+        }
     }
+    activeNodes.resize(kept);
+    return true;
 }
 
 void Graph::exportToSVG(const std::string& filename, const glm::mat4& viewMatrix,
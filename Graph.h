@@ -2,8 +2,12 @@
 #include <vector>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include "LayoutStepStats.h"
 #include <random>
 #include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <utility>
 
 struct Node {
     int id;
@@ -26,6 +30,22 @@ struct Edge {
     }
 };
 
+// Index ranges of `nodes` / `edges` changed since the consumer (the render
+// buffers) last synced. Nearby ranges are merged; markAll() means everything.
+struct DirtyRanges {
+    std::vector<std::pair<size_t, size_t>> ranges;  // half-open [first, second)
+    bool all = false;
+
+    void mark(size_t index) { mark(index, index + 1); }
+    void mark(size_t begin, size_t end);
+    void markAll() { all = true; ranges.clear(); }
+    bool empty() const { return !all && ranges.empty(); }
+    void clear() { all = false; ranges.clear(); }
+
+    // Sorted, merged ranges clamped to `size`; ranges closer than `gap` are joined.
+    std::vector<std::pair<size_t, size_t>> coalesce(size_t size, size_t gap = 64) const;
+};
+
 class Graph {
 public:
     std::vector<Node> nodes;
@@ -37,6 +57,25 @@ public:
     float layoutStrength = 0.1f;
     float repulsionStrength = 100.0f;
     float attractionStrength = 0.1f;
+    unsigned int seed = 0;  // 0 = non-deterministic (std::random_device)
+
+    // Optional per-node community ids; edges inside a community attract
+    // (1 + communityAttractionBoost) times as strongly. Negative ids (nodes
+    // added after detection) belong to no community.
+    std::vector<int> nodeCommunity;
+    float communityAttractionBoost = 0.0f;
+
+    // Mutations re-lay out only the touched nodes and their neighbourhood
+    // (up to localLayoutHops away) for localLayoutSteps steps. A local step
+    // costs O(n log n) to bin the nodes plus O(active * nearby nodes).
+    int localLayoutSteps = 120;
+    int localLayoutHops = 2;
+    int maxActiveNodes = 4096;
+
+    DirtyRanges dirtyNodes;
+    DirtyRanges dirtyEdges;
+    DirtyRanges dirtyDegrees;   // nodes whose neighbour count changed
+    unsigned long long topologyVersion = 0;
 
     Graph();
 
@@ -45,15 +84,66 @@ public:
     void generateRingGraph();
     void generateStarGraph();
 
-    void updateLayout(float deltaTime);
+    float updateLayout(float deltaTime);  // returns the largest node displacement
     void applyForceDirectedLayout();
+    LayoutStepStats lastStepStats;        // of the last updateLayout call
     void normalizePositions();
 
+    // Dynamic mutation API. Nodes are addressed by their stable Node::id;
+    // removing a node moves the last node into its slot in `nodes`.
+    int addNode(const glm::vec3& position, int id = -1);
+    int addNodeNear(const std::vector<int>& neighborIds, float weight = 1.0f);
+    bool removeNode(int id);
+    bool addEdgeById(int fromId, int toId, float weight = 1.0f);
+    bool removeEdgeById(int fromId, int toId);
+    bool placeNearNeighbors(int id);  // false if the node has no neighbours yet
+    int indexOf(int id);
+    int degree(int index);
+
+    bool updateLocalLayout(float deltaTime);
+    bool hasActiveRegion() const { return !activeNodes.empty(); }
+
     void clear();
     void exportToSVG(const std::string& filename, const glm::mat4& viewMatrix,
         const glm::mat4& projectionMatrix, int width, int height) const;
 
 private:
+    // Separate streams of the same seed (seed ^ stream), so that the edge
+    // draw and mutation jitter do not replay the numbers that placed the
+    // nodes.
+    enum RngStream : unsigned int { RNG_POSITIONS = 0, RNG_EDGES = 0x9E3779B9u, RNG_MUTATIONS = 0x85EBCA6Bu };
+    std::mt19937 makeRng(RngStream stream = RNG_POSITIONS) const;
+    bool sameCommunity(int a, int b) const { return nodeCommunity[a] >= 0 && nodeCommunity[a] == nodeCommunity[b]; }
     void generateEdges();
     void addEdge(int from, int to, float weight = 1.0f);
+
+    void ensureMutationIndex();
+    void eraseEdgeAt(size_t edgeIndex);
+    void relocateNode(int from, int to);
+    void activateRegion(int index, int hops);
+    void deactivate(int index);
+
+    // Built lazily by the first mutation call and dropped by clear().
+    bool mutationIndexBuilt = false;
+    std::vector<std::vector<int>> adjacency;
+    std::unordered_map<unsigned long long, int> edgeLookup;
+    std::unordered_map<int, int> idToIndex;
+    int nextNodeId = 0;
+    std::mt19937 mutationRng;
+
+    std::vector<int> activeNodes;
+    std::vector<unsigned short> activeSteps;
+    std::vector<unsigned int> visitStamp;
+    unsigned int currentStamp = 0;
+    std::vector<glm::vec3> localForces;
+
+    // Every node binned for the local layout's repulsion; rebuilt per step.
+    struct RepulsionCell {
+        int first, count;     // range in repulsionOrder
+        glm::vec3 centroid;
+    };
+    void buildRepulsionGrid(float cellSize);
+    std::vector<RepulsionCell> repulsionCells;
+    std::vector<unsigned long long> repulsionKeys;   // sorted, one per cell
+    std::vector<int> repulsionOrder;                 // node indices grouped by cell
 };
@@ -0,0 +1,532 @@
+#include "GraphAnalytics.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace {
+    typedef std::chrono::steady_clock Clock;
+
+    double elapsedMs(Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    // Direction-optimising BFS switch thresholds (Beamer et al.).
+    const long long kAlpha = 14;
+    const long long kBeta = 24;
+
+    int findRoot(std::atomic<int>* parent, int x) {
+        while (true) {
+            int p = parent[x].load(std::memory_order_relaxed);
+            if (p == x) return x;
+            int gp = parent[p].load(std::memory_order_relaxed);
+            if (p != gp) {
+                // Path halving; losing the race is harmless.
+                parent[x].compare_exchange_weak(p, gp, std::memory_order_relaxed);
+            }
+            x = gp;
+        }
+    }
+
+    void unite(std::atomic<int>* parent, int a, int b) {
+        while (true) {
+            a = findRoot(parent, a);
+            b = findRoot(parent, b);
+            if (a == b) return;
+            // Always hook the larger root under the smaller so no cycles form.
+            if (a < b) std::swap(a, b);
+            int expected = a;
+            if (parent[a].compare_exchange_strong(expected, b, std::memory_order_relaxed)) return;
+        }
+    }
+}
+
+glm::vec3 heatColor(float t) {
+    t = glm::clamp(t, 0.0f, 1.0f);
+    if (t < 0.33f) return glm::mix(glm::vec3(0.1f, 0.3f, 1.0f), glm::vec3(0.0f, 1.0f, 0.3f), t / 0.33f);
+    if (t < 0.66f) return glm::mix(glm::vec3(0.0f, 1.0f, 0.3f), glm::vec3(1.0f, 0.9f, 0.0f), (t - 0.33f) / 0.33f);
+    return glm::mix(glm::vec3(1.0f, 0.9f, 0.0f), glm::vec3(1.0f, 0.15f, 0.1f), (t - 0.66f) / 0.34f);
+}
+
+glm::vec3 categoricalColor(int id) {
+    if (id < 0) return glm::vec3(0.4f);
+
+    // Golden-ratio hue stepping keeps neighbouring ids visually distinct.
+    float h = std::fmod(id * 0.618033988f, 1.0f) * 6.0f;
+    float s = 0.75f;
+    float v = (id % 2 == 0) ? 1.0f : 0.8f;
+    int sector = (int)h;
+    float f = h - sector;
+    float p = v * (1.0f - s);
+    float q = v * (1.0f - s * f);
+    float r = v * (1.0f - s * (1.0f - f));
+    switch (sector) {
+    case 0: return glm::vec3(v, r, p);
+    case 1: return glm::vec3(q, v, p);
+    case 2: return glm::vec3(p, v, r);
+    case 3: return glm::vec3(p, q, v);
+    case 4: return glm::vec3(r, p, v);
+    default: return glm::vec3(v, p, q);
+    }
+}
+
+std::atomic<int>* GraphAnalytics::ensureAtomicScratch(size_t count) {
+    if (atomicScratchSize < count) {
+        atomicScratch.reset(new std::atomic<int>[count]);
+        atomicScratchSize = count;
+    }
+    return atomicScratch.get();
+}
+
+void GraphAnalytics::clear() {
+    built = false;
+    offsets.assign(1, 0);
+    neighbors.clear();
+    bfsDepth.clear();
+    bfsSource = -1;
+    bfsMaxDepth = 0;
+    bfsReached = 0;
+    componentId.clear();
+    componentSizes.clear();
+    componentCount = 0;
+    degreeStats = DegreeStats();
+    clustering.clear();
+    averageClustering = 0.0;
+    globalClustering = 0.0;
+    triangleCount = 0;
+}
+
+void GraphAnalytics::build(const Graph& graph) {
+    Clock::time_point start = Clock::now();
+    clear();
+
+    const int n = (int)graph.nodes.size();
+    const std::vector<Edge>& edges = graph.edges;
+    std::atomic<int>* counts = ensureAtomicScratch(n);
+
+    parallelFor(n, 16384, [&](size_t begin, size_t end, int) {
+        for (size_t v = begin; v < end; ++v) counts[v].store(0, std::memory_order_relaxed);
+    });
+    parallelFor(edges.size(), 16384, [&](size_t begin, size_t end, int) {
+        for (size_t i = begin; i < end; ++i) {
+            const Edge& e = edges[i];
+            if (e.from < 0 || e.from >= n || e.to < 0 || e.to >= n || e.from == e.to) continue;
+            counts[e.from].fetch_add(1, std::memory_order_relaxed);
+            counts[e.to].fetch_add(1, std::memory_order_relaxed);
+        }
+    });
+
+    offsets.resize(n + 1);
+    offsets[0] = 0;
+    for (int v = 0; v < n; ++v) {
+        offsets[v + 1] = offsets[v] + counts[v].load(std::memory_order_relaxed);
+    }
+    neighbors.resize(offsets[n]);
+
+    // Reuse the counters as per-node write cursors.
+    parallelFor(n, 16384, [&](size_t begin, size_t end, int) {
+        for (size_t v = begin; v < end; ++v) counts[v].store(offsets[v], std::memory_order_relaxed);
+    });
+    parallelFor(edges.size(), 16384, [&](size_t begin, size_t end, int) {
+        for (size_t i = begin; i < end; ++i) {
+            const Edge& e = edges[i];
+            if (e.from < 0 || e.from >= n || e.to < 0 || e.to >= n || e.from == e.to) continue;
+            neighbors[counts[e.from].fetch_add(1, std::memory_order_relaxed)] = e.to;
+            neighbors[counts[e.to].fetch_add(1, std::memory_order_relaxed)] = e.from;
+        }
+    });
+    // Sort each list and drop parallel edges; counts now hold unique lengths.
+    std::atomic<bool> hasDuplicates(false);
+    parallelFor(n, 1024, [&](size_t begin, size_t end, int) {
+        for (size_t v = begin; v < end; ++v) {
+            std::vector<int>::iterator first = neighbors.begin() + offsets[v];
+            std::vector<int>::iterator last = neighbors.begin() + offsets[v + 1];
+            std::sort(first, last);
+            std::vector<int>::iterator uniqueEnd = std::unique(first, last);
+            counts[v].store((int)(uniqueEnd - first), std::memory_order_relaxed);
+            if (uniqueEnd != last) hasDuplicates.store(true, std::memory_order_relaxed);
+        }
+    });
+    if (hasDuplicates.load()) {
+        int out = 0;
+        for (int v = 0; v < n; ++v) {
+            int oldBegin = offsets[v];
+            int length = counts[v].load(std::memory_order_relaxed);
+            std::copy(neighbors.begin() + oldBegin, neighbors.begin() + oldBegin + length, neighbors.begin() + out);
+            offsets[v] = out;
+            out += length;
+        }
+        offsets[n] = out;
+        neighbors.resize(out);
+    }
+
+    built = true;
+    buildMs = elapsedMs(start);
+}
+
+void GraphAnalytics::computeBFS(int source) {
+    Clock::time_point start = Clock::now();
+    const int n = nodeCount();
+    bfsDepth.assign(n > 0 ? n : 0, -1);
+    bfsSource = source;
+    bfsMaxDepth = 0;
+    bfsReached = 0;
+    if (!built || source < 0 || source >= n) return;
+
+    ThreadPool& pool = ThreadPool::instance();
+    const int workers = pool.size();
+    std::atomic<int>* depth = ensureAtomicScratch(n);
+    parallelFor(n, 16384, [&](size_t begin, size_t end, int) {
+        for (size_t v = begin; v < end; ++v) depth[v].store(-1, std::memory_order_relaxed);
+    });
+    depth[source].store(0, std::memory_order_relaxed);
+
+    localFrontiers.resize(workers);
+    std::vector<long long> localCounts(workers);
+    std::vector<long long> localScout(workers);
+
+    frontier.clear();
+    frontier.push_back(source);
+    size_t frontierSize = 1;
+    long long scout = degree(source);
+    long long edgesToCheck = (long long)neighbors.size();
+    bool bottomUp = false;
+    int level = 0;
+    int reached = 1;
+
+    while (frontierSize > 0) {
+        if (!bottomUp && scout > edgesToCheck / kAlpha) {
+            frontierBits.assign(n, 0);
+            for (int u : frontier) frontierBits[u] = 1;
+            bottomUp = true;
+        }
+
+        std::fill(localCounts.begin(), localCounts.end(), 0);
+        std::fill(localScout.begin(), localScout.end(), 0);
+        const int nextLevel = level + 1;
+
+        if (bottomUp) {
+            nextBits.assign(n, 0);
+            parallelFor(n, 4096, [&](size_t begin, size_t end, int worker) {
+                long long found = 0, edgesSeen = 0;
+                for (size_t v = begin; v < end; ++v) {
+                    if (depth[v].load(std::memory_order_relaxed) != -1) continue;
+                    for (int i = offsets[v]; i < offsets[v + 1]; ++i) {
+                        if (frontierBits[neighbors[i]]) {
+                            depth[v].store(nextLevel, std::memory_order_relaxed);
+                            nextBits[v] = 1;
+                            found++;
+                            edgesSeen += offsets[v + 1] - offsets[v];
+                            break;
+                        }
+                    }
+                }
+                localCounts[worker] += found;
+                localScout[worker] += edgesSeen;
+            });
+            frontierBits.swap(nextBits);
+
+            size_t previousSize = frontierSize;
+            frontierSize = 0;
+            scout = 0;
+            for (int w = 0; w < workers; ++w) {
+                frontierSize += (size_t)localCounts[w];
+                scout += localScout[w];
+            }
+            edgesToCheck -= scout;
+
+            if (frontierSize > 0 && frontierSize < previousSize && (long long)frontierSize < n / kBeta) {
+                frontier.clear();
+                for (int v = 0; v < n; ++v) {
+                    if (frontierBits[v]) frontier.push_back(v);
+                }
+                bottomUp = false;
+            }
+        }
+        else {
+            for (auto& local : localFrontiers) local.clear();
+            parallelFor(frontier.size(), 256, [&](size_t begin, size_t end, int worker) {
+                std::vector<int>& local = localFrontiers[worker];
+                long long edgesSeen = 0;
+                for (size_t i = begin; i < end; ++i) {
+                    int u = frontier[i];
+                    for (int j = offsets[u]; j < offsets[u + 1]; ++j) {
+                        int v = neighbors[j];
+                        if (depth[v].load(std::memory_order_relaxed) != -1) continue;
+                        int expected = -1;
+                        if (depth[v].compare_exchange_strong(expected, nextLevel, std::memory_order_relaxed)) {
+                            local.push_back(v);
+                            edgesSeen += offsets[v + 1] - offsets[v];
+                        }
+                    }
+                }
+                localScout[worker] += edgesSeen;
+            });
+
+            frontier.clear();
+            scout = 0;
+            for (int w = 0; w < workers; ++w) {
+                frontier.insert(frontier.end(), localFrontiers[w].begin(), localFrontiers[w].end());
+                scout += localScout[w];
+            }
+            edgesToCheck -= scout;
+            frontierSize = frontier.size();
+        }
+
+        if (frontierSize > 0) {
+            level = nextLevel;
+            reached += (int)frontierSize;
+        }
+    }
+
+    parallelFor(n, 16384, [&](size_t begin, size_t end, int) {
+        for (size_t v = begin; v < end; ++v) bfsDepth[v] = depth[v].load(std::memory_order_relaxed);
+    });
+    bfsMaxDepth = level;
+    bfsReached = reached;
+    bfsMs = elapsedMs(start);
+}
+
+void GraphAnalytics::computeConnectedComponents() {
+    Clock::time_point start = Clock::now();
+    const int n = built ? nodeCount() : 0;
+    componentId.assign(n, 0);
+    componentSizes.clear();
+    componentCount = 0;
+    if (n == 0) return;
+
+    std::atomic<int>* parent = ensureAtomicScratch(n);
+    parallelFor(n, 16384, [&](size_t begin, size_t end, int) {
+        for (size_t v = begin; v < end; ++v) parent[v].store((int)v, std::memory_order_relaxed);
+    });
+    parallelFor(n, 1024, [&](size_t begin, size_t end, int) {
+        for (size_t v = begin; v < end; ++v) {
+            for (int i = offsets[v]; i < offsets[v + 1]; ++i) {
+                if (neighbors[i] > (int)v) unite(parent, (int)v, neighbors[i]);
+            }
+        }
+    });
+    parallelFor(n, 16384, [&](size_t begin, size_t end, int) {
+        for (size_t v = begin; v < end; ++v) componentId[v] = findRoot(parent, (int)v);
+    });
+
+    // Relabel roots to dense ids ordered by component size.
+    std::atomic<int>* sizes = parent;
+    parallelFor(n, 16384, [&](size_t begin, size_t end, int) {
+        for (size_t v = begin; v < end; ++v) sizes[v].store(0, std::memory_order_relaxed);
+    });
+    parallelFor(n, 16384, [&](size_t begin, size_t end, int) {
+        for (size_t v = begin; v < end; ++v) sizes[componentId[v]].fetch_add(1, std::memory_order_relaxed);
+    });
+
+    std::vector<std::pair<int, int>> roots;
+    for (int v = 0; v < n; ++v) {
+        if (componentId[v] == v) roots.emplace_back(sizes[v].load(std::memory_order_relaxed), v);
+    }
+    std::sort(roots.begin(), roots.end(), [](const std::pair<int, int>& a, const std::pair<int, int>& b) {
+        return a.first != b.first ? a.first > b.first : a.second < b.second;
+    });
+
+    componentCount = (int)roots.size();
+    componentSizes.resize(componentCount);
+    for (int i = 0; i < componentCount; ++i) {
+        componentSizes[i] = roots[i].first;
+        sizes[roots[i].second].store(i, std::memory_order_relaxed);
+    }
+    parallelFor(n, 16384, [&](size_t begin, size_t end, int) {
+        for (size_t v = begin; v < end; ++v) componentId[v] = sizes[componentId[v]].load(std::memory_order_relaxed);
+    });
+
+    componentsMs = elapsedMs(start);
+}
+
+void GraphAnalytics::computeDegreeStatistics() {
+    Clock::time_point start = Clock::now();
+    degreeStats = DegreeStats();
+    const int n = built ? nodeCount() : 0;
+    if (n == 0) return;
+
+    const int workers = ThreadPool::instance().size();
+    std::vector<int> localMin(workers, n), localMax(workers, 0);
+    parallelFor(n, 16384, [&](size_t begin, size_t end, int worker) {
+        int lo = localMin[worker], hi = localMax[worker];
+        for (size_t v = begin; v < end; ++v) {
+            int d = degree((int)v);
+            lo = std::min(lo, d);
+            hi = std::max(hi, d);
+        }
+        localMin[worker] = lo;
+        localMax[worker] = hi;
+    });
+
+    degreeStats.minDegree = *std::min_element(localMin.begin(), localMin.end());
+    degreeStats.maxDegree = *std::max_element(localMax.begin(), localMax.end());
+    degreeStats.meanDegree = (double)neighbors.size() / n;
+    degreeStats.histogram.assign(degreeStats.maxDegree + 1, 0);
+    for (int v = 0; v < n; ++v) {
+        degreeStats.histogram[degree(v)]++;
+    }
+
+    degreeMs = elapsedMs(start);
+}
+
+void GraphAnalytics::computeClusteringCoefficients() {
+    Clock::time_point start = Clock::now();
+    const int n = built ? nodeCount() : 0;
+    clustering.assign(n, 0.0f);
+    averageClustering = 0.0;
+    globalClustering = 0.0;
+    triangleCount = 0;
+    if (n == 0) return;
+
+    // Orient every edge towards the higher (degree, id) endpoint so each
+    // triangle is found exactly once, at its lowest-ranked corner, and hub
+    // adjacency lists never get scanned in full.
+    auto higher = [this](int a, int b) {
+        int da = degree(a), db = degree(b);
+        return da != db ? da > db : a > b;
+    };
+
+    forwardOffsets.resize(n + 1);
+    forwardOffsets[0] = 0;
+    parallelFor(n, 16384, [&](size_t begin, size_t end, int) {
+        for (size_t v = begin; v < end; ++v) {
+            int count = 0;
+            for (int i = offsets[v]; i < offsets[v + 1]; ++i) {
+                if (higher(neighbors[i], (int)v)) ++count;
+            }
+            forwardOffsets[v + 1] = count;
+        }
+    });
+    for (int v = 0; v < n; ++v) {
+        forwardOffsets[v + 1] += forwardOffsets[v];
+    }
+    forwardNeighbors.resize(forwardOffsets[n]);
+    parallelFor(n, 16384, [&](size_t begin, size_t end, int) {
+        for (size_t v = begin; v < end; ++v) {
+            int out = forwardOffsets[v];
+            for (int i = offsets[v]; i < offsets[v + 1]; ++i) {
+                if (higher(neighbors[i], (int)v)) forwardNeighbors[out++] = neighbors[i];
+            }
+        }
+    });
+
+    std::atomic<int>* triangles = ensureAtomicScratch(n);
+    parallelFor(n, 16384, [&](size_t begin, size_t end, int) {
+        for (size_t v = begin; v < end; ++v) triangles[v].store(0, std::memory_order_relaxed);
+    });
+    parallelFor(n, 256, [&](size_t begin, size_t end, int) {
+        for (size_t v = begin; v < end; ++v) {
+            const int* vBegin = forwardNeighbors.data() + forwardOffsets[v];
+            const int* vEnd = forwardNeighbors.data() + forwardOffsets[v + 1];
+            int found = 0;
+            for (const int* u = vBegin; u != vEnd; ++u) {
+                const int* a = vBegin;
+                const int* b = forwardNeighbors.data() + forwardOffsets[*u];
+                const int* bEnd = forwardNeighbors.data() + forwardOffsets[*u + 1];
+                int foundAtU = 0;
+                while (a != vEnd && b != bEnd) {
+                    if (*a < *b) ++a;
+                    else if (*b < *a) ++b;
+                    else {
+                        triangles[*a].fetch_add(1, std::memory_order_relaxed);
+                        ++foundAtU;
+                        ++a;
+                        ++b;
+                    }
+                }
+                if (foundAtU) triangles[*u].fetch_add(foundAtU, std::memory_order_relaxed);
+                found += foundAtU;
+            }
+            if (found) triangles[v].fetch_add(found, std::memory_order_relaxed);
+        }
+    });
+
+    const int workers = ThreadPool::instance().size();
+    std::vector<long long> localTriangles(workers, 0);
+    std::vector<double> localTriples(workers, 0.0);
+    std::vector<double> localSum(workers, 0.0);
+
+    parallelFor(n, 16384, [&](size_t begin, size_t end, int worker) {
+        long long tri = 0;
+        double triples = 0.0, sum = 0.0;
+        for (size_t v = begin; v < end; ++v) {
+            long long d = degree((int)v);
+            if (d < 2) continue;
+            long long t = triangles[v].load(std::memory_order_relaxed);
+            double c = 2.0 * t / (double)(d * (d - 1));
+            clustering[v] = (float)c;
+            tri += t;
+            triples += (double)(d * (d - 1)) * 0.5;
+            sum += c;
+        }
+        localTriangles[worker] += tri;
+        localTriples[worker] += triples;
+        localSum[worker] += sum;
+    });
+
+    long long cornerTriangles = 0;
+    double triples = 0.0, sum = 0.0;
+    for (int w = 0; w < workers; ++w) {
+        cornerTriangles += localTriangles[w];
+        triples += localTriples[w];
+        sum += localSum[w];
+    }
+
+    triangleCount = cornerTriangles / 3;
+    averageClustering = sum / n;
+    globalClustering = triples > 0.0 ? cornerTriangles / triples : 0.0;
+    clusteringMs = elapsedMs(start);
+}
+
+void GraphAnalytics::computeAll(const Graph& graph, int source) {
+    build(graph);
+    computeDegreeStatistics();
+    computeConnectedComponents();
+    computeBFS(source);
+    computeClusteringCoefficients();
+}
+
+void GraphAnalytics::buildNodeColors(int mode, std::vector<glm::vec3>& colors) const {
+    colors.clear();
+    const int n = built ? nodeCount() : 0;
+
+    switch (mode) {
+    case COLOR_DEGREE:
+        if (n == 0 || degreeStats.histogram.empty()) return;
+        colors.resize(n);
+        {
+            float scale = 1.0f / std::log(1.0f + std::max(1, degreeStats.maxDegree));
+            parallelFor(n, 16384, [&](size_t begin, size_t end, int) {
+                for (size_t v = begin; v < end; ++v) colors[v] = heatColor(std::log(1.0f + degree((int)v)) * scale);
+            });
+        }
+        break;
+    case COLOR_COMPONENT:
+        if ((int)componentId.size() != n || n == 0) return;
+        colors.resize(n);
+        parallelFor(n, 16384, [&](size_t begin, size_t end, int) {
+            for (size_t v = begin; v < end; ++v) colors[v] = categoricalColor(componentId[v]);
+        });
+        break;
+    case COLOR_BFS_DEPTH:
+        if ((int)bfsDepth.size() != n || n == 0) return;
+        colors.resize(n);
+        parallelFor(n, 16384, [&](size_t begin, size_t end, int) {
+            for (size_t v = begin; v < end; ++v) {
+                colors[v] = bfsDepth[v] < 0 ? glm::vec3(0.4f)
+                    : heatColor(bfsMaxDepth > 0 ? (float)bfsDepth[v] / bfsMaxDepth : 0.0f);
+            }
+        });
+        break;
+    case COLOR_CLUSTERING:
+        if ((int)clustering.size() != n || n == 0) return;
+        colors.resize(n);
+        parallelFor(n, 16384, [&](size_t begin, size_t end, int) {
+            for (size_t v = begin; v < end; ++v) colors[v] = heatColor(clustering[v]);
+        });
+        break;
+    default:
+        break;
+    }
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include "Graph.h"
+#include <atomic>
+#include <memory>
+#include <vector>
+
+enum NodeColorMode {
+    COLOR_UNIFORM = 0,
+    COLOR_DEGREE,
+    COLOR_COMPONENT,
+    COLOR_BFS_DEPTH,
+    COLOR_CLUSTERING,
+    COLOR_COMMUNITY
+};
+
+// Colour ramps shared by the node colouring modes.
+glm::vec3 heatColor(float t);          // t in [0, 1], blue -> green -> yellow -> red
+glm::vec3 categoricalColor(int id);    // distinct colour per id, grey for id < 0
+
+struct DegreeStats {
+    int minDegree = 0;
+    int maxDegree = 0;
+    double meanDegree = 0.0;
+    std::vector<int> histogram;   // histogram[d] = number of nodes with degree d
+};
+
+// Structural metrics over Graph::nodes / Graph::edges. build() snapshots the
+// topology into a CSR adjacency; every compute* call then runs multithreaded
+// on the shared ThreadPool and reuses its buffers between calls.
+class GraphAnalytics {
+public:
+    // CSR adjacency, neighbour lists sorted ascending.
+    std::vector<int> offsets;
+    std::vector<int> neighbors;
+
+    std::vector<int> bfsDepth;      // -1 = unreachable
+    int bfsSource = -1;
+    int bfsMaxDepth = 0;
+    int bfsReached = 0;
+
+    std::vector<int> componentId;   // dense ids, 0 = largest component
+    std::vector<int> componentSizes;
+    int componentCount = 0;
+
+    DegreeStats degreeStats;
+
+    std::vector<float> clustering;
+    double averageClustering = 0.0;
+    double globalClustering = 0.0;
+    long long triangleCount = 0;
+
+    double buildMs = 0.0;
+    double bfsMs = 0.0;
+    double componentsMs = 0.0;
+    double degreeMs = 0.0;
+    double clusteringMs = 0.0;
+
+    bool valid() const { return built; }
+    int nodeCount() const { return (int)offsets.size() - 1; }
+    int degree(int node) const { return offsets[node + 1] - offsets[node]; }
+
+    void clear();
+    void build(const Graph& graph);
+
+    void computeBFS(int source);
+    void computeConnectedComponents();
+    void computeDegreeStatistics();
+    void computeClusteringCoefficients();
+    void computeAll(const Graph& graph, int source = 0);
+
+    // Fills one colour per node for the given NodeColorMode; empty if the
+    // mode has no data yet.
+    void buildNodeColors(int mode, std::vector<glm::vec3>& colors) const;
+
+private:
+    bool built = false;
+
+    // Scratch reused across calls to keep the passes allocation-light.
+    std::unique_ptr<std::atomic<int>[]> atomicScratch;
+    size_t atomicScratchSize = 0;
+    std::vector<int> frontier;
+    std::vector<unsigned char> frontierBits;
+    std::vector<unsigned char> nextBits;
+    std::vector<std::vector<int>> localFrontiers;
+    std::vector<int> forwardOffsets;
+    std::vector<int> forwardNeighbors;
+
+    std::atomic<int>* ensureAtomicScratch(size_t count);
+};
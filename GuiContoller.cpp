@@ -1,4 +1,21 @@
 #include "GuiController.h"
+#include "GraphAnalytics.h"
+#include "CommunityDetector.h"
+#include "MutationStream.h"
+#include "CompactGraph.h"
+#include "Renderer.h"
+#include "FrameScheduler.h"
+#include "ShardedLayout.h"
+#include "LayoutClient.h"
+#include "LayoutTuner.h"
+#include "LayoutTelemetry.h"
+#include "OverlapRemover.h"
+#include "DistanceOracle.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <vector>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
@@ -61,11 +78,31 @@ void GuiController::render() {
     ImGui::Checkbox("Auto Layout", &params.autoLayout);
     ImGui::Checkbox("Show Nodes", &params.showNodes);
     ImGui::Checkbox("Show Edges", &params.showEdges);
+    const char* sizeModes[] = { "Uniform", "Degree" };
+    ImGui::Combo("Node Size", &params.nodeSizeMode, sizeModes, IM_ARRAYSIZE(sizeModes));
+    ImGui::SliderFloat("Node Radius", &params.nodeRadius, 1.0f, 16.0f);
+    ImGui::Checkbox("Render On Demand", &params.renderOnDemand);
+    ImGui::SliderInt("Max FPS", &params.maxFps, 0, 240);
+    if (scheduler) {
+        ImGui::Text("Frames drawn: %llu, idle %.1f s", scheduler->framesRendered, scheduler->idleSeconds);
+    }
 
     if (ImGui::Button("Regenerate")) {
         regenerate = true;
     }
 
+    renderAnalytics();
+    renderCommunities();
+    renderMutations();
+    renderCompact();
+    renderSharded();
+    renderRemote();
+    renderTuner();
+    renderTelemetry();
+    renderOverlaps();
+    renderPaths();
+    renderRasterExport();
+
     ImGui::End();
 
     ImGui::SameLine();
@@ -77,6 +114,319 @@ void GuiController::render() {
     ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 }
 
+static float degreeHistogramValue(void* data, int idx) {
+    return (float)static_cast<const GraphAnalytics*>(data)->degreeStats.histogram[idx];
+}
+
+void GuiController::renderAnalytics() {
+    ImGui::Separator();
+
+    ImGui::Text("Analytics:");
+    ImGui::InputInt("BFS Source", &params.bfsSource);
+    if (params.bfsSource < 0) params.bfsSource = 0;
+    if (ImGui::Button("Compute Metrics")) {
+        computeAnalytics = true;
+    }
+
+    const char* colorModes[] = { "Uniform", "Degree", "Component", "BFS Depth", "Clustering", "Community" };
+    ImGui::Combo("Node Color", &params.colorMode, colorModes, IM_ARRAYSIZE(colorModes));
+
+    if (!analytics || !analytics->valid()) {
+        return;
+    }
+
+    const DegreeStats& degree = analytics->degreeStats;
+    ImGui::Text("Degree min/mean/max: %d / %.2f / %d", degree.minDegree, degree.meanDegree, degree.maxDegree);
+    if (!degree.histogram.empty()) {
+        ImGui::PlotHistogram("Degree Histogram", degreeHistogramValue, (void*)analytics,
+            (int)degree.histogram.size(), 0, NULL, 0.0f, FLT_MAX, ImVec2(0, 60));
+    }
+    ImGui::Text("Components: %d (largest %d)", analytics->componentCount,
+        analytics->componentSizes.empty() ? 0 : analytics->componentSizes[0]);
+    ImGui::Text("BFS from %d: reached %d, depth %d", analytics->bfsSource, analytics->bfsReached, analytics->bfsMaxDepth);
+    ImGui::Text("Clustering avg %.4f, global %.4f", analytics->averageClustering, analytics->globalClustering);
+    ImGui::Text("Triangles: %lld", analytics->triangleCount);
+    ImGui::Text("Time (ms): CSR %.1f, BFS %.1f, CC %.1f, degree %.1f, clustering %.1f",
+        analytics->buildMs, analytics->bfsMs, analytics->componentsMs, analytics->degreeMs, analytics->clusteringMs);
+}
+
+void GuiController::renderCommunities() {
+    ImGui::Separator();
+
+    ImGui::Text("Communities:");
+    ImGui::SliderFloat("Resolution", &params.communityResolution, 0.1f, 3.0f);
+    ImGui::SliderFloat("Community Boost", &params.communityBoost, 0.0f, 5.0f);
+    if (ImGui::Button("Detect Communities")) {
+        detectCommunities = true;
+    }
+
+    if (!communities || !communities->valid()) {
+        return;
+    }
+
+    ImGui::Text("Communities: %d (largest %d)", communities->communityCount,
+        communities->communitySizes.empty() ? 0 : communities->communitySizes[0]);
+    ImGui::Text("Modularity: %.4f, levels: %d", communities->modularity, communities->levels);
+    ImGui::Text("Time: %.1f ms", communities->detectMs);
+}
+
+void GuiController::renderMutations() {
+    ImGui::Separator();
+
+    ImGui::Text("Dynamic Updates:");
+    ImGui::Checkbox("Incremental Layout", &params.incrementalLayout);
+    ImGui::SliderInt("Mutations / Frame", &params.mutationsPerFrame, 1, 10000);
+
+    if (!stream || !stream->isOpen()) {
+        return;
+    }
+
+    ImGui::Text("Stream: %s%s", stream->source.c_str(), stream->finished() ? " (finished)" : "");
+    ImGui::Text("Applied %zu, rejected %zu, parse errors %zu, queued %zu",
+        stream->applied, stream->rejected, stream->parseErrors(), stream->queued());
+}
+
+void GuiController::renderCompact() {
+    ImGui::Separator();
+
+    ImGui::Text("Large Graphs:");
+    ImGui::Checkbox("Compact Mode", &params.compactMode);
+    if (params.compactMode) {
+        ImGui::InputInt("Compact Nodes", &params.compactNodeCount);
+        if (params.compactNodeCount < 2) params.compactNodeCount = 2;
+        ImGui::SliderFloat("Average Degree", &params.compactDegree, 1.0f, 64.0f);
+    }
+
+    if (!compact || compact->nodeCount() == 0) {
+        return;
+    }
+
+    ImGui::Text("Nodes %zu, edges %zu", compact->nodeCount(), compact->edgeCount());
+    ImGui::Text("RAM: %.1f MB + %.1f MB layout scratch",
+        compact->storageBytes() / 1048576.0, compact->scratchBytes() / 1048576.0);
+    if (renderer) {
+        ImGui::Text("VRAM: %.1f MB", renderer->gpuBytes() / 1048576.0);
+    }
+}
+
+void GuiController::renderSharded() {
+    ImGui::Separator();
+
+    ImGui::Text("Multi-Process Layout:");
+    ImGui::SliderInt("Worker Processes", &params.shardCount, 1, 64);
+    ImGui::Checkbox("Pin Workers to CPUs", &params.pinWorkers);
+
+    bool running = sharded && sharded->isRunning();
+    if (!running && ImGui::Button("Start Workers")) {
+        startSharded = true;
+    }
+    if (running && ImGui::Button("Stop Workers")) {
+        stopSharded = true;
+    }
+
+    if (!sharded) {
+        return;
+    }
+    if (!sharded->error.empty()) {
+        ImGui::Text("Error: %s", sharded->error.c_str());
+    }
+    if (!running) {
+        return;
+    }
+
+    ImGui::Text("Step %llu, cut edges %zu", sharded->step, sharded->cutEdges);
+    for (size_t s = 0; s < sharded->stats.size(); ++s) {
+        const ShardedLayout::ShardStats& shard = sharded->stats[s];
+        ImGui::Text("#%zu: %d nodes, %d boundary, %d ghost, %d halo, %d far, %.1f ms",
+            s, shard.nodes, shard.boundaryNodes, shard.ghostNodes, shard.haloNodes, shard.farShards, shard.stepMs);
+    }
+}
+
+void GuiController::renderRemote() {
+    if (!client || !client->isConnected()) {
+        return;
+    }
+
+    ImGui::Separator();
+
+    ImGui::Text("Remote Layout: %s%s", client->endpoint.c_str(), client->disconnected() ? " (disconnected)" : "");
+    ImGui::Text("Step %llu, %zu messages, %.1f MB received",
+        client->step, client->messagesReceived, client->bytesReceived / 1048576.0);
+    if (!client->error.empty()) {
+        ImGui::Text("Error: %s", client->error.c_str());
+    }
+}
+
+void GuiController::renderTuner() {
+    ImGui::Separator();
+
+    ImGui::Text("Parameter Tuning:");
+    ImGui::RadioButton("Grid", &params.tuneSearch, LayoutTuner::SEARCH_GRID);
+    ImGui::SameLine();
+    ImGui::RadioButton("Bayesian", &params.tuneSearch, LayoutTuner::SEARCH_BAYESIAN);
+    ImGui::SliderInt("Layouts", &params.tuneBudget, 4, 256);
+    ImGui::SliderInt("Max Steps", &params.tuneMaxSteps, 100, 10000);
+
+    bool running = tuner && tuner->isRunning();
+    if (!running && ImGui::Button("Tune Layout")) {
+        startTuning = true;
+    }
+    if (running && ImGui::Button("Cancel Tuning")) {
+        cancelTuning = true;
+    }
+
+    if (!tuner || tuner->total() == 0) {
+        return;
+    }
+    ImGui::Text("%d / %d layouts, %.1f s", tuner->completed(), tuner->total(), tuner->elapsedSeconds());
+
+    std::vector<TuneResult> results = tuner->results();
+    if (results.empty()) {
+        return;
+    }
+    if (!running && ImGui::Button("Apply Best")) {
+        params.repulsionStrength = results[0].repulsion;
+        params.attractionStrength = results[0].attraction;
+    }
+    ImGui::Text("repulsion attraction  score  stress  len cv  cross  steps  to 5%%");
+    for (size_t r = 0; r < results.size() && r < 8; ++r) {
+        const TuneResult& result = results[r];
+        ImGui::Text("%9.2f %10.4f %6.3f %7.3f %7.3f %6.3f %6d%s %5.2f s",
+            result.repulsion, result.attraction, result.score, result.stress, result.edgeLengthCV,
+            result.crossingRate, result.steps, result.converged ? "" : "+", result.timeToQuality);
+    }
+}
+
+void GuiController::renderRasterExport() {
+    ImGui::Separator();
+
+    ImGui::Text("PNG Export:");
+    ImGui::InputInt("Width (px)", &params.pngWidth, 1024, 4096);
+    ImGui::InputInt("Height (px)", &params.pngHeight, 1024, 4096);
+    params.pngWidth = params.pngWidth < 16 ? 16 : params.pngWidth;
+    params.pngHeight = params.pngHeight < 16 ? 16 : params.pngHeight;
+    ImGui::Checkbox("Tile Pyramid (Deep Zoom)", &params.pngPyramid);
+    if (ImGui::Button("Export PNG")) {
+        exportPNG = true;
+    }
+}
+
+void GuiController::renderTelemetry() {
+    ImGui::Separator();
+
+    ImGui::Text("Convergence:");
+    if (!telemetry || telemetry->samples().empty()) {
+        ImGui::Text("No layout steps yet");
+    }
+    else {
+        const LayoutTelemetry::Sample& last = telemetry->samples().back();
+        ImGui::Text("Step %llu, %.2f s wall, %.2f s layout", last.step, last.wallSeconds, last.layoutSeconds);
+        ImGui::Checkbox("Wall Time Axis", &params.telemetryByTime);
+        ImGui::SameLine();
+        ImGui::Checkbox("Log Scale", &params.telemetryLogScale);
+
+        // Energy and force span orders of magnitude while a layout settles.
+        std::vector<float> values;
+        char overlay[64];
+        for (int m = 0; m < LayoutTelemetry::METRIC_COUNT; ++m) {
+            LayoutTelemetry::Metric metric = (LayoutTelemetry::Metric)m;
+            if (!telemetry->series(metric, params.telemetryByTime, 200, values)) continue;
+            const float latest = values.back();
+            bool logScale = params.telemetryLogScale && metric < LayoutTelemetry::METRIC_STRESS;
+            if (logScale) {
+                for (auto& value : values) value = std::log10(std::max(value, 1e-12f));
+            }
+            snprintf(overlay, sizeof(overlay), "%s%s: %.4g", LayoutTelemetry::metricName(metric), logScale ? " (log10)" : "", latest);
+            ImGui::PushID(m);
+            ImGui::PlotLines("##telemetry", values.data(), (int)values.size(), 0, overlay, FLT_MAX, FLT_MAX, ImVec2(0, 48));
+            ImGui::PopID();
+        }
+    }
+
+    if (ImGui::Button("Reset Telemetry")) {
+        resetTelemetry = true;
+    }
+    ImGui::SameLine();
+    bool logging = telemetry && telemetry->isLogging();
+    if (ImGui::Button(logging ? "Stop Log" : "Start Log")) {
+        toggleTelemetryLog = true;
+    }
+    if (logging) {
+        ImGui::Text("Logging to %s", telemetry->logPath().c_str());
+    }
+    else {
+        ImGui::SameLine();
+        ImGui::Checkbox("JSON", &params.telemetryJson);
+    }
+}
+
+void GuiController::renderOverlaps() {
+    ImGui::Separator();
+
+    ImGui::Text("Overlap Removal (XY):");
+    ImGui::Checkbox("When Layout Settles", &params.removeOverlaps);
+    ImGui::SliderFloat("Node Radius (px)", &params.overlapRadius, 1.0f, 32.0f);
+
+    bool running = overlaps && overlaps->isRunning();
+    if (running) {
+        ImGui::Text("Removing overlaps...");
+    }
+    else if (ImGui::Button("Remove Overlaps")) {
+        removeOverlapsNow = true;
+    }
+    if (overlaps && overlaps->lastStats.nodes > 0) {
+        const OverlapRemover::Stats& stats = overlaps->lastStats;
+        ImGui::Text("Last: %zu of %zu nodes moved (max %.3f), %zu + %zu constraints, %.1f ms",
+            stats.moved, stats.nodes, stats.maxMove, stats.constraintsX, stats.constraintsY, stats.seconds * 1000.0);
+    }
+}
+
+void GuiController::renderPaths() {
+    ImGui::Separator();
+
+    ImGui::Text("Shortest Paths:");
+    ImGui::SliderInt("Landmarks", &params.landmarkCount, 1, 64);
+    if (ImGui::Button("Build Distance Oracle")) {
+        buildOracle = true;
+    }
+    ImGui::InputInt("Path Source", &params.pathSource);
+    ImGui::InputInt("Path Target", &params.pathTarget);
+    if (params.pathSource < 0) params.pathSource = 0;
+    if (params.pathTarget < 0) params.pathTarget = 0;
+
+    if (!oracle || !oracle->valid()) {
+        return;
+    }
+
+    ImGui::Text("%zu landmarks over %zu nodes (%s), built in %.1f ms", oracle->landmarks().size(),
+        oracle->nodeCount(), oracle->weighted() ? "Dijkstra" : "BFS", oracle->buildMs);
+
+    // O(k) per frame, so the bounds follow the inputs as they are edited.
+    float lower, upper;
+    if (!oracle->estimate((uint32_t)params.pathSource, (uint32_t)params.pathTarget, lower, upper)) {
+        ImGui::Text("Estimate: unreachable");
+    }
+    else if (std::isinf(upper)) {
+        ImGui::Text("Estimate: >= %.3f", lower);
+    }
+    else {
+        ImGui::Text("Estimate: %.3f .. %.3f", lower, upper);
+    }
+
+    if (ImGui::Button("Find Path")) {
+        findPath = true;
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Clear Path")) {
+        clearPath = true;
+    }
+    const DistanceOracle::QueryStats& query = oracle->lastQuery;
+    if (query.hops > 0) {
+        ImGui::Text("Path: length %.3f, %zu hops, %zu nodes settled, %.2f ms",
+            query.length, query.hops, query.settled, query.milliseconds);
+    }
+}
+
 void GuiController::shutdown() {
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
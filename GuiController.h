@@ -3,6 +3,24 @@
 #include <imgui_impl_glfw.h>
 #include <imgui_impl_opengl3.h>
 
+class GraphAnalytics;
+class CommunityDetector;
+class MutationStream;
+class CompactGraph;
+class Renderer;
+class FrameScheduler;
+class ShardedLayout;
+class LayoutClient;
+class LayoutTuner;
+class LayoutTelemetry;
+class OverlapRemover;
+class DistanceOracle;
+
+enum NodeSizeMode {
+    NODE_SIZE_UNIFORM = 0,
+    NODE_SIZE_DEGREE
+};
+
 struct GuiParams {
     int nodeCount = 20;
     float edgeProbability = 0.3f;
@@ -18,11 +36,63 @@ struct GuiParams {
     bool autoLayout = true;
     bool showNodes = true;
     bool showEdges = true;
+    int nodeSizeMode = NODE_SIZE_UNIFORM;
+    float nodeRadius = 4.0f;   // pixels
+
+    bool renderOnDemand = true;
+    int maxFps = 0;   // 0 = uncapped
+
+    int bfsSource = 0;
+    int colorMode = 0;
+
+    float communityResolution = 1.0f;
+    float communityBoost = 0.0f;
+
+    bool incrementalLayout = true;
+    int mutationsPerFrame = 256;
+
+    bool compactMode = false;
+    int compactNodeCount = 50000;
+    float compactDegree = 8.0f;
+
+    int shardCount = 4;
+    bool pinWorkers = false;
+
+    int tuneSearch = 0;   // LayoutTuner::Search
+    int tuneBudget = 16;
+    int tuneMaxSteps = 2000;
+
+    int pngWidth = 8192;
+    int pngHeight = 8192;
+    bool pngPyramid = false;
+
+    bool telemetryByTime = false;   // plot against wall time instead of step count
+    bool telemetryLogScale = true;
+    bool telemetryJson = false;
+
+    bool removeOverlaps = true;    // after the layout settles
+    float overlapRadius = 4.0f;    // pixels at the current zoom, like nodeRadius
+
+    int pathSource = 0;
+    int pathTarget = 1;
+    int landmarkCount = 16;
 };
 
 class GuiController {
 public:
     GuiParams params;
+    const GraphAnalytics* analytics = nullptr;
+    const CommunityDetector* communities = nullptr;
+    const MutationStream* stream = nullptr;
+    const CompactGraph* compact = nullptr;
+    const Renderer* renderer = nullptr;
+    const FrameScheduler* scheduler = nullptr;
+    const ShardedLayout* sharded = nullptr;
+    const LayoutClient* client = nullptr;
+    const LayoutTuner* tuner = nullptr;
+    const LayoutTelemetry* telemetry = nullptr;
+    const OverlapRemover* overlaps = nullptr;
+    const DistanceOracle* oracle = nullptr;
     void initialize(GLFWwindow* window);
     void render();
     void shutdown();
@@ -32,7 +102,71 @@ public:
     bool shouldExportSVG() const { return exportSVG; }
     void resetExportFlag() { exportSVG = false; }
 
+    bool shouldExportPNG() const { return exportPNG; }
+    void resetExportPNGFlag() { exportPNG = false; }
+
+    bool shouldComputeAnalytics() const { return computeAnalytics; }
+    void resetAnalyticsFlag() { computeAnalytics = false; }
+
+    bool shouldDetectCommunities() const { return detectCommunities; }
+    void resetCommunitiesFlag() { detectCommunities = false; }
+
+    bool shouldStartSharded() const { return startSharded; }
+    void resetStartShardedFlag() { startSharded = false; }
+
+    bool shouldStopSharded() const { return stopSharded; }
+    void resetStopShardedFlag() { stopSharded = false; }
+
+    bool shouldStartTuning() const { return startTuning; }
+    void resetStartTuningFlag() { startTuning = false; }
+
+    bool shouldCancelTuning() const { return cancelTuning; }
+    void resetCancelTuningFlag() { cancelTuning = false; }
+
+    bool shouldResetTelemetry() const { return resetTelemetry; }
+    void resetResetTelemetryFlag() { resetTelemetry = false; }
+
+    bool shouldToggleTelemetryLog() const { return toggleTelemetryLog; }
+    void resetToggleTelemetryLogFlag() { toggleTelemetryLog = false; }
+
+    bool shouldRemoveOverlaps() const { return removeOverlapsNow; }
+    void resetRemoveOverlapsFlag() { removeOverlapsNow = false; }
+
+    bool shouldBuildOracle() const { return buildOracle; }
+    void resetBuildOracleFlag() { buildOracle = false; }
+
+    bool shouldFindPath() const { return findPath; }
+    void resetFindPathFlag() { findPath = false; }
+
+    bool shouldClearPath() const { return clearPath; }
+    void resetClearPathFlag() { clearPath = false; }
+
 private:
+    void renderAnalytics();
+    void renderCommunities();
+    void renderMutations();
+    void renderCompact();
+    void renderSharded();
+    void renderRemote();
+    void renderTuner();
+    void renderRasterExport();
+    void renderTelemetry();
+    void renderOverlaps();
+    void renderPaths();
+
     bool regenerate = false;
     bool exportSVG = false;
+    bool exportPNG = false;
+    bool computeAnalytics = false;
+    bool detectCommunities = false;
+    bool startSharded = false;
+    bool stopSharded = false;
+    bool startTuning = false;
+    bool cancelTuning = false;
+    bool resetTelemetry = false;
+    bool toggleTelemetryLog = false;
+    bool removeOverlapsNow = false;
+    bool buildOracle = false;
+    bool findPath = false;
+    bool clearPath = false;
 };
@@ -0,0 +1,222 @@
+#include "LayoutClient.h"
+#include "LayoutProtocol.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <sys/socket.h>
+#endif
+
+using namespace LayoutProtocol;
+
+namespace {
+#ifndef _WIN32
+    bool readFully(int fd, void* data, size_t bytes) {
+        char* p = static_cast<char*>(data);
+        while (bytes > 0) {
+            ssize_t got = recv(fd, p, bytes, 0);
+            if (got < 0 && errno == EINTR) continue;
+            if (got <= 0) return false;
+            p += got;
+            bytes -= (size_t)got;
+        }
+        return true;
+    }
+#endif
+
+    template <typename T>
+    bool take(const unsigned char*& p, const unsigned char* end, T& value) {
+        if ((size_t)(end - p) < sizeof(T)) return false;
+        std::memcpy(&value, p, sizeof(T));
+        p += sizeof(T);
+        return true;
+    }
+}
+
+LayoutClient::LayoutClient() {
+}
+
+LayoutClient::~LayoutClient() {
+    close();
+}
+
+bool LayoutClient::connect(const std::string& path) {
+    close();
+    error.clear();
+
+    int fd = connectSocket(path, error);
+    if (fd < 0) {
+        std::cout << "Cannot connect to layout server " << path << ": " << error << std::endl;
+        return false;
+    }
+
+    endpoint = path;
+    step = 0;
+    bytesReceived = 0;
+    messagesReceived = 0;
+    state = std::make_shared<State>();
+    state->fd = fd;
+    state->onReceived = onReceived;
+    reader = std::thread(readerLoop, state);
+    return true;
+}
+
+void LayoutClient::close() {
+    if (!state) return;
+#ifndef _WIN32
+    // Wakes the reader out of recv().
+    shutdown(state->fd, SHUT_RDWR);
+#endif
+    if (reader.joinable()) reader.join();
+    closeSocket(state->fd);
+    state.reset();
+}
+
+bool LayoutClient::disconnected() const {
+    if (!state) return true;
+    std::lock_guard<std::mutex> lock(state->mutex);
+    return state->eof;
+}
+
+void LayoutClient::readerLoop(std::shared_ptr<State> state) {
+#ifndef _WIN32
+    std::vector<unsigned char> payload;
+    while (true) {
+        MessageHeader header;
+        if (!readFully(state->fd, &header, sizeof(header))) break;
+        if (header.bytes > maxMessageBytes) {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->error = "oversized message";
+            break;
+        }
+        payload.resize(header.bytes);
+        if (header.bytes > 0 && !readFully(state->fd, payload.data(), header.bytes)) break;
+
+        bool ok;
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            ok = handleMessage(*state, header.type, payload);
+            state->bytes += sizeof(header) + header.bytes;
+            ++state->messages;
+            if (!ok) state->error = "malformed message";
+        }
+        if (!ok) break;
+        if (state->onReceived) state->onReceived();
+    }
+#endif
+
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->eof = true;
+    }
+    if (state->onReceived) state->onReceived();
+}
+
+bool LayoutClient::handleMessage(State& state, uint32_t type, const std::vector<unsigned char>& payload) {
+    const unsigned char* p = payload.data();
+    const unsigned char* end = p + payload.size();
+
+    if (type == MSG_TOPOLOGY) {
+        uint32_t n, m;
+        if (!take(p, end, n) || !take(p, end, m)) return false;
+        if (!take(p, end, state.origin) || !take(p, end, state.extent)) return false;
+        if ((size_t)(end - p) != (size_t)m * 2 * sizeof(uint32_t)) return false;
+        state.edges.resize((size_t)m * 2);
+        std::memcpy(state.edges.data(), p, state.edges.size() * sizeof(uint32_t));
+        for (uint32_t endpoint : state.edges) {
+            if (endpoint >= n) return false;
+        }
+        state.known.assign((size_t)n * 3, frameCentre);
+        state.isChanged.assign(n, 0);
+        state.changed.clear();
+        state.allChanged = false;
+        state.topologyPending = true;
+        return true;
+    }
+
+    if (type == MSG_FRAME) {
+        glm::vec3 origin, extent;
+        if (!take(p, end, origin) || !take(p, end, extent)) return false;
+        rebaseQuantized(state.known, state.origin, state.extent, origin, extent);
+        state.origin = origin;
+        state.extent = extent;
+        state.allChanged = true;
+        return true;
+    }
+
+    if (type == MSG_DELTA) {
+        uint64_t step;
+        uint32_t start, count;
+        if (!take(p, end, step) || !take(p, end, start) || !take(p, end, count)) return false;
+        const size_t n = state.known.size() / 3;
+        if (n == 0) return count == 0;
+
+        size_t previous = (start + n - 1) % n;
+        for (uint32_t k = 0; k < count; ++k) {
+            uint32_t gap, d[3];
+            if (!getVarint(p, end, gap) || !getVarint(p, end, d[0]) || !getVarint(p, end, d[1]) || !getVarint(p, end, d[2])) {
+                return false;
+            }
+            size_t i = (previous + 1 + gap) % n;
+            for (int a = 0; a < 3; ++a) {
+                int32_t value = (int32_t)state.known[3 * i + a] + unzigzag(d[a]);
+                state.known[3 * i + a] = (uint16_t)std::min(65535, std::max(0, value));
+            }
+            if (!state.isChanged[i]) {
+                state.isChanged[i] = 1;
+                state.changed.push_back((uint32_t)i);
+            }
+            previous = i;
+        }
+        state.step = step;
+        return p == end;
+    }
+
+    // Unknown types are skipped for forward compatibility.
+    return true;
+}
+
+bool LayoutClient::apply(Graph& graph) {
+    if (!state) return false;
+    std::lock_guard<std::mutex> lock(state->mutex);
+
+    step = state->step;
+    bytesReceived = state->bytes;
+    messagesReceived = state->messages;
+    if (!state->error.empty()) error = state->error;
+
+    const size_t n = state->known.size() / 3;
+    const bool rebuild = state->topologyPending || (graph.nodes.size() != n && !state->edges.empty());
+    if (rebuild) {
+        graph.clear();
+        graph.nodes.reserve(n);
+        for (size_t i = 0; i < n; ++i) {
+            graph.nodes.emplace_back((int)i, dequantize(&state->known[3 * i], state->origin, state->extent));
+        }
+        graph.edges.reserve(state->edges.size() / 2);
+        for (size_t e = 0; e + 1 < state->edges.size(); e += 2) {
+            graph.edges.emplace_back((int)state->edges[e], (int)state->edges[e + 1]);
+        }
+        state->topologyPending = false;
+    }
+    else if (state->allChanged) {
+        for (size_t i = 0; i < n; ++i) {
+            graph.nodes[i].position = dequantize(&state->known[3 * i], state->origin, state->extent);
+        }
+        graph.dirtyNodes.markAll();
+    }
+    else {
+        for (uint32_t i : state->changed) {
+            graph.nodes[i].position = dequantize(&state->known[3 * i], state->origin, state->extent);
+            graph.dirtyNodes.mark(i);
+        }
+    }
+
+    bool changed = rebuild || state->allChanged || !state->changed.empty();
+    for (uint32_t i : state->changed) state->isChanged[i] = 0;
+    state->changed.clear();
+    state->allChanged = false;
+    return changed;
+}
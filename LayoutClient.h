@@ -0,0 +1,65 @@
+#pragma once
+#include "Graph.h"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Viewer side of LayoutServer: a background thread reads topology and
+// position deltas from the socket, and apply() copies whatever changed into
+// a Graph on the render thread, marking only those nodes dirty so the
+// renderer re-uploads just the touched ranges.
+class LayoutClient {
+public:
+    // Called from the reader thread after a message arrived, e.g. to wake a
+    // main loop blocked waiting for events. Set before connect().
+    std::function<void()> onReceived;
+
+    LayoutClient();
+    ~LayoutClient();
+
+    bool connect(const std::string& endpoint);
+    void close();
+    bool isConnected() const { return state != nullptr; }
+
+    // Returns true if the graph changed (topology or positions).
+    bool apply(Graph& graph);
+
+    std::string endpoint;
+    std::string error;
+    unsigned long long step = 0;
+    size_t bytesReceived = 0;
+    size_t messagesReceived = 0;
+    bool disconnected() const;   // server went away; apply() keeps the last state
+
+private:
+    struct State {
+        std::mutex mutex;
+        int fd = -1;
+        bool eof = false;
+        std::string error;
+
+        bool topologyPending = false;
+        std::vector<uint32_t> edges;
+        glm::vec3 origin = glm::vec3(0.0f);
+        glm::vec3 extent = glm::vec3(1.0f);
+        std::vector<uint16_t> known;
+        std::vector<uint32_t> changed;
+        std::vector<unsigned char> isChanged;
+        bool allChanged = false;
+
+        unsigned long long step = 0;
+        size_t bytes = 0;
+        size_t messages = 0;
+        std::function<void()> onReceived;
+    };
+
+    static void readerLoop(std::shared_ptr<State> state);
+    static bool handleMessage(State& state, uint32_t type, const std::vector<unsigned char>& payload);
+
+    std::shared_ptr<State> state;
+    std::thread reader;
+};
@@ -0,0 +1,142 @@
+#include "LayoutProtocol.h"
+#include <cstdlib>
+#include <cstring>
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <cerrno>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace LayoutProtocol {
+
+#ifndef _WIN32
+
+namespace {
+    bool isUnix(const std::string& endpoint) {
+        return endpoint.compare(0, 5, "unix:") == 0;
+    }
+
+    bool unixAddress(const std::string& endpoint, sockaddr_un& address, std::string& error) {
+        std::string path = endpoint.substr(5);
+        std::memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+            error = "bad UNIX socket path: " + path;
+            return false;
+        }
+        std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+        return true;
+    }
+
+    bool tcpAddress(const std::string& endpoint, sockaddr_in& address, std::string& error) {
+        std::string host = "127.0.0.1";
+        std::string port = endpoint;
+        size_t colon = endpoint.rfind(':');
+        if (colon != std::string::npos) {
+            host = endpoint.substr(0, colon);
+            port = endpoint.substr(colon + 1);
+        }
+
+        char* end = nullptr;
+        long number = std::strtol(port.c_str(), &end, 10);
+        if (port.empty() || *end != '\0' || number <= 0 || number > 65535) {
+            error = "bad port: " + port;
+            return false;
+        }
+
+        std::memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_port = htons((uint16_t)number);
+        if (inet_pton(AF_INET, host.c_str(), &address.sin_addr) != 1) {
+            addrinfo hints;
+            std::memset(&hints, 0, sizeof(hints));
+            hints.ai_family = AF_INET;
+            addrinfo* result = nullptr;
+            if (getaddrinfo(host.c_str(), nullptr, &hints, &result) != 0 || !result) {
+                error = "unknown host: " + host;
+                return false;
+            }
+            address.sin_addr = reinterpret_cast<sockaddr_in*>(result->ai_addr)->sin_addr;
+            freeaddrinfo(result);
+        }
+        return true;
+    }
+
+    int fail(int fd, const std::string& what, std::string& error) {
+        error = what + ": " + std::strerror(errno);
+        if (fd >= 0) ::close(fd);
+        return -1;
+    }
+}
+
+int listenSocket(const std::string& endpoint, std::string& error) {
+    if (isUnix(endpoint)) {
+        sockaddr_un address;
+        if (!unixAddress(endpoint, address, error)) return -1;
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) return fail(fd, "socket", error);
+        unlink(address.sun_path);  // stale socket from an earlier run
+        if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) return fail(fd, "bind", error);
+        if (listen(fd, 16) != 0) return fail(fd, "listen", error);
+        return fd;
+    }
+
+    sockaddr_in address;
+    if (!tcpAddress(endpoint, address, error)) return -1;
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return fail(fd, "socket", error);
+    int yes = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+    if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) return fail(fd, "bind", error);
+    if (listen(fd, 16) != 0) return fail(fd, "listen", error);
+    return fd;
+}
+
+int connectSocket(const std::string& endpoint, std::string& error) {
+    if (isUnix(endpoint)) {
+        sockaddr_un address;
+        if (!unixAddress(endpoint, address, error)) return -1;
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) return fail(fd, "socket", error);
+        if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) return fail(fd, "connect", error);
+        return fd;
+    }
+
+    sockaddr_in address;
+    if (!tcpAddress(endpoint, address, error)) return -1;
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return fail(fd, "socket", error);
+    if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) return fail(fd, "connect", error);
+    int yes = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+    return fd;
+}
+
+void closeSocket(int fd) {
+    if (fd >= 0) ::close(fd);
+}
+
+#else
+
+int listenSocket(const std::string&, std::string& error) {
+    error = "layout server needs POSIX sockets";
+    return -1;
+}
+
+int connectSocket(const std::string&, std::string& error) {
+    error = "layout client needs POSIX sockets";
+    return -1;
+}
+
+void closeSocket(int) {
+}
+
+#endif
+
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Wire format shared by LayoutServer and LayoutClient. Every message is a
+// MessageHeader followed by `bytes` of payload, in host byte order (both
+// ends run on the same machine).
+//
+//   TOPOLOGY  u32 nodes, u32 edges, f32 origin[3], f32 extent[3], u32 pairs[2 * edges]
+//             Resets the client; every node starts at the centre of the frame.
+//   FRAME     f32 origin[3], f32 extent[3]
+//             New quantization box. Both ends re-quantize what the client
+//             holds with rebaseQuantized(), so nothing is resent.
+//   DELTA     u64 step, u32 start, u32 count, then per node
+//             varint gap, zigzag varint dx, dy, dz
+//             The node index is (previous + 1 + gap) mod nodes, starting
+//             from previous = start - 1; d* are 16-bit quantized deltas.
+namespace LayoutProtocol {
+    enum MessageType : uint32_t {
+        MSG_TOPOLOGY = 1,
+        MSG_FRAME = 2,
+        MSG_DELTA = 3
+    };
+
+    struct MessageHeader {
+        uint32_t type;
+        uint32_t bytes;
+    };
+
+    const uint32_t maxMessageBytes = 1u << 30;
+    const uint16_t frameCentre = 32768;
+
+    inline uint16_t quantize(float value, float origin, float extent) {
+        float t = (value - origin) / extent * 65535.0f + 0.5f;
+        return (uint16_t)std::min(65535.0f, std::max(0.0f, t));
+    }
+
+    inline float dequantize(uint16_t value, float origin, float extent) {
+        return origin + value * (extent / 65535.0f);
+    }
+
+    inline glm::vec3 dequantize(const uint16_t* q, const glm::vec3& origin, const glm::vec3& extent) {
+        return glm::vec3(dequantize(q[0], origin.x, extent.x),
+            dequantize(q[1], origin.y, extent.y),
+            dequantize(q[2], origin.z, extent.z));
+    }
+
+    // Moves quantized positions from one box to another in place.
+    inline void rebaseQuantized(std::vector<uint16_t>& q, const glm::vec3& oldOrigin, const glm::vec3& oldExtent,
+        const glm::vec3& newOrigin, const glm::vec3& newExtent) {
+        for (size_t i = 0; i + 2 < q.size(); i += 3) {
+            for (int a = 0; a < 3; ++a) {
+                q[i + a] = quantize(dequantize(q[i + a], oldOrigin[a], oldExtent[a]), newOrigin[a], newExtent[a]);
+            }
+        }
+    }
+
+    inline void putVarint(std::string& out, uint32_t value) {
+        while (value >= 0x80) {
+            out.push_back((char)(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back((char)value);
+    }
+
+    inline bool getVarint(const unsigned char*& p, const unsigned char* end, uint32_t& value) {
+        value = 0;
+        for (int shift = 0; shift < 35 && p < end; shift += 7) {
+            unsigned char byte = *p++;
+            value |= (uint32_t)(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) return true;
+        }
+        return false;
+    }
+
+    inline uint32_t zigzag(int32_t value) {
+        return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+    }
+
+    inline int32_t unzigzag(uint32_t value) {
+        return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+    }
+
+    template <typename T>
+    void put(std::string& out, const T& value) {
+        out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    // Endpoints: "unix:<path>" for a UNIX socket, otherwise "[host:]port"
+    // over TCP (host defaults to 127.0.0.1). Return a socket or -1 with
+    // `error` set.
+    int listenSocket(const std::string& endpoint, std::string& error);
+    int connectSocket(const std::string& endpoint, std::string& error);
+    void closeSocket(int fd);
+}
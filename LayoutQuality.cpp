@@ -0,0 +1,187 @@
+#include "LayoutQuality.h"
+#include "Graph.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+
+namespace {
+    // Both use only x and y: crossings are counted in the XY projection.
+    float orientation(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c) {
+        return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+    }
+
+    // Proper crossing only; touching or collinear segments do not count.
+    bool segmentsCross(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, const glm::vec3& d) {
+        float d1 = orientation(a, b, c);
+        float d2 = orientation(a, b, d);
+        float d3 = orientation(c, d, a);
+        float d4 = orientation(c, d, b);
+        return ((d1 > 0 && d2 < 0) || (d1 < 0 && d2 > 0)) && ((d3 > 0 && d4 < 0) || (d3 < 0 && d4 > 0));
+    }
+
+    // position(i) -> glm::vec3, endpoints(e, from, to); shared by Graph and
+    // flat position arrays.
+    template <typename PositionOf, typename EndpointsOf>
+    void measureLayout(const PositionOf& position, const EndpointsOf& endpoints, size_t n, size_t m,
+                       const std::vector<uint32_t>& pivotNodes, const std::vector<std::vector<int>>& pivotDistances,
+                       const std::vector<std::pair<uint32_t, uint32_t>>& edgePairs, QualityScores& scores) {
+        // Stress with the best uniform scale s: the sum of (s x/d - 1)^2 over
+        // the pivot pairs is smallest at s = A/B with A = sum x/d and
+        // B = sum x^2/d^2, where it equals count - A^2/B.
+        double sumA = 0.0, sumB = 0.0;
+        size_t pairs = 0;
+        for (size_t p = 0; p < pivotNodes.size(); ++p) {
+            const glm::vec3 origin = position(pivotNodes[p]);
+            const std::vector<int>& distance = pivotDistances[p];
+            for (size_t j = 0; j < n; ++j) {
+                if (distance[j] <= 0) continue;
+                double ratio = glm::length(position(j) - origin) / distance[j];
+                sumA += ratio;
+                sumB += ratio * ratio;
+                ++pairs;
+            }
+        }
+        scores.stress = pairs > 0 && sumB > 0.0 ? (float)(1.0 - sumA * sumA / (sumB * pairs)) : 0.0f;
+        // A layout that blew up must not look perfect.
+        const float infinity = std::numeric_limits<float>::infinity();
+        if (!std::isfinite(sumB)) scores.stress = infinity;
+
+        double sum = 0.0, sumSquares = 0.0;
+        uint32_t from, to;
+        for (size_t e = 0; e < m; ++e) {
+            endpoints(e, from, to);
+            double length = glm::length(position(to) - position(from));
+            sum += length;
+            sumSquares += length * length;
+        }
+        scores.edgeLengthMean = m > 0 ? (float)(sum / m) : 0.0f;
+        scores.edgeLengthCV = 0.0f;
+        if (m > 0 && sum > 0.0) {
+            double mean = sum / m;
+            double variance = std::max(0.0, sumSquares / m - mean * mean);
+            scores.edgeLengthCV = (float)(std::sqrt(variance) / mean);
+        }
+        if (!std::isfinite(sumSquares)) {
+            scores.edgeLengthMean = infinity;
+            scores.edgeLengthCV = infinity;
+        }
+
+        size_t crossings = 0;
+        uint32_t from2, to2;
+        for (const auto& pair : edgePairs) {
+            endpoints(pair.first, from, to);
+            endpoints(pair.second, from2, to2);
+            if (segmentsCross(position(from), position(to), position(from2), position(to2))) {
+                ++crossings;
+            }
+        }
+        scores.crossingRate = edgePairs.empty() ? 0.0f : (float)crossings / edgePairs.size();
+    }
+}
+
+void LayoutQuality::prepare(const Graph& graph) {
+    std::vector<uint32_t> edgeIndices;
+    edgeIndices.reserve(graph.edges.size() * 2);
+    for (const auto& edge : graph.edges) {
+        edgeIndices.push_back((uint32_t)edge.from);
+        edgeIndices.push_back((uint32_t)edge.to);
+    }
+    prepareFromPairs(graph.nodes.size(), edgeIndices);
+}
+
+void LayoutQuality::prepare(size_t nodeCount, const std::vector<uint32_t>& edgeIndices) {
+    prepareFromPairs(nodeCount, edgeIndices);
+}
+
+void LayoutQuality::clear() {
+    pivotNodes.clear();
+    pivotDistances.clear();
+    edgePairs.clear();
+    preparedNodes = 0;
+    preparedEdges = 0;
+}
+
+void LayoutQuality::prepareFromPairs(size_t nodeCount, const std::vector<uint32_t>& edgeIndices) {
+    const size_t n = nodeCount;
+    const size_t m = edgeIndices.size() / 2;
+    std::mt19937 rng(seed);
+
+    std::vector<size_t> offsets(n + 1, 0);
+    for (size_t e = 0; e < m; ++e) {
+        offsets[edgeIndices[2 * e] + 1]++;
+        offsets[edgeIndices[2 * e + 1] + 1]++;
+    }
+    for (size_t i = 0; i < n; ++i) offsets[i + 1] += offsets[i];
+    std::vector<uint32_t> neighbors(offsets[n]);
+    std::vector<size_t> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t e = 0; e < m; ++e) {
+        uint32_t from = edgeIndices[2 * e], to = edgeIndices[2 * e + 1];
+        neighbors[fill[from]++] = to;
+        neighbors[fill[to]++] = from;
+    }
+
+    std::vector<uint32_t> order(n);
+    for (size_t i = 0; i < n; ++i) order[i] = (uint32_t)i;
+    std::shuffle(order.begin(), order.end(), rng);
+    pivotNodes.assign(order.begin(), order.begin() + std::min(n, (size_t)std::max(1, pivots)));
+
+    pivotDistances.assign(pivotNodes.size(), std::vector<int>());
+    std::vector<uint32_t> queue(n);
+    for (size_t p = 0; p < pivotNodes.size(); ++p) {
+        std::vector<int>& distance = pivotDistances[p];
+        distance.assign(n, -1);
+        size_t head = 0, tail = 0;
+        distance[pivotNodes[p]] = 0;
+        queue[tail++] = pivotNodes[p];
+        while (head < tail) {
+            uint32_t v = queue[head++];
+            for (size_t k = offsets[v]; k < offsets[v + 1]; ++k) {
+                uint32_t w = neighbors[k];
+                if (distance[w] < 0) {
+                    distance[w] = distance[v] + 1;
+                    queue[tail++] = w;
+                }
+            }
+        }
+    }
+
+    edgePairs.clear();
+    if (m >= 2) {
+        std::uniform_int_distribution<size_t> pick(0, m - 1);
+        for (int attempt = 0; attempt < crossingSamples * 4 && (int)edgePairs.size() < crossingSamples; ++attempt) {
+            size_t a = pick(rng), b = pick(rng);
+            uint32_t af = edgeIndices[2 * a], at = edgeIndices[2 * a + 1];
+            uint32_t bf = edgeIndices[2 * b], bt = edgeIndices[2 * b + 1];
+            if (a == b || af == bf || af == bt || at == bf || at == bt) continue;
+            edgePairs.push_back(std::make_pair((uint32_t)a, (uint32_t)b));
+        }
+    }
+
+    preparedNodes = n;
+    preparedEdges = m;
+}
+
+void LayoutQuality::measure(const Graph& graph, QualityScores& scores) const {
+    const std::vector<Node>& nodes = graph.nodes;
+    const std::vector<Edge>& edges = graph.edges;
+    if (nodes.size() != preparedNodes || edges.size() != preparedEdges) {
+        scores = QualityScores();
+        return;
+    }
+    measureLayout([&](size_t i) { return nodes[i].position; },
+                  [&](size_t e, uint32_t& from, uint32_t& to) { from = (uint32_t)edges[e].from; to = (uint32_t)edges[e].to; },
+                  nodes.size(), edges.size(),
+                  pivotNodes, pivotDistances, edgePairs, scores);
+}
+
+void LayoutQuality::measure(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& edgeIndices, QualityScores& scores) const {
+    if (positions.size() != preparedNodes || edgeIndices.size() / 2 != preparedEdges) {
+        scores = QualityScores();
+        return;
+    }
+    measureLayout([&](size_t i) { return positions[i]; },
+                  [&](size_t e, uint32_t& from, uint32_t& to) { from = edgeIndices[2 * e]; to = edgeIndices[2 * e + 1]; },
+                  positions.size(), edgeIndices.size() / 2,
+                  pivotNodes, pivotDistances, edgePairs, scores);
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+class Graph;
+
+struct QualityScores {
+    float stress = 0.0f;           // after the best uniform scaling; 0 = distances match hop counts
+    float edgeLengthMean = 0.0f;
+    float edgeLengthCV = 0.0f;     // standard deviation / mean
+    float crossingRate = 0.0f;     // share of sampled edge pairs that cross in XY
+};
+
+// Sampled layout quality measures, cheap enough to take every few dozen
+// steps of a large layout:
+//   - stress against hop distances from a few random pivot nodes,
+//   - mean and coefficient of variation of the edge lengths,
+//   - the share of sampled non-adjacent edge pairs that cross in the XY
+//     projection.
+// prepare() runs the pivot BFSs and draws the edge pairs once per topology;
+// measure() only reads positions.
+class LayoutQuality {
+public:
+    int pivots = 16;
+    int crossingSamples = 20000;
+    unsigned int seed = 1;
+
+    void prepare(const Graph& graph);
+    void prepare(size_t nodeCount, const std::vector<uint32_t>& edgeIndices);   // from0, to0, from1, to1, ...
+    void clear();
+
+    // Size of the topology prepare() last saw.
+    size_t nodeCount() const { return preparedNodes; }
+    size_t edgeCount() const { return preparedEdges; }
+
+    // Zero scores if the topology no longer matches the prepared one.
+    void measure(const Graph& graph, QualityScores& scores) const;
+    void measure(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& edgeIndices, QualityScores& scores) const;
+
+private:
+    void prepareFromPairs(size_t nodeCount, const std::vector<uint32_t>& edgeIndices);
+
+    std::vector<uint32_t> pivotNodes;
+    std::vector<std::vector<int>> pivotDistances;
+    std::vector<std::pair<uint32_t, uint32_t>> edgePairs;
+    size_t preparedNodes = 0;
+    size_t preparedEdges = 0;
+};
@@ -0,0 +1,283 @@
+#include "LayoutServer.h"
+#include "LayoutProtocol.h"
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+using namespace LayoutProtocol;
+
+LayoutServer::LayoutServer() {
+}
+
+LayoutServer::~LayoutServer() {
+    close();
+}
+
+bool LayoutServer::listen(const std::string& endpoint) {
+    close();
+    error.clear();
+
+    listenFd = listenSocket(endpoint, error);
+    if (listenFd < 0) return false;
+#ifndef _WIN32
+    fcntl(listenFd, F_SETFL, fcntl(listenFd, F_GETFL) | O_NONBLOCK);
+#endif
+    if (endpoint.compare(0, 5, "unix:") == 0) unixPath = endpoint.substr(5);
+    return true;
+}
+
+void LayoutServer::close() {
+    for (auto& client : clients) closeSocket(client.fd);
+    clients.clear();
+    if (listenFd >= 0) {
+        closeSocket(listenFd);
+        listenFd = -1;
+    }
+#ifndef _WIN32
+    if (!unixPath.empty()) unlink(unixPath.c_str());
+#endif
+    unixPath.clear();
+    frameValid = false;
+    lastPublish = -1.0;
+}
+
+void LayoutServer::acceptClients() {
+#ifndef _WIN32
+    while (true) {
+        int fd = accept(listenFd, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                std::cerr << "layout server: accept failed: " << std::strerror(errno) << std::endl;
+            }
+            return;
+        }
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        if (unixPath.empty()) {
+            int yes = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+        }
+        Client client;
+        client.fd = fd;
+        clients.push_back(std::move(client));
+    }
+#endif
+}
+
+bool LayoutServer::flush(Client& client) {
+#ifndef _WIN32
+    while (client.outOffset < client.out.size()) {
+        ssize_t sent = send(client.fd, client.out.data() + client.outOffset, client.out.size() - client.outOffset,
+            MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (sent < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            return false;
+        }
+        client.outOffset += (size_t)sent;
+        bytesSent += (size_t)sent;
+    }
+#endif
+    if (client.outOffset == client.out.size()) {
+        client.out.clear();
+        client.outOffset = 0;
+    }
+    return true;
+}
+
+void LayoutServer::beginMessage(std::string& out, uint32_t type, size_t& start) {
+    start = out.size();
+    MessageHeader header = { type, 0 };
+    put(out, header);
+}
+
+void LayoutServer::endMessage(std::string& out, size_t start) {
+    uint32_t bytes = (uint32_t)(out.size() - start - sizeof(MessageHeader));
+    std::memcpy(&out[start + offsetof(MessageHeader, bytes)], &bytes, sizeof(bytes));
+}
+
+bool LayoutServer::updateFrame(const Graph& graph) {
+    if (graph.nodes.empty()) return false;
+
+    glm::vec3 lo = graph.nodes[0].position, hi = lo;
+    for (const auto& node : graph.nodes) {
+        lo = glm::min(lo, node.position);
+        hi = glm::max(hi, node.position);
+    }
+    glm::vec3 size = hi - lo;
+    float largest = glm::max(glm::max(size.x, size.y), size.z);
+
+    // Keep the box while the layout stays inside it and still uses a fair
+    // share of its resolution; every change costs the clients precision.
+    if (frameValid) {
+        glm::vec3 frameEnd = frameOrigin + frameExtent;
+        bool inside = true;
+        for (int a = 0; a < 3; ++a) {
+            if (lo[a] < frameOrigin[a] || hi[a] > frameEnd[a]) inside = false;
+        }
+        float frameLargest = glm::max(glm::max(frameExtent.x, frameExtent.y), frameExtent.z);
+        if (inside && largest > frameLargest * 0.25f) return false;
+    }
+
+    float margin = largest * 0.25f + 1e-3f;
+    frameOrigin = lo - glm::vec3(margin);
+    frameExtent = size + glm::vec3(2.0f * margin);
+    frameValid = true;
+    return true;
+}
+
+void LayoutServer::sendTopology(Client& client, const Graph& graph) {
+    const uint32_t n = (uint32_t)graph.nodes.size();
+    const uint32_t m = (uint32_t)graph.edges.size();
+    client.known.assign((size_t)n * 3, frameCentre);
+    client.cursor = 0;
+
+    size_t start;
+    beginMessage(client.out, MSG_TOPOLOGY, start);
+    put(client.out, n);
+    put(client.out, m);
+    put(client.out, frameOrigin);
+    put(client.out, frameExtent);
+    for (const auto& edge : graph.edges) {
+        put(client.out, (uint32_t)edge.from);
+        put(client.out, (uint32_t)edge.to);
+    }
+    endMessage(client.out, start);
+}
+
+void LayoutServer::sendDelta(Client& client, unsigned long long step) {
+    const size_t n = client.known.size() / 3;
+    if (n == 0) return;
+
+    uint32_t threshold[3];
+    for (int a = 0; a < 3; ++a) {
+        threshold[a] = (uint32_t)(epsilon / frameExtent[a] * 65535.0f);
+    }
+    size_t budget = std::min((size_t)client.budget, maxDeltaBytes);
+
+    std::string& out = client.out;
+    size_t start;
+    beginMessage(out, MSG_DELTA, start);
+    put(out, (uint64_t)step);
+    put(out, (uint32_t)client.cursor);
+    size_t countAt = out.size();
+    put(out, (uint32_t)0);
+
+    uint32_t count = 0;
+    size_t previous = client.cursor + n - 1;
+    size_t resume = client.cursor;
+    for (size_t k = 0; k < n; ++k) {
+        size_t i = client.cursor + k;
+        if (i >= n) i -= n;
+        const uint16_t* q = &target[3 * i];
+        uint16_t* known = &client.known[3 * i];
+        int32_t d[3];
+        bool moved = false;
+        for (int a = 0; a < 3; ++a) {
+            d[a] = (int32_t)q[a] - (int32_t)known[a];
+            if ((uint32_t)std::abs(d[a]) > threshold[a]) moved = true;
+        }
+        if (!moved) continue;
+
+        if (out.size() - start >= budget) {
+            resume = i;
+            break;
+        }
+        putVarint(out, (uint32_t)((i + n - previous - 1) % n));
+        for (int a = 0; a < 3; ++a) {
+            putVarint(out, zigzag(d[a]));
+            known[a] = q[a];
+        }
+        previous = i;
+        ++count;
+    }
+
+    if (count == 0) {
+        out.resize(start);
+        return;
+    }
+    std::memcpy(&out[countAt], &count, sizeof(count));
+    endMessage(out, start);
+
+    client.cursor = resume;
+    client.budget -= (double)(out.size() - start);
+    lastDeltaNodes = std::max(lastDeltaNodes, (size_t)count);
+    ++framesSent;
+}
+
+void LayoutServer::publish(const Graph& graph, unsigned long long step, double now) {
+    if (listenFd < 0) return;
+
+    double elapsed = lastPublish < 0.0 ? 0.0 : now - lastPublish;
+    lastPublish = now;
+    size_t firstNew = clients.size();
+    acceptClients();
+
+    // Clients already hold the topology unless it changed; an empty graph has
+    // no frame yet, which is no reason to send it again.
+    if (graph.topologyVersion != publishedTopology) {
+        publishedTopology = graph.topologyVersion;
+        frameValid = false;
+        updateFrame(graph);
+        for (size_t c = 0; c < firstNew; ++c) sendTopology(clients[c], graph);
+    }
+    else {
+        glm::vec3 oldOrigin = frameOrigin, oldExtent = frameExtent;
+        if (updateFrame(graph)) {
+            for (size_t c = 0; c < firstNew; ++c) {
+                Client& client = clients[c];
+                rebaseQuantized(client.known, oldOrigin, oldExtent, frameOrigin, frameExtent);
+                size_t start;
+                beginMessage(client.out, MSG_FRAME, start);
+                put(client.out, frameOrigin);
+                put(client.out, frameExtent);
+                endMessage(client.out, start);
+            }
+        }
+    }
+    for (size_t c = firstNew; c < clients.size(); ++c) sendTopology(clients[c], graph);
+
+    const size_t n = graph.nodes.size();
+    target.resize(n * 3);
+    for (size_t i = 0; i < n; ++i) {
+        for (int a = 0; a < 3; ++a) {
+            target[3 * i + a] = quantize(graph.nodes[i].position[a], frameOrigin[a], frameExtent[a]);
+        }
+    }
+
+    // Up to a quarter second of unused budget carries over.
+    const double maxBudget = std::max((double)maxDeltaBytes, bytesPerSecond * 0.25);
+    lastDeltaNodes = 0;
+    for (auto& client : clients) {
+        if (!flush(client)) {
+            client.closed = true;
+            continue;
+        }
+        client.budget = std::min(maxBudget, client.budget + bytesPerSecond * elapsed);
+        if (client.outOffset < client.out.size() || client.budget < 64.0) {
+            ++framesSkipped;
+            continue;
+        }
+        sendDelta(client, step);
+        if (!flush(client)) client.closed = true;
+    }
+
+    for (size_t c = 0; c < clients.size();) {
+        if (clients[c].closed) {
+            closeSocket(clients[c].fd);
+            clients.erase(clients.begin() + c);
+        }
+        else {
+            ++c;
+        }
+    }
+}
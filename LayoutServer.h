@@ -0,0 +1,72 @@
+#pragma once
+#include "Graph.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Publishes a running layout to any number of local viewers (see
+// LayoutProtocol.h for the wire format). New clients get the topology once;
+// after that each publish() sends every client only the nodes that moved by
+// more than `epsilon` since what that client last received, as 16-bit
+// quantized deltas.
+//
+// Each client has a byte budget of bytesPerSecond. A delta stops when the
+// budget is spent and the next one resumes from that node, so bandwidth per
+// client stays the same however large the graph is; big graphs just take
+// more steps to reach a viewer. A client that has not drained its socket
+// skips frames until it catches up; its pending changes are merged into the
+// next delta it receives.
+class LayoutServer {
+public:
+    float epsilon = 0.01f;                 // world units
+    size_t bytesPerSecond = 4 << 20;
+    size_t maxDeltaBytes = 256 << 10;
+
+    size_t bytesSent = 0;
+    unsigned long long framesSent = 0;
+    unsigned long long framesSkipped = 0;
+    size_t lastDeltaNodes = 0;             // largest delta of the last publish
+
+    LayoutServer();
+    ~LayoutServer();
+
+    bool listen(const std::string& endpoint);
+    void close();
+    bool isListening() const { return listenFd >= 0; }
+    size_t clientCount() const { return clients.size(); }
+
+    // Accepts pending connections and sends the current positions; `now` in
+    // seconds drives the per-client budgets.
+    void publish(const Graph& graph, unsigned long long step, double now);
+
+    std::string error;
+
+private:
+    struct Client {
+        int fd = -1;
+        std::vector<uint16_t> known;   // what the client holds, quantized
+        std::string out;               // queued bytes not yet accepted by the socket
+        size_t outOffset = 0;
+        size_t cursor = 0;             // node the next delta starts at
+        double budget = 0.0;
+        bool closed = false;
+    };
+
+    void acceptClients();
+    void sendTopology(Client& client, const Graph& graph);
+    void sendDelta(Client& client, unsigned long long step);
+    bool flush(Client& client);
+    bool updateFrame(const Graph& graph);
+    static void beginMessage(std::string& out, uint32_t type, size_t& start);
+    static void endMessage(std::string& out, size_t start);
+
+    int listenFd = -1;
+    std::string unixPath;
+    std::vector<Client> clients;
+    unsigned long long publishedTopology = 0;   // topology the clients hold
+    bool frameValid = false;                    // frameOrigin/Extent cover the nodes
+    glm::vec3 frameOrigin = glm::vec3(0.0f);
+    glm::vec3 frameExtent = glm::vec3(1.0f);
+    std::vector<uint16_t> target;      // current positions, quantized
+    double lastPublish = -1.0;
+};
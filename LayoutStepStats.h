@@ -0,0 +1,13 @@
+#pragma once
+#include <cstddef>
+
+// What one force-directed layout step did. Graph and CompactGraph fill this
+// in their integration loops from values they compute anyway, so it costs
+// a few additions per node and no extra pass.
+struct LayoutStepStats {
+    double kineticEnergy = 0.0;      // sum of |v|^2 / 2 after the step, unit masses
+    double totalForce = 0.0;         // sum of |force| the step integrated
+    float maxDisplacement = 0.0f;
+    double meanDisplacement = 0.0;
+    size_t nodes = 0;
+};
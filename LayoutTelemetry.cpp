@@ -0,0 +1,239 @@
+#include "LayoutTelemetry.h"
+#include "Graph.h"
+#include "CompactGraph.h"
+#include <cmath>
+#include <cstdio>
+
+namespace {
+    bool endsWith(const std::string& text, const char* suffix) {
+        size_t length = std::char_traits<char>::length(suffix);
+        return text.size() >= length && text.compare(text.size() - length, length, suffix) == 0;
+    }
+
+    // Fixed format with enough digits to tell converging runs apart; JSON
+    // has no NaN or infinity, so a layout that blew up logs null.
+    void writeNumber(std::ostream& out, double value) {
+        if (!std::isfinite(value)) {
+            out << "null";
+            return;
+        }
+        char text[32];
+        std::snprintf(text, sizeof(text), "%.9g", value);
+        out << text;
+    }
+}
+
+LayoutTelemetry::LayoutTelemetry() {
+    quality.pivots = 8;
+    quality.crossingSamples = 5000;
+    reset();
+}
+
+LayoutTelemetry::~LayoutTelemetry() {
+    closeLog();
+}
+
+bool LayoutTelemetry::openLog(const std::string& logFile) {
+    closeLog();
+    error.clear();
+    log.open(logFile, std::ios::trunc);
+    if (!log.is_open()) {
+        error = "cannot create " + logFile;
+        return false;
+    }
+    path = logFile;
+    json = endsWith(logFile, ".json") || endsWith(logFile, ".jsonl");
+    if (!json) {
+        log << "run,step,wall_seconds,layout_seconds,kinetic_energy,max_displacement,mean_displacement,total_force,"
+               "stress,edge_length_mean,edge_length_cv,crossing_rate\n";
+    }
+    return true;
+}
+
+void LayoutTelemetry::closeLog() {
+    if (log.is_open()) log.close();
+    path.clear();
+}
+
+void LayoutTelemetry::reset() {
+    started = Clock::now();
+    steps = 0;
+    layoutSeconds = 0.0;
+    history.clear();
+    qualityHistory.clear();
+    quality.clear();
+    ++run;
+}
+
+LayoutTelemetry::Sample LayoutTelemetry::next(const LayoutStepStats& stats, double stepSeconds) {
+    layoutSeconds += stepSeconds;
+    Sample sample;
+    sample.step = ++steps;
+    sample.wallSeconds = std::chrono::duration<double>(Clock::now() - started).count();
+    sample.layoutSeconds = layoutSeconds;
+    sample.stats = stats;
+    return sample;
+}
+
+// The first step gives the starting quality, then every qualityInterval.
+bool LayoutTelemetry::qualityDue() const {
+    return qualityInterval > 0 && (steps - 1) % (unsigned long long)qualityInterval == 0;
+}
+
+void LayoutTelemetry::record(const Graph& graph, double stepSeconds) {
+    Sample sample = next(graph.lastStepStats, stepSeconds);
+    if (qualityDue()) {
+        if (quality.nodeCount() != graph.nodes.size() || quality.edgeCount() != graph.edges.size()
+            || preparedVersion != graph.topologyVersion) {
+            quality.prepare(graph);
+            preparedVersion = graph.topologyVersion;
+        }
+        quality.measure(graph, sample.quality);
+        sample.hasQuality = true;
+    }
+    add(sample);
+}
+
+void LayoutTelemetry::record(const CompactGraph& graph, double stepSeconds) {
+    Sample sample = next(graph.lastStepStats, stepSeconds);
+    if (qualityDue()) {
+        // CompactGraph has no topology version: a new graph of the same size
+        // is caught by reset(), a Graph run by the version mismatch.
+        if (quality.nodeCount() != graph.nodeCount() || quality.edgeCount() != graph.edgeCount()
+            || preparedVersion != ~0ull) {
+            quality.prepare(graph.nodeCount(), graph.edgeIndices);
+            preparedVersion = ~0ull;
+        }
+        quality.measure(graph.positions, graph.edgeIndices, sample.quality);
+        sample.hasQuality = true;
+    }
+    add(sample);
+}
+
+namespace {
+    // Keeps every other sample, so a long run stays covered end to end.
+    void append(std::vector<LayoutTelemetry::Sample>& samples, const LayoutTelemetry::Sample& sample, size_t limit) {
+        if (limit > 0 && samples.size() >= limit) {
+            size_t kept = 0;
+            for (size_t i = 0; i < samples.size(); i += 2) samples[kept++] = samples[i];
+            samples.resize(kept);
+        }
+        samples.push_back(sample);
+    }
+}
+
+void LayoutTelemetry::add(const Sample& sample) {
+    append(history, sample, historyLimit);
+    if (sample.hasQuality) append(qualityHistory, sample, historyLimit);
+    if (log.is_open()) write(sample);
+}
+
+void LayoutTelemetry::write(const Sample& sample) {
+    const LayoutStepStats& stats = sample.stats;
+    if (json) {
+        log << "{\"run\":" << run << ",\"step\":" << sample.step << ",\"wall_seconds\":";
+        writeNumber(log, sample.wallSeconds);
+        log << ",\"layout_seconds\":";
+        writeNumber(log, sample.layoutSeconds);
+        log << ",\"kinetic_energy\":";
+        writeNumber(log, stats.kineticEnergy);
+        log << ",\"max_displacement\":";
+        writeNumber(log, stats.maxDisplacement);
+        log << ",\"mean_displacement\":";
+        writeNumber(log, stats.meanDisplacement);
+        log << ",\"total_force\":";
+        writeNumber(log, stats.totalForce);
+        if (sample.hasQuality) {
+            log << ",\"stress\":";
+            writeNumber(log, sample.quality.stress);
+            log << ",\"edge_length_mean\":";
+            writeNumber(log, sample.quality.edgeLengthMean);
+            log << ",\"edge_length_cv\":";
+            writeNumber(log, sample.quality.edgeLengthCV);
+            log << ",\"crossing_rate\":";
+            writeNumber(log, sample.quality.crossingRate);
+        }
+        log << "}\n";
+    }
+    else {
+        log << run << ',' << sample.step << ',';
+        writeNumber(log, sample.wallSeconds);
+        log << ',';
+        writeNumber(log, sample.layoutSeconds);
+        log << ',';
+        writeNumber(log, stats.kineticEnergy);
+        log << ',';
+        writeNumber(log, stats.maxDisplacement);
+        log << ',';
+        writeNumber(log, stats.meanDisplacement);
+        log << ',';
+        writeNumber(log, stats.totalForce);
+        if (sample.hasQuality) {
+            log << ',';
+            writeNumber(log, sample.quality.stress);
+            log << ',';
+            writeNumber(log, sample.quality.edgeLengthMean);
+            log << ',';
+            writeNumber(log, sample.quality.edgeLengthCV);
+            log << ',';
+            writeNumber(log, sample.quality.crossingRate);
+            log << '\n';
+        }
+        else {
+            log << ",,,,\n";
+        }
+    }
+    // Quality samples are rare enough to flush, so a log can be followed
+    // while the layout runs.
+    if (sample.hasQuality) log.flush();
+}
+
+bool LayoutTelemetry::series(Metric metric, bool byWallTime, int count, std::vector<float>& values) const {
+    values.clear();
+    const std::vector<Sample>& points = metric >= METRIC_STRESS ? qualityHistory : history;
+    if (points.empty() || count <= 0) return false;
+
+    auto value = [metric](const Sample& sample) -> float {
+        switch (metric) {
+        case METRIC_KINETIC_ENERGY: return (float)sample.stats.kineticEnergy;
+        case METRIC_MAX_DISPLACEMENT: return sample.stats.maxDisplacement;
+        case METRIC_MEAN_DISPLACEMENT: return (float)sample.stats.meanDisplacement;
+        case METRIC_TOTAL_FORCE: return (float)sample.stats.totalForce;
+        case METRIC_STRESS: return sample.quality.stress;
+        case METRIC_EDGE_LENGTH_MEAN: return sample.quality.edgeLengthMean;
+        case METRIC_EDGE_LENGTH_CV: return sample.quality.edgeLengthCV;
+        case METRIC_CROSSING_RATE: return sample.quality.crossingRate;
+        default: return 0.0f;
+        }
+    };
+    auto position = [byWallTime](const Sample& sample) {
+        return byWallTime ? sample.wallSeconds : (double)sample.step;
+    };
+
+    // The x range is the whole run, so quality plots line up with the
+    // per-step ones.
+    const double first = position(history.front());
+    const double last = position(history.back());
+    values.resize((size_t)count);
+    size_t k = 0;
+    for (int i = 0; i < count; ++i) {
+        double x = count > 1 ? first + (last - first) * i / (count - 1) : last;
+        while (k + 1 < points.size() && position(points[k + 1]) <= x) ++k;
+        values[(size_t)i] = value(points[k]);
+    }
+    return true;
+}
+
+const char* LayoutTelemetry::metricName(Metric metric) {
+    switch (metric) {
+    case METRIC_KINETIC_ENERGY: return "Kinetic Energy";
+    case METRIC_MAX_DISPLACEMENT: return "Max Displacement";
+    case METRIC_MEAN_DISPLACEMENT: return "Mean Displacement";
+    case METRIC_TOTAL_FORCE: return "Total Force";
+    case METRIC_STRESS: return "Stress";
+    case METRIC_EDGE_LENGTH_MEAN: return "Edge Length Mean";
+    case METRIC_EDGE_LENGTH_CV: return "Edge Length CV";
+    case METRIC_CROSSING_RATE: return "Crossing Rate";
+    default: return "";
+    }
+}
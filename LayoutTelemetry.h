@@ -0,0 +1,95 @@
+#pragma once
+#include "LayoutQuality.h"
+#include "LayoutStepStats.h"
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <vector>
+
+class Graph;
+class CompactGraph;
+
+// Convergence record of a layout run, for comparing layout engines and
+// parameters by time-to-quality. record() is called after every layout
+// step with that step's compute time; it stores the step's LayoutStepStats
+// and, every qualityInterval steps, LayoutQuality's sampled stress and
+// edge-length statistics. Samples are kept for plotting (thinned to every
+// other one when historyLimit is reached, so the whole run stays visible)
+// and, while a log is open, written one line per step:
+//   - CSV with a header row; quality columns are empty between samples,
+//   - or, for names ending in .json / .jsonl, one JSON object per line.
+class LayoutTelemetry {
+public:
+    struct Sample {
+        unsigned long long step = 0;
+        double wallSeconds = 0.0;     // since reset()
+        double layoutSeconds = 0.0;   // sum of the recorded step times
+        LayoutStepStats stats;
+        bool hasQuality = false;
+        QualityScores quality;
+    };
+
+    enum Metric {
+        METRIC_KINETIC_ENERGY = 0,
+        METRIC_MAX_DISPLACEMENT,
+        METRIC_MEAN_DISPLACEMENT,
+        METRIC_TOTAL_FORCE,
+        METRIC_STRESS,
+        METRIC_EDGE_LENGTH_MEAN,
+        METRIC_EDGE_LENGTH_CV,
+        METRIC_CROSSING_RATE,
+        METRIC_COUNT
+    };
+
+    int qualityInterval = 50;     // steps between quality samples; 0 = never
+    size_t historyLimit = 8192;
+    LayoutQuality quality;        // pivots and samples; prepared again when the topology changes
+
+    LayoutTelemetry();
+    ~LayoutTelemetry();
+    LayoutTelemetry(const LayoutTelemetry&) = delete;
+    LayoutTelemetry& operator=(const LayoutTelemetry&) = delete;
+
+    bool openLog(const std::string& path);
+    void closeLog();
+    bool isLogging() const { return log.is_open(); }
+    const std::string& logPath() const { return path; }
+
+    // Starts a new run: step count, clocks and history restart and the
+    // quality pivots are prepared again on the next sample. The open log, if
+    // any, continues; its run column tells the runs apart.
+    void reset();
+
+    void record(const Graph& graph, double stepSeconds);
+    void record(const CompactGraph& graph, double stepSeconds);
+
+    const std::vector<Sample>& samples() const { return history; }
+    const std::vector<Sample>& qualitySamples() const { return qualityHistory; }
+
+    // One metric resampled at `count` points evenly spaced in step count or
+    // in wall time; each point holds the latest value at or before it.
+    // False if the metric has no samples yet.
+    bool series(Metric metric, bool byWallTime, int count, std::vector<float>& values) const;
+    static const char* metricName(Metric metric);
+
+    std::string error;
+
+private:
+    Sample next(const LayoutStepStats& stats, double stepSeconds);
+    bool qualityDue() const;
+    void add(const Sample& sample);
+    void write(const Sample& sample);
+
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point started;
+    unsigned long long steps = 0;
+    double layoutSeconds = 0.0;
+    unsigned long long preparedVersion = 0;
+
+    std::vector<Sample> history;
+    std::vector<Sample> qualityHistory;   // thinned separately so quality samples survive
+    std::ofstream log;
+    std::string path;
+    bool json = false;
+    unsigned int run = 0;
+};
@@ -0,0 +1,351 @@
+#include "LayoutTuner.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+namespace {
+    // Same rule as the interactive auto layout: a small largest step, or a
+    // step that stopped improving while jittering at a small amplitude.
+    struct SettleTracker {
+        float best = 1e30f;
+        int stalled = 0;
+
+        bool settled(float moved) {
+            if (moved < 1e-4f) return true;
+            if (moved < best * 0.99f) {
+                best = moved;
+                stalled = 0;
+                return false;
+            }
+            return ++stalled >= 180 && moved < 0.05f;
+        }
+    };
+
+    // Lower triangle L with K = L L^T, row-major n x n; false if K is not
+    // positive definite.
+    bool cholesky(std::vector<double>& k, size_t n) {
+        for (size_t j = 0; j < n; ++j) {
+            double sum = k[j * n + j];
+            for (size_t p = 0; p < j; ++p) sum -= k[j * n + p] * k[j * n + p];
+            if (sum <= 0.0) return false;
+            double diagonal = std::sqrt(sum);
+            k[j * n + j] = diagonal;
+            for (size_t i = j + 1; i < n; ++i) {
+                double value = k[i * n + j];
+                for (size_t p = 0; p < j; ++p) value -= k[i * n + p] * k[j * n + p];
+                k[i * n + j] = value / diagonal;
+            }
+            for (size_t i = 0; i < j; ++i) k[i * n + j] = 0.0;
+        }
+        return true;
+    }
+
+    void solveLower(const std::vector<double>& l, size_t n, std::vector<double>& x) {
+        for (size_t i = 0; i < n; ++i) {
+            double value = x[i];
+            for (size_t p = 0; p < i; ++p) value -= l[i * n + p] * x[p];
+            x[i] = value / l[i * n + i];
+        }
+    }
+
+    void solveUpper(const std::vector<double>& l, size_t n, std::vector<double>& x) {
+        for (size_t i = n; i-- > 0;) {
+            double value = x[i];
+            for (size_t p = i + 1; p < n; ++p) value -= l[p * n + i] * x[p];
+            x[i] = value / l[i * n + i];
+        }
+    }
+
+    // A point in the unit square over log(repulsion) x log(attraction).
+    struct Point {
+        double x, y;
+    };
+
+    double kernel(const Point& a, const Point& b) {
+        const double lengthScale = 0.25;
+        double dx = a.x - b.x, dy = a.y - b.y;
+        return std::exp(-(dx * dx + dy * dy) / (2.0 * lengthScale * lengthScale));
+    }
+}
+
+LayoutTuner::LayoutTuner() : running(false), cancelled(false), completedCount(0), totalCount(0), elapsed(0.0) {
+}
+
+LayoutTuner::~LayoutTuner() {
+    cancel();
+}
+
+bool LayoutTuner::start(const Graph& graph) {
+    if (running.load()) return false;
+    if (worker.joinable()) worker.join();
+
+    std::shared_ptr<Graph> copy = std::make_shared<Graph>(graph);
+    cancelled.store(false);
+    running.store(true);
+    worker = std::thread([this, copy]() {
+        tune(*copy);
+        running.store(false);
+        if (onProgress) onProgress();
+    });
+    return true;
+}
+
+void LayoutTuner::cancel() {
+    cancelled.store(true);
+    if (worker.joinable()) worker.join();
+}
+
+std::vector<TuneResult> LayoutTuner::results() const {
+    std::vector<TuneResult> sorted;
+    {
+        std::lock_guard<std::mutex> lock(resultMutex);
+        sorted = finished;
+    }
+    std::stable_sort(sorted.begin(), sorted.end(), [](const TuneResult& a, const TuneResult& b) { return a.score < b.score; });
+    return sorted;
+}
+
+bool LayoutTuner::best(TuneResult& result) const {
+    std::lock_guard<std::mutex> lock(resultMutex);
+    if (finished.empty()) return false;
+    result = *std::min_element(finished.begin(), finished.end(),
+        [](const TuneResult& a, const TuneResult& b) { return a.score < b.score; });
+    return true;
+}
+
+void LayoutTuner::record(const TuneResult& result) {
+    std::lock_guard<std::mutex> lock(resultMutex);
+    finished.push_back(result);
+    completedCount.store((int)finished.size());
+}
+
+void LayoutTuner::prepare(const Graph& graph) {
+    quality.pivots = pivots;
+    quality.crossingSamples = crossingSamples;
+    quality.seed = seed;
+    quality.prepare(graph);
+}
+
+void LayoutTuner::score(const Graph& graph, TuneResult& result) const {
+    QualityScores scores;
+    quality.measure(graph, scores);
+    result.stress = scores.stress;
+    result.edgeLengthCV = scores.edgeLengthCV;
+    result.crossingRate = scores.crossingRate;
+
+    result.score = stressWeight * result.stress + edgeVarianceWeight * result.edgeLengthCV + crossingWeight * result.crossingRate;
+    // A layout that blew up must never win.
+    if (!std::isfinite(result.score)) result.score = std::numeric_limits<float>::infinity();
+}
+
+TuneResult LayoutTuner::evaluate(const Graph& graph, const Candidate& candidate) const {
+    Graph copy = graph;
+    copy.repulsionStrength = candidate.repulsion;
+    copy.attractionStrength = candidate.attraction;
+
+    TuneResult result;
+    result.repulsion = candidate.repulsion;
+    result.attraction = candidate.attraction;
+
+    // (layout seconds, score) every scoreInterval steps, for time-to-quality.
+    std::vector<std::pair<double, float>> checkpoints;
+    SettleTracker tracker;
+    const int interval = std::max(1, scoreInterval);
+    while (result.steps < maxSteps && !cancelled.load()) {
+        auto begin = std::chrono::steady_clock::now();
+        float moved = copy.updateLayout(deltaTime);
+        result.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        ++result.steps;
+
+        if (!std::isfinite(moved)) break;
+        if (tracker.settled(moved)) {
+            result.converged = true;
+            break;
+        }
+        if (result.steps % interval == 0) {
+            score(copy, result);
+            checkpoints.push_back(std::make_pair(result.seconds, result.score));
+        }
+    }
+
+    score(copy, result);
+    checkpoints.push_back(std::make_pair(result.seconds, result.score));
+    result.timeToQuality = result.seconds;
+    for (const auto& checkpoint : checkpoints) {
+        if (checkpoint.second <= result.score * 1.05f + 1e-6f) {
+            result.timeToQuality = checkpoint.first;
+            break;
+        }
+    }
+    return result;
+}
+
+std::vector<LayoutTuner::Candidate> LayoutTuner::gridCandidates() const {
+    int side = std::max(1, (int)std::floor(std::sqrt((double)std::max(1, budget))));
+    std::vector<Candidate> candidates;
+    for (int i = 0; i < side; ++i) {
+        for (int j = 0; j < side; ++j) {
+            float u = side > 1 ? (float)i / (side - 1) : 0.5f;
+            float v = side > 1 ? (float)j / (side - 1) : 0.5f;
+            Candidate candidate;
+            candidate.repulsion = minRepulsion * std::pow(maxRepulsion / minRepulsion, u);
+            candidate.attraction = minAttraction * std::pow(maxAttraction / minAttraction, v);
+            candidates.push_back(candidate);
+        }
+    }
+    return candidates;
+}
+
+std::vector<LayoutTuner::Candidate> LayoutTuner::bayesianBatch(size_t count, std::mt19937& rng) const {
+    const double logRepulsion = std::log((double)maxRepulsion / minRepulsion);
+    const double logAttraction = std::log((double)maxAttraction / minAttraction);
+    auto toCandidate = [&](const Point& x) {
+        Candidate candidate;
+        candidate.repulsion = (float)(minRepulsion * std::exp(x.x * logRepulsion));
+        candidate.attraction = (float)(minAttraction * std::exp(x.y * logAttraction));
+        return candidate;
+    };
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+    std::vector<Point> xs;
+    std::vector<double> ys;
+    {
+        std::lock_guard<std::mutex> lock(resultMutex);
+        double worst = 0.0;
+        for (const auto& result : finished) {
+            if (std::isfinite(result.score)) worst = std::max(worst, (double)result.score);
+        }
+        for (const auto& result : finished) {
+            xs.push_back(Point{ std::log((double)result.repulsion / minRepulsion) / logRepulsion,
+                                std::log((double)result.attraction / minAttraction) / logAttraction });
+            ys.push_back(std::isfinite(result.score) ? (double)result.score : worst + 1.0);
+        }
+    }
+
+    std::vector<Candidate> batch;
+    // Too little data for a useful model: random initial design.
+    if (xs.size() < std::max<size_t>(4, count)) {
+        for (size_t k = 0; k < count; ++k) batch.push_back(toCandidate(Point{ unit(rng), unit(rng) }));
+        return batch;
+    }
+
+    std::vector<Point> pool(2000);
+    for (auto& x : pool) x = Point{ unit(rng), unit(rng) };
+
+    for (size_t k = 0; k < count; ++k) {
+        const size_t n = xs.size();
+        double mean = 0.0;
+        for (double y : ys) mean += y;
+        mean /= n;
+        double spread = 0.0;
+        for (double y : ys) spread += (y - mean) * (y - mean);
+        spread = std::sqrt(spread / n);
+        if (spread < 1e-12) spread = 1.0;
+
+        std::vector<double> l(n * n);
+        for (size_t i = 0; i < n; ++i) {
+            for (size_t j = 0; j < n; ++j) l[i * n + j] = kernel(xs[i], xs[j]) + (i == j ? 1e-4 : 0.0);
+        }
+        if (!cholesky(l, n)) {
+            batch.push_back(toCandidate(Point{ unit(rng), unit(rng) }));
+            continue;
+        }
+        std::vector<double> alpha(n);
+        double bestY = 1e300;
+        for (size_t i = 0; i < n; ++i) {
+            alpha[i] = (ys[i] - mean) / spread;
+            bestY = std::min(bestY, alpha[i]);
+        }
+        solveLower(l, n, alpha);
+        solveUpper(l, n, alpha);
+
+        // Expected improvement below the best normalised score.
+        size_t chosen = 0;
+        double bestImprovement = -1.0;
+        std::vector<double> v(n);
+        for (size_t c = 0; c < pool.size(); ++c) {
+            double mu = 0.0;
+            for (size_t i = 0; i < n; ++i) {
+                v[i] = kernel(pool[c], xs[i]);
+                mu += v[i] * alpha[i];
+            }
+            solveLower(l, n, v);
+            double variance = 1.0;
+            for (size_t i = 0; i < n; ++i) variance -= v[i] * v[i];
+            double sigma = std::sqrt(std::max(variance, 1e-12));
+            double gain = bestY - mu - 0.01;
+            double z = gain / sigma;
+            double cdf = 0.5 * std::erfc(-z / std::sqrt(2.0));
+            double pdf = std::exp(-0.5 * z * z) / std::sqrt(2.0 * 3.14159265358979323846);
+            double improvement = gain * cdf + sigma * pdf;
+            if (improvement > bestImprovement) {
+                bestImprovement = improvement;
+                chosen = c;
+            }
+        }
+
+        batch.push_back(toCandidate(pool[chosen]));
+        // Constant liar: pretend the pick scored the current best so the
+        // rest of the batch spreads out instead of piling onto it.
+        xs.push_back(pool[chosen]);
+        ys.push_back(*std::min_element(ys.begin(), ys.end()));
+        pool.erase(pool.begin() + chosen);
+    }
+    return batch;
+}
+
+void LayoutTuner::run(const Graph& graph) {
+    cancelled.store(false);
+    tune(graph);
+}
+
+void LayoutTuner::tune(const Graph& graph) {
+    {
+        std::lock_guard<std::mutex> lock(resultMutex);
+        finished.clear();
+    }
+    completedCount.store(0);
+    elapsed.store(0.0);
+    if (graph.nodes.empty()) {
+        totalCount.store(0);
+        return;
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    prepare(graph);
+
+    // A private pool, so the shared one stays free for the interactive
+    // layout while a long search runs.
+    ThreadPool pool(threads);
+    auto runBatch = [&](const std::vector<Candidate>& batch) {
+        pool.parallelFor(batch.size(), 1, [&](size_t first, size_t last, int) {
+            for (size_t c = first; c < last; ++c) {
+                if (cancelled.load()) return;
+                TuneResult result = evaluate(graph, batch[c]);
+                if (cancelled.load()) return;
+                record(result);
+                elapsed.store(std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count());
+                if (onProgress) onProgress();
+            }
+        });
+    };
+
+    if (search == SEARCH_BAYESIAN) {
+        std::mt19937 rng(seed);
+        totalCount.store(budget);
+        int remaining = budget;
+        while (remaining > 0 && !cancelled.load()) {
+            std::vector<Candidate> batch = bayesianBatch((size_t)std::min(remaining, pool.size()), rng);
+            runBatch(batch);
+            remaining -= (int)batch.size();
+        }
+    }
+    else {
+        std::vector<Candidate> candidates = gridCandidates();
+        totalCount.store((int)candidates.size());
+        runBatch(candidates);
+    }
+    elapsed.store(std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count());
+}
@@ -0,0 +1,107 @@
+#pragma once
+#include "Graph.h"
+#include "LayoutQuality.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+// Searches repulsion/attraction settings for a graph by laying out many
+// independent copies of it in parallel, one copy per core. Each copy runs
+// Graph::updateLayout until it settles (or maxSteps) and is scored by the
+// weighted sum of LayoutQuality's stress, edge-length CV and crossing rate;
+// lower is better for all three. Grid search covers the (log-spaced) box
+// evenly; Bayesian search fits a Gaussian process to the scores so far and
+// runs the next batch where expected improvement is highest.
+//
+// Graph::layoutStrength is not a search dimension: updateLayout does not
+// read it.
+struct TuneResult {
+    float repulsion = 0.0f;
+    float attraction = 0.0f;
+
+    float stress = 0.0f;
+    float edgeLengthCV = 0.0f;
+    float crossingRate = 0.0f;
+    float score = 0.0f;
+
+    int steps = 0;
+    bool converged = false;
+    double seconds = 0.0;         // layout time, scoring excluded
+    double timeToQuality = 0.0;   // first checkpoint within 5% of the final score
+};
+
+class LayoutTuner {
+public:
+    enum Search { SEARCH_GRID = 0, SEARCH_BAYESIAN = 1 };
+
+    int search = SEARCH_GRID;
+    int budget = 16;                  // layouts to run
+    int threads = 0;                  // 0 = one per core
+    float minRepulsion = 10.0f, maxRepulsion = 1000.0f;
+    float minAttraction = 0.01f, maxAttraction = 1.0f;
+    int maxSteps = 2000;
+    float deltaTime = 0.16f;
+    int scoreInterval = 50;
+    int pivots = 16;
+    int crossingSamples = 20000;
+    float stressWeight = 1.0f;
+    float edgeVarianceWeight = 1.0f;
+    float crossingWeight = 1.0f;
+    unsigned int seed = 1;
+
+    // Called from a tuning thread after each finished layout and at the end
+    // of a run, e.g. to wake a main loop blocked waiting for events.
+    std::function<void()> onProgress;
+
+    LayoutTuner();
+    ~LayoutTuner();
+
+    // Copies the graph and tunes on a background thread.
+    bool start(const Graph& graph);
+    void cancel();
+    bool isRunning() const { return running.load(); }
+
+    // Runs the whole search on the calling thread.
+    void run(const Graph& graph);
+
+    int completed() const { return completedCount.load(); }
+    int total() const { return totalCount.load(); }
+    double elapsedSeconds() const { return elapsed.load(); }
+
+    // Finished layouts, best score first.
+    std::vector<TuneResult> results() const;
+    bool best(TuneResult& result) const;
+
+private:
+    struct Candidate {
+        float repulsion;
+        float attraction;
+    };
+
+    void tune(const Graph& graph);
+    void prepare(const Graph& graph);
+    TuneResult evaluate(const Graph& graph, const Candidate& candidate) const;
+    void score(const Graph& graph, TuneResult& result) const;
+    void record(const TuneResult& result);
+
+    std::vector<Candidate> gridCandidates() const;
+    std::vector<Candidate> bayesianBatch(size_t count, std::mt19937& rng) const;
+
+    // Shared by all copies: hop distances from the pivots and the sampled
+    // edge pairs for the crossing estimate.
+    LayoutQuality quality;
+
+    mutable std::mutex resultMutex;
+    std::vector<TuneResult> finished;
+
+    std::thread worker;
+    std::atomic<bool> running;
+    std::atomic<bool> cancelled;
+    std::atomic<int> completedCount;
+    std::atomic<int> totalCount;
+    std::atomic<double> elapsed;
+};
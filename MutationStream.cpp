@@ -0,0 +1,199 @@
+#include "MutationStream.h"
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+MutationStream::MutationStream() {
+}
+
+MutationStream::~MutationStream() {
+    close();
+}
+
+bool MutationStream::open(const std::string& path) {
+    close();
+
+    if (path != "-") {
+        std::ifstream probe(path);
+        if (!probe.is_open()) {
+            std::cerr << "Unable to open mutation stream: " << path << std::endl;
+            return false;
+        }
+    }
+
+    state = std::make_shared<State>();
+    state->maxQueued = maxQueued;
+    state->onQueued = onQueued;
+    source = path;
+    applied = 0;
+    rejected = 0;
+    reader = std::thread(&MutationStream::readerLoop, state, path);
+    return true;
+}
+
+void MutationStream::close() {
+    if (!state) return;
+
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->stopping = true;
+    }
+    state->spaceCv.notify_all();
+
+    // A reader blocked in getline on stdin cannot be interrupted portably.
+    if (reader.joinable()) {
+        bool eof;
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            eof = state->eof;
+        }
+        if (eof || source != "-") reader.join();
+        else reader.detach();
+    }
+    state.reset();
+    placeLater.clear();
+    batches = 0;
+}
+
+void MutationStream::readerLoop(std::shared_ptr<State> state, std::string path) {
+    std::ifstream file;
+    std::istream* in = &std::cin;
+    if (path != "-") {
+        file.open(path);
+        in = &file;
+    }
+
+    std::string line;
+    while (std::getline(*in, line)) {
+        Mutation mutation;
+        bool ok = parseLine(line, mutation);
+
+        std::unique_lock<std::mutex> lock(state->mutex);
+        if (!ok) {
+            size_t start = line.find_first_not_of(" \t\r");
+            if (start != std::string::npos && line[start] != '#') ++state->parseErrors;
+            continue;
+        }
+        state->spaceCv.wait(lock, [&]() { return state->stopping || state->queue.size() < state->maxQueued; });
+        if (state->stopping) break;
+        bool wasEmpty = state->queue.empty();
+        state->queue.push_back(mutation);
+        lock.unlock();
+
+        if (wasEmpty && state->onQueued) state->onQueued();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->eof = true;
+    }
+    if (state->onQueued) state->onQueued();
+}
+
+bool MutationStream::parseLine(const std::string& line, Mutation& mutation) {
+    std::istringstream in(line);
+    std::string op;
+    if (!(in >> op) || op[0] == '#') return false;
+
+    if (op == "an") {
+        mutation.type = Mutation::ADD_NODE;
+        if (!(in >> mutation.a)) return false;
+        float x, y, z;
+        if (in >> x >> y >> z) {
+            mutation.hasPosition = true;
+            mutation.position = glm::vec3(x, y, z);
+        }
+        return mutation.a >= 0;
+    }
+    if (op == "rn") {
+        mutation.type = Mutation::REMOVE_NODE;
+        return (bool)(in >> mutation.a);
+    }
+    if (op == "ae") {
+        mutation.type = Mutation::ADD_EDGE;
+        if (!(in >> mutation.a >> mutation.b)) return false;
+        float weight;
+        if (in >> weight) mutation.weight = weight;
+        return true;
+    }
+    if (op == "re") {
+        mutation.type = Mutation::REMOVE_EDGE;
+        return (bool)(in >> mutation.a >> mutation.b);
+    }
+    return false;
+}
+
+size_t MutationStream::applyPending(Graph& graph, size_t maxMutations) {
+    if (!state) return 0;
+
+    std::deque<Mutation> batch;
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        size_t count = std::min(maxMutations, state->queue.size());
+        batch.assign(state->queue.begin(), state->queue.begin() + count);
+        state->queue.erase(state->queue.begin(), state->queue.begin() + count);
+    }
+    if (batch.empty()) return 0;
+    state->spaceCv.notify_one();
+    ++batches;
+
+    bool linked = false;
+    for (const Mutation& mutation : batch) {
+        bool ok = false;
+        switch (mutation.type) {
+        case Mutation::ADD_NODE:
+            ok = graph.addNode(mutation.position, mutation.a) >= 0;
+            if (ok && !mutation.hasPosition) {
+                PendingPlacement pending;
+                pending.id = mutation.a;
+                pending.deadline = batches + placeWithinBatches;
+                placeLater.push_back(pending);
+            }
+            break;
+        case Mutation::REMOVE_NODE:
+            ok = graph.removeNode(mutation.a);
+            break;
+        case Mutation::ADD_EDGE:
+            ok = graph.addEdgeById(mutation.a, mutation.b, mutation.weight);
+            linked = linked || ok;
+            break;
+        case Mutation::REMOVE_EDGE:
+            ok = graph.removeEdgeById(mutation.a, mutation.b);
+            break;
+        }
+        if (ok) ++applied;
+        else ++rejected;
+    }
+
+    // New nodes usually arrive before their edges; place them once a batch
+    // has linked them. Nodes still without neighbours wait for a later batch
+    // until their deadline, so the list stays bounded by recent additions.
+    if (linked || (!placeLater.empty() && placeLater.front().deadline < batches)) {
+        size_t kept = 0;
+        for (const PendingPlacement& pending : placeLater) {
+            if (graph.indexOf(pending.id) < 0 || pending.deadline < batches) continue;
+            if (!linked || !graph.placeNearNeighbors(pending.id)) placeLater[kept++] = pending;
+        }
+        placeLater.resize(kept);
+    }
+
+    return batch.size();
+}
+
+size_t MutationStream::parseErrors() const {
+    if (!state) return 0;
+    std::lock_guard<std::mutex> lock(state->mutex);
+    return state->parseErrors;
+}
+
+size_t MutationStream::queued() const {
+    if (!state) return 0;
+    std::lock_guard<std::mutex> lock(state->mutex);
+    return state->queue.size();
+}
+
+bool MutationStream::finished() const {
+    if (!state) return true;
+    std::lock_guard<std::mutex> lock(state->mutex);
+    return state->eof && state->queue.empty();
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include "Graph.h"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Reads graph mutations, one per line, from a file or stdin on a background
+// thread and hands them to the render loop in batches:
+//
+//   an <id> [x y z]       add node (placed near its neighbours if no position)
+//   rn <id>               remove node and its edges
+//   ae <from> <to> [w]    add edge
+//   re <from> <to>        remove edge
+//   # ...                 comment
+class MutationStream {
+public:
+    struct Mutation {
+        enum Type { ADD_NODE, REMOVE_NODE, ADD_EDGE, REMOVE_EDGE };
+        Type type = ADD_NODE;
+        int a = -1;
+        int b = -1;
+        float weight = 1.0f;
+        bool hasPosition = false;
+        glm::vec3 position = glm::vec3(0.0f);
+    };
+
+    size_t maxQueued = 65536;
+
+    // New nodes without a position wait this many batches for an edge that
+    // lets them be placed near their neighbours; after that they stay where
+    // they were added and the layout moves them.
+    size_t placeWithinBatches = 8;
+
+    // Called from the reader thread when mutations arrive in an empty queue,
+    // e.g. to wake a main loop blocked waiting for events. Set before open().
+    std::function<void()> onQueued;
+
+    MutationStream();
+    ~MutationStream();
+
+    // path "-" reads stdin.
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const { return state != nullptr; }
+
+    // Applies at most maxMutations queued mutations; returns how many ran.
+    size_t applyPending(Graph& graph, size_t maxMutations);
+
+    static bool parseLine(const std::string& line, Mutation& mutation);
+
+    std::string source;
+    size_t applied = 0;
+    size_t rejected = 0;     // well-formed but refused by Graph (unknown id, duplicate, ...)
+    size_t parseErrors() const;
+    size_t queued() const;
+    bool finished() const;   // input exhausted and queue drained
+
+private:
+    // Shared with the reader thread so that a reader blocked on a pipe can be
+    // detached on close() without touching freed memory.
+    struct State {
+        std::mutex mutex;
+        std::condition_variable spaceCv;
+        std::deque<Mutation> queue;
+        size_t maxQueued = 0;
+        std::function<void()> onQueued;
+        size_t parseErrors = 0;
+        bool eof = false;
+        bool stopping = false;
+    };
+
+    static void readerLoop(std::shared_ptr<State> state, std::string path);
+
+    std::shared_ptr<State> state;
+    std::thread reader;
+    struct PendingPlacement {
+        int id;
+        size_t deadline;     // last batch that may place it
+    };
+    std::vector<PendingPlacement> placeLater;
+    size_t batches = 0;
+};
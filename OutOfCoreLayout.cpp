@@ -0,0 +1,143 @@
+#include "OutOfCoreLayout.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <random>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+namespace {
+    long majorFaultCount() {
+#ifndef _WIN32
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_majflt;
+#else
+        return 0;
+#endif
+    }
+
+    // Bytes this process caused to be read from storage, page-ins of the
+    // mapping included.
+    uint64_t storageReadBytes() {
+#ifndef _WIN32
+        std::ifstream io("/proc/self/io");
+        std::string key;
+        uint64_t value;
+        while (io >> key >> value) {
+            if (key == "read_bytes:") return value;
+        }
+#endif
+        return 0;
+    }
+}
+
+OutOfCoreLayout::OutOfCoreLayout() {
+    graph.attractionPass = [this](const std::vector<glm::vec3>& positions, std::vector<glm::vec3>& force) {
+        streamAttraction(positions, force);
+    };
+}
+
+bool OutOfCoreLayout::open(const std::string& path) {
+    close();
+    error.clear();
+    if (!edges.open(path)) {
+        error = edges.error;
+        return false;
+    }
+
+    // CompactGraph's +-5 box for small graphs; beyond that the half-side
+    // grows with the square (cube) root of n so the spacing stays about 2.
+    const double n = (double)edges.nodeCount();
+    const float halfSide = std::max(5.0f, (float)(graph.is3D ? std::cbrt(n) : std::sqrt(n)));
+    std::mt19937 gen(graph.seed != 0 ? graph.seed : std::random_device()());
+    std::uniform_real_distribution<float> pos_dist(-1.0f, 1.0f);
+    graph.positions.resize((size_t)edges.nodeCount());
+    for (auto& pos : graph.positions) {
+        pos.x = pos_dist(gen) * halfSide;
+        pos.y = pos_dist(gen) * halfSide;
+        pos.z = graph.is3D ? pos_dist(gen) * halfSide : 0.0f;
+    }
+
+    lastStep = StepStats();
+    total = StepStats();
+    steps = 0;
+    return true;
+}
+
+void OutOfCoreLayout::close() {
+    edges.close();
+    graph.clear();
+}
+
+void OutOfCoreLayout::streamAttraction(const std::vector<glm::vec3>& positions, std::vector<glm::vec3>& force) {
+    const std::vector<uint64_t>& offsets = edges.offsets();
+    const std::vector<EdgeFile::Block>& blocks = edges.blocks();
+    const uint32_t* neighbors = edges.neighbors();
+    const size_t n = positions.size();
+    const float strength = graph.attractionStrength;
+    const std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+
+    for (size_t k = 0; k < blocks.size() && (int)k < readAheadBlocks; ++k) edges.prefetch(k);
+    for (size_t b = 0; b < blocks.size(); ++b) {
+        if (b + readAheadBlocks < blocks.size()) edges.prefetch(b + readAheadBlocks);
+
+        const EdgeFile::Block& block = blocks[b];
+        parallelFor(block.endNode - block.firstNode, 1024, [&](size_t begin, size_t end, int) {
+            for (size_t i = block.firstNode + begin; i < block.firstNode + end; ++i) {
+                const glm::vec3 p = positions[i];
+                glm::vec3 sum(0.0f);
+                for (uint64_t e = offsets[i]; e < offsets[i + 1]; ++e) {
+                    uint32_t j = neighbors[e];
+                    if (j >= n) continue;
+                    glm::vec3 diff = positions[j] - p;
+                    float distance = glm::length(diff);
+                    if (distance > 0.001f) {
+                        sum += diff / distance * (strength * distance * distance);
+                    }
+                }
+                force[i] += sum;
+            }
+        });
+
+        edges.release(b);
+    }
+    streamSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+}
+
+float OutOfCoreLayout::step(float deltaTime) {
+    if (!edges.isOpen()) return 0.0f;
+
+    typedef std::chrono::steady_clock Clock;
+    const Clock::time_point begin = Clock::now();
+    const long faults = majorFaultCount();
+    const uint64_t diskBefore = storageReadBytes();
+
+    // CompactGraph::updateLayout calls streamAttraction between the
+    // repulsion and integration passes.
+    float moved = graph.updateLayout(deltaTime);
+
+    lastStep.seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+    lastStep.attractionSeconds = streamSeconds;
+    lastStep.bytesScanned = edges.neighborBytes();
+    lastStep.diskBytes = storageReadBytes() - diskBefore;
+    lastStep.majorFaults = majorFaultCount() - faults;
+    total.seconds += lastStep.seconds;
+    total.attractionSeconds += lastStep.attractionSeconds;
+    total.bytesScanned += lastStep.bytesScanned;
+    total.diskBytes += lastStep.diskBytes;
+    total.majorFaults += lastStep.majorFaults;
+    ++steps;
+    return moved;
+}
+
+bool OutOfCoreLayout::savePositions(const std::string& path) const {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) return false;
+    file.write(reinterpret_cast<const char*>(graph.positions.data()), graph.positions.size() * sizeof(glm::vec3));
+    return file.good();
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include "CompactGraph.h"
+#include "EdgeFile.h"
+#include <string>
+
+// Force-directed layout for graphs whose edges live in an EdgeFile. Node
+// positions, velocities and the repulsion grid stay in memory (a
+// CompactGraph with no edges); the attraction pass streams the edge file's
+// blocks in order, prefetching readAheadBlocks ahead and releasing each
+// block once its nodes are done. Within a block the nodes are split across
+// the thread pool; each thread only writes the forces of its own nodes.
+class OutOfCoreLayout {
+public:
+    CompactGraph graph;   // positions and layout parameters; edgeIndices stay empty
+    EdgeFile edges;
+    int readAheadBlocks = 2;
+
+    struct StepStats {
+        double seconds = 0.0;
+        double attractionSeconds = 0.0;   // streaming pass only
+        uint64_t bytesScanned = 0;        // neighbour array walked, cached or not
+        uint64_t diskBytes = 0;           // fetched from storage (Linux /proc/self/io), 0 if unknown
+        long majorFaults = 0;             // page faults that waited for the disk
+
+        // Logical rate: how fast the pass consumed the neighbour array.
+        double scanRate() const { return attractionSeconds > 0.0 ? bytesScanned / attractionSeconds : 0.0; }
+        double diskRate() const { return attractionSeconds > 0.0 ? diskBytes / attractionSeconds : 0.0; }
+    };
+    StepStats lastStep;
+    StepStats total;
+    unsigned long long steps = 0;
+
+    OutOfCoreLayout();
+    OutOfCoreLayout(const OutOfCoreLayout&) = delete;
+    OutOfCoreLayout& operator=(const OutOfCoreLayout&) = delete;
+
+    // Maps the edge file and places the nodes at random in a box that grows
+    // with the node count (about two units between nodes), so the first
+    // steps do not start from millions of nodes packed into +-5.
+    bool open(const std::string& path);
+    void close();
+
+    float step(float deltaTime);   // returns the largest node displacement
+
+    // nodeCount float triples, little-endian.
+    bool savePositions(const std::string& path) const;
+
+    std::string error;
+
+private:
+    void streamAttraction(const std::vector<glm::vec3>& positions, std::vector<glm::vec3>& force);
+
+    double streamSeconds = 0.0;
+};
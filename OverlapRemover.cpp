@@ -0,0 +1,325 @@
+#include "OverlapRemover.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <set>
+
+namespace {
+    inline float coord(const glm::vec3& p, int axis) {
+        return axis == 0 ? p.x : p.y;
+    }
+
+    // A hair over the sum of the two radii, so that float rounding of the
+    // solved positions cannot leave squares that still touch inside.
+    inline float separation(float radiusA, float radiusB) {
+        return (radiusA + radiusB) * 1.0001f;
+    }
+
+    // In-constraint heap entry of a block: key + the heap's shift is
+    // pos(left) + gap - offset(right), so the most violated constraint is
+    // the largest key.
+    struct Entry {
+        double key;
+        uint32_t constraint;
+
+        bool operator<(const Entry& other) const { return key < other.key; }
+    };
+
+    // Nodes that move together, at posn + offset[node].
+    struct Block {
+        std::vector<uint32_t> vars;
+        std::vector<Entry> heap;
+        double shift = 0.0;
+        double weightedPosition = 0.0;   // sum of (desired - offset)
+        double weight = 0.0;
+        double posn = 0.0;
+    };
+}
+
+OverlapRemover::OverlapRemover() : running(false), cancelled(false) {
+}
+
+OverlapRemover::~OverlapRemover() {
+    cancel();
+}
+
+void OverlapRemover::generateConstraints(const std::vector<glm::vec3>& positions, const std::vector<float>& radii, int axis,
+    std::vector<Constraint>& constraints) const {
+    const int sweepAxis = 1 - axis;
+    const size_t n = positions.size();
+    auto radiusOf = [&](uint32_t v) { return radii.empty() ? radius : radii[v]; };
+
+    struct Event {
+        float at;
+        uint32_t node;
+        bool open;
+    };
+    std::vector<Event> events;
+    events.reserve(2 * n);
+    for (size_t i = 0; i < n; ++i) {
+        float centre = coord(positions[i], sweepAxis);
+        events.push_back({ centre - radiusOf((uint32_t)i), (uint32_t)i, true });
+        events.push_back({ centre + radiusOf((uint32_t)i), (uint32_t)i, false });
+    }
+    // Closing before opening at the same coordinate: squares that only
+    // touch do not overlap.
+    std::sort(events.begin(), events.end(), [](const Event& a, const Event& b) {
+        if (a.at != b.at) return a.at < b.at;
+        return !a.open && b.open;
+    });
+
+    auto before = [&](uint32_t a, uint32_t b) {
+        float ca = coord(positions[a], axis), cb = coord(positions[b], axis);
+        return ca < cb || (ca == cb && a < b);
+    };
+    std::set<uint32_t, decltype(before)> scan(before);
+
+    auto add = [&](uint32_t left, uint32_t right) {
+        if (axis == 0) {
+            // Only where moving sideways is the cheaper way out; the y pass
+            // takes care of everything else.
+            const float size = separation(radiusOf(left), radiusOf(right));
+            float overlapX = size - (positions[right].x - positions[left].x);
+            float overlapY = size - std::abs(positions[right].y - positions[left].y);
+            if (overlapX <= 0.0f || overlapX > overlapY) return;
+        }
+        constraints.push_back({ left, right });
+    };
+
+    constraints.clear();
+    for (const Event& event : events) {
+        if (event.open) {
+            auto it = scan.insert(event.node).first;
+            if (it != scan.begin()) add(*std::prev(it), event.node);
+            auto next = std::next(it);
+            if (next != scan.end()) add(event.node, *next);
+        }
+        else {
+            auto it = scan.find(event.node);
+            auto next = std::next(it);
+            if (it != scan.begin() && next != scan.end()) add(*std::prev(it), *next);
+            scan.erase(it);
+        }
+    }
+
+    std::sort(constraints.begin(), constraints.end(), [](const Constraint& a, const Constraint& b) {
+        return a.right < b.right || (a.right == b.right && a.left < b.left);
+    });
+    constraints.erase(std::unique(constraints.begin(), constraints.end(), [](const Constraint& a, const Constraint& b) {
+        return a.left == b.left && a.right == b.right;
+    }), constraints.end());
+}
+
+void OverlapRemover::solve(std::vector<glm::vec3>& positions, const std::vector<float>& radii, int axis,
+    const std::vector<Constraint>& constraints) const {
+    const size_t n = positions.size();
+    auto gapOf = [&](const Constraint& c) -> double {
+        return radii.empty() ? separation(radius, radius) : separation(radii[c.left], radii[c.right]);
+    };
+
+    // Every constraint goes from earlier to later in this order, so it is a
+    // topological order of the constraint graph.
+    std::vector<uint32_t> order(n);
+    for (size_t i = 0; i < n; ++i) order[i] = (uint32_t)i;
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        float ca = coord(positions[a], axis), cb = coord(positions[b], axis);
+        return ca < cb || (ca == cb && a < b);
+    });
+
+    // Constraints are sorted by their right node: in-constraints by node.
+    std::vector<size_t> inStart(n + 1, 0);
+    for (const Constraint& c : constraints) inStart[c.right + 1]++;
+    for (size_t i = 0; i < n; ++i) inStart[i + 1] += inStart[i];
+
+    std::vector<Block> blocks(n);
+    std::vector<uint32_t> blockOf(n);
+    std::vector<double> offset(n, 0.0);
+    for (size_t i = 0; i < n; ++i) {
+        Block& block = blocks[i];
+        block.vars.push_back((uint32_t)i);
+        block.weightedPosition = block.posn = coord(positions[i], axis);
+        block.weight = 1.0;
+        blockOf[i] = (uint32_t)i;
+    }
+    auto position = [&](uint32_t v) { return blocks[blockOf[v]].posn + offset[v]; };
+
+    // Joins the blocks of c.left and c.right so that c holds with equality;
+    // walks the smaller block's nodes and the smaller heap.
+    auto merge = [&](uint32_t leftBlock, uint32_t rightBlock, const Constraint& c) -> uint32_t {
+        Block& a = blocks[leftBlock];
+        Block& b = blocks[rightBlock];
+        const double dist = offset[c.left] + gapOf(c) - offset[c.right];
+        uint32_t kept, absorbed;
+        if (a.vars.size() >= b.vars.size()) {
+            for (uint32_t v : b.vars) {
+                offset[v] += dist;
+                blockOf[v] = leftBlock;
+            }
+            a.weightedPosition += b.weightedPosition - dist * b.weight;
+            b.shift -= dist;
+            kept = leftBlock;
+            absorbed = rightBlock;
+        }
+        else {
+            for (uint32_t v : a.vars) {
+                offset[v] -= dist;
+                blockOf[v] = rightBlock;
+            }
+            b.weightedPosition += a.weightedPosition + dist * a.weight;
+            a.shift += dist;
+            kept = rightBlock;
+            absorbed = leftBlock;
+        }
+
+        Block& target = blocks[kept];
+        Block& source = blocks[absorbed];
+        if (source.heap.size() > target.heap.size()) {
+            std::swap(source.heap, target.heap);
+            std::swap(source.shift, target.shift);
+        }
+        for (const Entry& entry : source.heap) {
+            target.heap.push_back({ entry.key + source.shift - target.shift, entry.constraint });
+            std::push_heap(target.heap.begin(), target.heap.end());
+        }
+        target.vars.insert(target.vars.end(), source.vars.begin(), source.vars.end());
+        target.weight += source.weight;
+        target.posn = target.weightedPosition / target.weight;
+        std::vector<uint32_t>().swap(source.vars);
+        std::vector<Entry>().swap(source.heap);
+        return kept;
+    };
+
+    double largestGap = 0.0;
+    for (const Constraint& c : constraints) largestGap = std::max(largestGap, gapOf(c));
+    const double tolerance = 1e-7 * largestGap;
+    for (uint32_t v : order) {
+        uint32_t current = v;
+        for (size_t k = inStart[v]; k < inStart[v + 1]; ++k) {
+            const Constraint& c = constraints[k];
+            blocks[v].heap.push_back({ position(c.left) + gapOf(c), (uint32_t)k });
+            std::push_heap(blocks[v].heap.begin(), blocks[v].heap.end());
+        }
+
+        while (true) {
+            Block& block = blocks[current];
+            std::vector<Entry>& heap = block.heap;
+            // Drop constraints that became internal; re-key those whose left
+            // block moved since they were pushed.
+            while (!heap.empty()) {
+                const Entry top = heap.front();
+                const Constraint& c = constraints[top.constraint];
+                if (blockOf[c.left] == current) {
+                    std::pop_heap(heap.begin(), heap.end());
+                    heap.pop_back();
+                    continue;
+                }
+                double actual = position(c.left) + gapOf(c) - offset[c.right];
+                if (std::abs(actual - (top.key + block.shift)) > tolerance) {
+                    std::pop_heap(heap.begin(), heap.end());
+                    heap.back().key = actual - block.shift;
+                    std::push_heap(heap.begin(), heap.end());
+                    if (heap.front().constraint == top.constraint) break;
+                    continue;
+                }
+                break;
+            }
+            if (heap.empty()) break;
+            const Entry top = heap.front();
+            if (top.key + block.shift - block.posn <= tolerance) break;
+            std::pop_heap(heap.begin(), heap.end());
+            heap.pop_back();
+            const Constraint& c = constraints[top.constraint];
+            current = merge(blockOf[c.left], current, c);
+        }
+    }
+
+    // Merging a block can pull it past constraints it was already clear
+    // of; one forward sweep in topological order makes every constraint
+    // hold, moving only nodes that the merging left too far back. It works
+    // on the float results so that rounding cannot undo it far from the
+    // origin.
+    std::vector<float> solved(n);
+    for (size_t i = 0; i < n; ++i) solved[i] = (float)position((uint32_t)i);
+    for (uint32_t v : order) {
+        for (size_t k = inStart[v]; k < inStart[v + 1]; ++k) {
+            const float gapf = (float)gapOf(constraints[k]);
+            const float least = solved[constraints[k].left];
+            float x = std::max(solved[v], least + gapf);
+            while (x - least < gapf) x = std::nextafter(x, HUGE_VALF);
+            solved[v] = x;
+        }
+    }
+    for (size_t i = 0; i < n; ++i) {
+        if (axis == 0) positions[i].x = solved[i];
+        else positions[i].y = solved[i];
+    }
+}
+
+bool OverlapRemover::removeOverlaps(std::vector<glm::vec3>& positions, Stats& stats) const {
+    return removeOverlaps(positions, std::vector<float>(), stats);
+}
+
+bool OverlapRemover::removeOverlaps(std::vector<glm::vec3>& positions, const std::vector<float>& radii, Stats& stats) const {
+    const std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+    stats = Stats();
+    stats.nodes = positions.size();
+    if (positions.size() < 2) return true;
+    if (radii.empty() ? radius <= 0.0f : radii.size() != positions.size()) return true;
+
+    const std::vector<glm::vec3> original = positions;
+    std::vector<Constraint> constraints;
+    for (int axis = 0; axis < 2; ++axis) {
+        if (cancelled.load()) return false;
+        generateConstraints(positions, radii, axis, constraints);
+        (axis == 0 ? stats.constraintsX : stats.constraintsY) = constraints.size();
+        if (cancelled.load()) return false;
+        solve(positions, radii, axis, constraints);
+    }
+
+    for (size_t i = 0; i < positions.size(); ++i) {
+        float move = glm::length(positions[i] - original[i]);
+        if (move > 0.0f) ++stats.moved;
+        stats.maxMove = std::max(stats.maxMove, move);
+    }
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    return true;
+}
+
+bool OverlapRemover::start(const std::vector<glm::vec3>& positions, const std::vector<float>& radii) {
+    if (running.load()) return false;
+    if (worker.joinable()) worker.join();
+
+    cancelled.store(false);
+    running.store(true);
+    worker = std::thread([this, positions, radii]() {
+        std::vector<glm::vec3> moved = positions;
+        Stats stats;
+        if (removeOverlaps(moved, radii, stats)) {
+            std::lock_guard<std::mutex> lock(resultMutex);
+            result.swap(moved);
+            resultStats = stats;
+            resultReady = true;
+        }
+        running.store(false);
+        if (onFinished) onFinished();
+    });
+    return true;
+}
+
+void OverlapRemover::cancel() {
+    cancelled.store(true);
+    if (worker.joinable()) worker.join();
+    std::lock_guard<std::mutex> lock(resultMutex);
+    resultReady = false;
+    result.clear();
+}
+
+bool OverlapRemover::takeResult(std::vector<glm::vec3>& positions) {
+    std::lock_guard<std::mutex> lock(resultMutex);
+    if (!resultReady) return false;
+    positions.swap(result);
+    lastStats = resultStats;
+    resultReady = false;
+    result.clear();
+    return true;
+}
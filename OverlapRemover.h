@@ -0,0 +1,84 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <glm/glm.hpp>
+
+// Moves nodes apart until no two overlap, treating each node as the
+// axis-aligned square around its disc in the XY plane (half-side `radius`,
+// or the node's own entry of `radii` when nodes are drawn at different
+// sizes) and changing positions as little as it can. Separated squares keep
+// the drawn discs apart too. This is
+// the scan-line constraint method of Dwyer, Marriott and Stuckey ("Fast
+// Node Overlap Removal"):
+//   1. Sweep over y keeping the nodes that cross the sweep line ordered by
+//      x. Neighbours in that order overlap in y; those that also overlap in
+//      x, by no more than in y, get a separation constraint in x.
+//   2. Solve for the x positions closest (least squares) to the current
+//      ones that satisfy the constraints, by merging nodes into rigid
+//      blocks along the most violated constraint.
+//   3. Repeat both in y with a constraint between every pair that is ever
+//      adjacent in the sweep. Any two nodes that still overlap in x are
+//      then linked by a chain of such constraints, so no overlap is left.
+// A sweep emits O(n) constraints with O(n log n) work; z is left alone.
+class OverlapRemover {
+public:
+    float radius = 0.1f;   // world units
+
+    struct Stats {
+        size_t nodes = 0;
+        size_t constraintsX = 0;
+        size_t constraintsY = 0;
+        size_t moved = 0;
+        float maxMove = 0.0f;
+        double seconds = 0.0;
+    };
+
+    // Called from the background thread when a run finishes, e.g. to wake a
+    // main loop blocked waiting for events.
+    std::function<void()> onFinished;
+
+    OverlapRemover();
+    ~OverlapRemover();
+    OverlapRemover(const OverlapRemover&) = delete;
+    OverlapRemover& operator=(const OverlapRemover&) = delete;
+
+    // Runs on the calling thread; false if cancelled. `radii` holds one
+    // radius per node in world units; empty means `radius` for every node.
+    bool removeOverlaps(std::vector<glm::vec3>& positions, Stats& stats) const;
+    bool removeOverlaps(std::vector<glm::vec3>& positions, const std::vector<float>& radii, Stats& stats) const;
+
+    // Copies the positions (and radii) and removes overlaps on a background
+    // thread.
+    bool start(const std::vector<glm::vec3>& positions, const std::vector<float>& radii = std::vector<float>());
+    void cancel();
+    bool isRunning() const { return running.load(); }
+
+    // The result of the last finished run, handed out once; its stats go
+    // to lastStats.
+    bool takeResult(std::vector<glm::vec3>& positions);
+    Stats lastStats;
+
+private:
+    struct Constraint {
+        uint32_t left;
+        uint32_t right;
+    };
+
+    // axis 0 separates in x (sweeping over y), axis 1 in y.
+    void generateConstraints(const std::vector<glm::vec3>& positions, const std::vector<float>& radii, int axis,
+        std::vector<Constraint>& constraints) const;
+    void solve(std::vector<glm::vec3>& positions, const std::vector<float>& radii, int axis,
+        const std::vector<Constraint>& constraints) const;
+
+    std::thread worker;
+    std::atomic<bool> running;
+    std::atomic<bool> cancelled;
+    std::mutex resultMutex;
+    bool resultReady = false;
+    std::vector<glm::vec3> result;
+    Stats resultStats;
+};
@@ -0,0 +1,702 @@
+#include "RasterExporter.h"
+#include "Graph.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+namespace {
+    double secondsSince(std::chrono::steady_clock::time_point begin) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    }
+
+    bool makeDirectory(const std::string& path) {
+#ifdef _WIN32
+        return _mkdir(path.c_str()) == 0 || errno == EEXIST;
+#else
+        return mkdir(path.c_str(), 0755) == 0 || errno == EEXIST;
+#endif
+    }
+
+    // Tile index of a pixel coordinate, clamped before the conversion so far
+    // off-screen geometry cannot overflow.
+    int tileOf(float v, int tileSize, int count) {
+        v = std::min(std::max(v, -1.0f), (float)count * tileSize + 1.0f);
+        return (int)std::floor(v / tileSize);
+    }
+
+    // Calls visit(tile) for every tile within `reach` of the segment ab.
+    template <typename Visit>
+    void forEachEdgeTile(const glm::vec2& a, const glm::vec2& b, float reach, int tileSize, int columns, int rows, Visit visit) {
+        int firstRow = std::max(0, tileOf(std::min(a.y, b.y) - reach, tileSize, rows));
+        int lastRow = std::min(rows - 1, tileOf(std::max(a.y, b.y) + reach, tileSize, rows));
+        glm::vec2 d = b - a;
+        for (int row = firstRow; row <= lastRow; ++row) {
+            // x extent of the part of the segment inside this tile row's band
+            float xMin = std::min(a.x, b.x), xMax = std::max(a.x, b.x);
+            if (std::fabs(d.y) > 1e-6f) {
+                float t0 = std::min(1.0f, std::max(0.0f, ((float)row * tileSize - reach - a.y) / d.y));
+                float t1 = std::min(1.0f, std::max(0.0f, ((float)(row + 1) * tileSize + reach - a.y) / d.y));
+                xMin = std::min(a.x + t0 * d.x, a.x + t1 * d.x);
+                xMax = std::max(a.x + t0 * d.x, a.x + t1 * d.x);
+            }
+            int firstColumn = std::max(0, tileOf(xMin - reach, tileSize, columns));
+            int lastColumn = std::min(columns - 1, tileOf(xMax + reach, tileSize, columns));
+            for (int column = firstColumn; column <= lastColumn; ++column) visit(row * columns + column);
+        }
+    }
+
+    // Counting sort of items into per-tile lists. Items are split into fixed
+    // chunks so the order inside each tile does not depend on scheduling.
+    // forEachTile(item, emit) calls emit(tile) for every tile the item touches.
+    template <typename ForEachTile>
+    void binItems(size_t itemCount, size_t tileCount, ForEachTile forEachTile,
+                  std::vector<size_t>& start, std::vector<uint32_t>& items) {
+        const size_t chunks = std::max<size_t>(1, std::min(itemCount, (size_t)ThreadPool::instance().size() * 4));
+        const size_t chunkSize = (itemCount + chunks - 1) / chunks;
+        std::vector<size_t> offsets(chunks * tileCount, 0);
+
+        parallelFor(chunks, 1, [&](size_t first, size_t last, int) {
+            for (size_t c = first; c < last; ++c) {
+                size_t* counts = &offsets[c * tileCount];
+                size_t end = std::min(itemCount, (c + 1) * chunkSize);
+                for (size_t i = c * chunkSize; i < end; ++i) {
+                    forEachTile(i, [&](int tile) { counts[tile]++; });
+                }
+            }
+        });
+
+        start.assign(tileCount + 1, 0);
+        size_t running = 0;
+        for (size_t t = 0; t < tileCount; ++t) {
+            start[t] = running;
+            for (size_t c = 0; c < chunks; ++c) {
+                size_t count = offsets[c * tileCount + t];
+                offsets[c * tileCount + t] = running;
+                running += count;
+            }
+        }
+        start[tileCount] = running;
+        items.resize(running);
+
+        parallelFor(chunks, 1, [&](size_t first, size_t last, int) {
+            for (size_t c = first; c < last; ++c) {
+                size_t* next = &offsets[c * tileCount];
+                size_t end = std::min(itemCount, (c + 1) * chunkSize);
+                for (size_t i = c * chunkSize; i < end; ++i) {
+                    forEachTile(i, [&](int tile) { items[next[tile]++] = (uint32_t)i; });
+                }
+            }
+        });
+    }
+
+    void blend(float* pixel, const glm::vec3& color, float alpha) {
+        pixel[0] += (color.x - pixel[0]) * alpha;
+        pixel[1] += (color.y - pixel[1]) * alpha;
+        pixel[2] += (color.z - pixel[2]) * alpha;
+    }
+
+    // Anti-aliased segment in tile-local pixel coordinates. Walks the major
+    // axis and only tests the few pixels across the line at each step.
+    void drawSegment(float* canvas, int stride, int tileWidth, int tileHeight,
+                     glm::vec2 a, glm::vec2 b, float halfWidth, const glm::vec3& color) {
+        const float reach = halfWidth + 0.5f;
+        bool steep = std::fabs(b.y - a.y) > std::fabs(b.x - a.x);
+        if (steep) {
+            std::swap(a.x, a.y);
+            std::swap(b.x, b.y);
+            std::swap(tileWidth, tileHeight);
+        }
+        glm::vec2 d = b - a;
+        float length2 = d.x * d.x + d.y * d.y;
+        float slope = d.x != 0.0f ? d.y / d.x : 0.0f;
+        float secant = std::sqrt(1.0f + slope * slope);
+        float cosine = 1.0f / secant;
+        float spread = reach * secant;
+        float xMin = std::min(a.x, b.x), xMax = std::max(a.x, b.x);
+
+        // Clamped before converting: the ends may lie far outside the tile.
+        int first = (int)std::floor(std::max(xMin - reach, 0.0f));
+        int last = std::min(tileWidth - 1, (int)std::ceil(std::min(xMax + reach, (float)tileWidth)));
+        for (int x = first; x <= last; ++x) {
+            float cx = x + 0.5f;
+            float cy = a.y + (std::min(xMax, std::max(xMin, cx)) - a.x) * slope;
+            // Away from the ends the nearest point is on the line itself and
+            // the distance is the vertical offset times the cosine.
+            bool interior = cx >= xMin + reach && cx <= xMax - reach;
+            int top = (int)std::floor(std::max(cy - spread, 0.0f));
+            int bottom = std::min(tileHeight - 1, (int)std::ceil(std::min(cy + spread, (float)tileHeight)));
+            for (int y = top; y <= bottom; ++y) {
+                float py = y + 0.5f;
+                float distance;
+                if (interior) {
+                    distance = std::fabs(py - cy) * cosine;
+                }
+                else {
+                    float t = length2 > 0.0f ? ((cx - a.x) * d.x + (py - a.y) * d.y) / length2 : 0.0f;
+                    t = std::min(1.0f, std::max(0.0f, t));
+                    float dx = a.x + t * d.x - cx, dy = a.y + t * d.y - py;
+                    distance = std::sqrt(dx * dx + dy * dy);
+                }
+                float coverage = reach - distance;
+                if (coverage <= 0.0f) continue;
+                float* pixel = steep ? &canvas[((size_t)x * stride + y) * 3] : &canvas[((size_t)y * stride + x) * 3];
+                blend(pixel, color, std::min(1.0f, coverage));
+            }
+        }
+    }
+
+    void drawDisc(float* canvas, int stride, int tileWidth, int tileHeight,
+                  const glm::vec2& centre, float radius, const glm::vec3& color) {
+        const float reach = radius + 0.5f;
+        int left = std::max(0, (int)std::floor(centre.x - reach));
+        int right = std::min(tileWidth - 1, (int)std::ceil(centre.x + reach));
+        int top = std::max(0, (int)std::floor(centre.y - reach));
+        int bottom = std::min(tileHeight - 1, (int)std::ceil(centre.y + reach));
+        for (int y = top; y <= bottom; ++y) {
+            for (int x = left; x <= right; ++x) {
+                float dx = x + 0.5f - centre.x, dy = y + 0.5f - centre.y;
+                float coverage = reach - std::sqrt(dx * dx + dy * dy);
+                if (coverage > 0.0f) blend(&canvas[((size_t)y * stride + x) * 3], color, std::min(1.0f, coverage));
+            }
+        }
+    }
+
+    // --- PNG output -------------------------------------------------------
+    // Rows use the Sub filter, so flat areas become runs of zeros, and are
+    // deflated with the fixed Huffman code plus distance-1 matches (run
+    // length encoding). Each piece ends with an empty stored block, which
+    // byte-aligns it, so pieces deflated on different threads can simply be
+    // concatenated; their Adler-32 sums are combined afterwards.
+
+    struct DeflateTables {
+        uint16_t code[288];
+        uint8_t bits[288];
+        uint16_t lengthSymbol[259];
+        uint8_t lengthExtraBits[259];
+        uint16_t lengthExtra[259];
+        uint32_t crc[256];
+
+        DeflateTables() {
+            for (int s = 0; s < 288; ++s) {
+                int value, count;
+                if (s < 144) { value = 0x30 + s; count = 8; }
+                else if (s < 256) { value = 0x190 + s - 144; count = 9; }
+                else if (s < 280) { value = s - 256; count = 7; }
+                else { value = 0xc0 + s - 280; count = 8; }
+                // Huffman codes go into the stream most significant bit first.
+                int reversed = 0;
+                for (int b = 0; b < count; ++b) reversed |= ((value >> b) & 1) << (count - 1 - b);
+                code[s] = (uint16_t)reversed;
+                bits[s] = (uint8_t)count;
+            }
+
+            static const int base[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+            static const int extra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+            int k = 0;
+            for (int length = 3; length <= 258; ++length) {
+                while (k < 28 && base[k + 1] <= length) ++k;
+                lengthSymbol[length] = (uint16_t)(257 + k);
+                lengthExtraBits[length] = (uint8_t)extra[k];
+                lengthExtra[length] = (uint16_t)(length - base[k]);
+            }
+
+            for (uint32_t n = 0; n < 256; ++n) {
+                uint32_t c = n;
+                for (int b = 0; b < 8; ++b) c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+                crc[n] = c;
+            }
+        }
+    };
+
+    const DeflateTables& deflateTables() {
+        static const DeflateTables tables;
+        return tables;
+    }
+
+    struct BitWriter {
+        std::string& out;
+        uint64_t bits = 0;
+        int count = 0;
+
+        explicit BitWriter(std::string& target) : out(target) {}
+
+        void put(uint32_t value, int n) {
+            bits |= (uint64_t)value << count;
+            count += n;
+            while (count >= 8) {
+                out.push_back((char)(bits & 0xff));
+                bits >>= 8;
+                count -= 8;
+            }
+        }
+
+        void align() {
+            if (count > 0) out.push_back((char)(bits & 0xff));
+            bits = 0;
+            count = 0;
+        }
+    };
+
+    uint32_t adler32(uint32_t adler, const unsigned char* p, size_t n) {
+        uint32_t a = adler & 0xffff, b = adler >> 16;
+        while (n > 0) {
+            size_t k = std::min<size_t>(n, 5552);
+            n -= k;
+            while (k--) {
+                a += *p++;
+                b += a;
+            }
+            a %= 65521;
+            b %= 65521;
+        }
+        return (b << 16) | a;
+    }
+
+    // Adler-32 of A followed by B from the sums of A and B.
+    uint32_t adler32Combine(uint32_t adler1, uint32_t adler2, size_t length2) {
+        const uint32_t base = 65521;
+        uint32_t remainder = (uint32_t)(length2 % base);
+        uint32_t sum1 = adler1 & 0xffff;
+        uint32_t sum2 = (uint32_t)(((uint64_t)remainder * sum1) % base);
+        sum1 += (adler2 & 0xffff) + base - 1;
+        sum2 += ((adler1 >> 16) & 0xffff) + ((adler2 >> 16) & 0xffff) + base - remainder;
+        if (sum1 >= base) sum1 -= base;
+        if (sum1 >= base) sum1 -= base;
+        if (sum2 >= (base << 1)) sum2 -= (base << 1);
+        if (sum2 >= base) sum2 -= base;
+        return sum1 | (sum2 << 16);
+    }
+
+    uint32_t crc32(uint32_t crc, const char* p, size_t n) {
+        const uint32_t* table = deflateTables().crc;
+        crc = ~crc;
+        for (size_t i = 0; i < n; ++i) crc = table[(crc ^ (unsigned char)p[i]) & 0xff] ^ (crc >> 8);
+        return ~crc;
+    }
+
+    struct Deflated {
+        std::string bytes;
+        uint32_t adler = 1;
+        size_t length = 0;   // uncompressed bytes
+    };
+
+    // Filters and deflates `rows` rows of packed RGB pixels.
+    void deflateRows(const unsigned char* pixels, int width, int rows, std::vector<unsigned char>& scratch, Deflated& out) {
+        const DeflateTables& tables = deflateTables();
+        const size_t stride = (size_t)width * 3;
+        const size_t rowBytes = stride + 1;
+        scratch.resize(rowBytes * rows);
+        for (int r = 0; r < rows; ++r) {
+            unsigned char* dst = &scratch[r * rowBytes];
+            const unsigned char* src = pixels + r * stride;
+            dst[0] = 1;   // Sub
+            for (size_t i = 0; i < stride; ++i) dst[1 + i] = (unsigned char)(src[i] - (i >= 3 ? src[i - 3] : 0));
+        }
+
+        const unsigned char* data = scratch.data();
+        const size_t n = scratch.size();
+        out.length = n;
+        out.adler = adler32(1, data, n);
+        out.bytes.clear();
+        out.bytes.reserve(n / 8 + 64);
+
+        BitWriter writer(out.bytes);
+        writer.put(0, 1);   // not final
+        writer.put(1, 2);   // fixed Huffman
+        size_t i = 0;
+        while (i < n) {
+            size_t run = 0;
+            if (i > 0) {
+                while (run < 258 && i + run < n && data[i + run] == data[i - 1]) ++run;
+            }
+            if (run >= 3) {
+                uint16_t symbol = tables.lengthSymbol[run];
+                writer.put(tables.code[symbol], tables.bits[symbol]);
+                if (tables.lengthExtraBits[run]) writer.put(tables.lengthExtra[run], tables.lengthExtraBits[run]);
+                writer.put(0, 5);   // distance 1
+                i += run;
+            }
+            else {
+                writer.put(tables.code[data[i]], tables.bits[data[i]]);
+                ++i;
+            }
+        }
+        writer.put(tables.code[256], tables.bits[256]);
+
+        writer.put(0, 3);   // empty stored block
+        writer.align();
+        out.bytes.append("\x00\x00\xff\xff", 4);
+    }
+
+    void putBigEndian(std::string& out, uint32_t value) {
+        out.push_back((char)(value >> 24));
+        out.push_back((char)(value >> 16));
+        out.push_back((char)(value >> 8));
+        out.push_back((char)value);
+    }
+
+    size_t writeChunk(std::ostream& file, const char* type, const std::vector<const std::string*>& pieces) {
+        size_t length = 0;
+        for (const std::string* piece : pieces) length += piece->size();
+        std::string head;
+        putBigEndian(head, (uint32_t)length);
+        head.append(type, 4);
+        uint32_t crc = crc32(0, type, 4);
+        for (const std::string* piece : pieces) crc = crc32(crc, piece->data(), piece->size());
+        std::string tail;
+        putBigEndian(tail, crc);
+
+        file.write(head.data(), head.size());
+        for (const std::string* piece : pieces) file.write(piece->data(), piece->size());
+        file.write(tail.data(), tail.size());
+        return length + 12;
+    }
+
+    size_t writeChunk(std::ostream& file, const char* type, const std::string& data) {
+        return writeChunk(file, type, std::vector<const std::string*>(1, &data));
+    }
+
+    size_t writeHeader(std::ostream& file, int width, int height) {
+        file.write("\x89PNG\r\n\x1a\n", 8);
+        std::string header;
+        putBigEndian(header, (uint32_t)width);
+        putBigEndian(header, (uint32_t)height);
+        header.append("\x08\x02\x00\x00\x00", 5);   // 8-bit RGB, no interlace
+        std::string zlibHeader("\x78\x01", 2);
+        return 8 + writeChunk(file, "IHDR", header) + writeChunk(file, "IDAT", zlibHeader);
+    }
+
+    size_t writeTrailer(std::ostream& file, uint32_t adler) {
+        std::string end("\x03\x00", 2);   // final empty fixed-Huffman block
+        putBigEndian(end, adler);
+        return writeChunk(file, "IDAT", end) + writeChunk(file, "IEND", std::string());
+    }
+
+    void toBytes(const std::vector<float>& canvas, int stride, int width, int height, unsigned char* out, size_t outStride) {
+        for (int y = 0; y < height; ++y) {
+            const float* src = &canvas[(size_t)y * stride * 3];
+            unsigned char* dst = out + y * outStride;
+            for (int i = 0; i < width * 3; ++i) {
+                dst[i] = (unsigned char)(std::min(1.0f, std::max(0.0f, src[i])) * 255.0f + 0.5f);
+            }
+        }
+    }
+
+    void flatten(const Graph& graph, std::vector<glm::vec3>& positions, std::vector<uint32_t>& edgeIndices) {
+        positions.reserve(graph.nodes.size());
+        for (const auto& node : graph.nodes) positions.push_back(node.position);
+        edgeIndices.reserve(graph.edges.size() * 2);
+        for (const auto& edge : graph.edges) {
+            edgeIndices.push_back((uint32_t)edge.from);
+            edgeIndices.push_back((uint32_t)edge.to);
+        }
+    }
+}
+
+void RasterExporter::project(const std::vector<glm::vec3>& positions, const glm::mat4& viewMatrix,
+    const glm::mat4& projectionMatrix, int width, int height) {
+    const glm::mat4 MVP = projectionMatrix * viewMatrix;
+    screen.resize(positions.size());
+    visible.resize(positions.size());
+    parallelFor(positions.size(), 4096, [&](size_t first, size_t last, int) {
+        for (size_t i = first; i < last; ++i) {
+            glm::vec4 clip = MVP * glm::vec4(positions[i], 1.0f);
+            visible[i] = clip.w > 0.0f;
+            if (clip.w != 0.0f) clip /= clip.w;
+            screen[i] = glm::vec2((clip.x * 0.5f + 0.5f) * width, (1.0f - (clip.y * 0.5f + 0.5f)) * height);
+            if (!std::isfinite(screen[i].x) || !std::isfinite(screen[i].y)) visible[i] = 0;
+        }
+    });
+}
+
+void RasterExporter::bin(const std::vector<uint32_t>& edgeIndices, float scale, int width, int height, Bins& bins) const {
+    const int T = tileSize;
+    bins.columns = (width + T - 1) / T;
+    bins.rows = (height + T - 1) / T;
+    const size_t tiles = (size_t)bins.columns * bins.rows;
+    const size_t n = screen.size();
+
+    const float edgeReach = edgeWidth * scale * 0.5f + 1.0f;
+    binItems(edgeIndices.size() / 2, tiles, [&](size_t e, auto emit) {
+        uint32_t from = edgeIndices[2 * e], to = edgeIndices[2 * e + 1];
+        if (from >= n || to >= n || !visible[from] || !visible[to]) return;
+        forEachEdgeTile(screen[from] * scale, screen[to] * scale, edgeReach, T, bins.columns, bins.rows, emit);
+    }, bins.edgeStart, bins.edgeItems);
+
+    const float nodeReach = nodeRadius * scale + 1.0f;
+    binItems(n, tiles, [&](size_t i, auto emit) {
+        if (!visible[i]) return;
+        glm::vec2 p = screen[i] * scale;
+        int firstRow = std::max(0, tileOf(p.y - nodeReach, T, bins.rows));
+        int lastRow = std::min(bins.rows - 1, tileOf(p.y + nodeReach, T, bins.rows));
+        int firstColumn = std::max(0, tileOf(p.x - nodeReach, T, bins.columns));
+        int lastColumn = std::min(bins.columns - 1, tileOf(p.x + nodeReach, T, bins.columns));
+        for (int row = firstRow; row <= lastRow; ++row) {
+            for (int column = firstColumn; column <= lastColumn; ++column) emit(row * bins.columns + column);
+        }
+    }, bins.nodeStart, bins.nodeItems);
+}
+
+void RasterExporter::drawTile(const Bins& bins, const std::vector<uint32_t>& edgeIndices, float scale, int column, int row,
+    int width, int height, std::vector<float>& canvas) const {
+    const int T = tileSize;
+    const glm::vec2 origin((float)column * T, (float)row * T);
+    const int tileWidth = std::min(T, width - column * T);
+    const int tileHeight = std::min(T, height - row * T);
+    canvas.resize((size_t)T * T * 3);
+    for (int y = 0; y < tileHeight; ++y) {
+        for (int x = 0; x < tileWidth; ++x) {
+            float* pixel = &canvas[((size_t)y * T + x) * 3];
+            pixel[0] = backgroundColor.x;
+            pixel[1] = backgroundColor.y;
+            pixel[2] = backgroundColor.z;
+        }
+    }
+
+    const size_t tile = (size_t)row * bins.columns + column;
+    const float halfWidth = edgeWidth * scale * 0.5f;
+    for (size_t k = bins.edgeStart[tile]; k < bins.edgeStart[tile + 1]; ++k) {
+        uint32_t e = bins.edgeItems[k];
+        glm::vec2 a = screen[edgeIndices[2 * e]] * scale - origin;
+        glm::vec2 b = screen[edgeIndices[2 * e + 1]] * scale - origin;
+        drawSegment(canvas.data(), T, tileWidth, tileHeight, a, b, halfWidth, edgeColor);
+    }
+    const float radius = nodeRadius * scale;
+    for (size_t k = bins.nodeStart[tile]; k < bins.nodeStart[tile + 1]; ++k) {
+        drawDisc(canvas.data(), T, tileWidth, tileHeight, screen[bins.nodeItems[k]] * scale - origin, radius, nodeColor);
+    }
+}
+
+bool RasterExporter::exportPNG(const Graph& graph, const std::string& filename, const glm::mat4& viewMatrix,
+    const glm::mat4& projectionMatrix, int width, int height) {
+    std::vector<glm::vec3> positions;
+    std::vector<uint32_t> edgeIndices;
+    flatten(graph, positions, edgeIndices);
+    return exportPNG(positions, edgeIndices, filename, viewMatrix, projectionMatrix, width, height);
+}
+
+bool RasterExporter::exportPNG(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& edgeIndices,
+    const std::string& filename, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix, int width, int height) {
+    error.clear();
+    binSeconds = rasterSeconds = encodeSeconds = 0.0;
+    tileReferences = 0;
+    bytesWritten = 0;
+    if (width <= 0 || height <= 0 || tileSize <= 0) {
+        error = "invalid image size";
+        return false;
+    }
+
+    std::ofstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        error = "cannot create " + filename;
+        std::cerr << "Unable to create PNG file: " << filename << std::endl;
+        return false;
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    project(positions, viewMatrix, projectionMatrix, width, height);
+    Bins bins;
+    bin(edgeIndices, 1.0f, width, height, bins);
+    tileReferences = bins.edgeItems.size() + bins.nodeItems.size();
+    binSeconds = secondsSince(begin);
+
+    bytesWritten += writeHeader(file, width, height);
+
+    const int T = tileSize;
+    const int tileRowsPerStrip = std::max(1, (stripHeight + T - 1) / T);
+    const size_t stride = (size_t)width * 3;
+    std::vector<unsigned char> strip(stride * std::min(height, tileRowsPerStrip * T));
+    const int workers = ThreadPool::instance().size();
+    std::vector<std::vector<float>> canvases(workers);
+    std::vector<std::vector<unsigned char>> scratch(workers);
+    // Rows per deflate piece: enough to keep each piece well compressed,
+    // few enough that a strip splits across all workers.
+    const int groupRows = 32;
+    std::vector<Deflated> pieces;
+    uint32_t adler = 1;
+
+    for (int row0 = 0; row0 < bins.rows; row0 += tileRowsPerStrip) {
+        const int rowEnd = std::min(bins.rows, row0 + tileRowsPerStrip);
+        const int yBegin = row0 * T;
+        const int yEnd = std::min(height, rowEnd * T);
+
+        auto rasterBegin = std::chrono::steady_clock::now();
+        const size_t stripTiles = (size_t)(rowEnd - row0) * bins.columns;
+        parallelFor(stripTiles, 1, [&](size_t first, size_t last, int worker) {
+            for (size_t k = first; k < last; ++k) {
+                int column = (int)(k % bins.columns);
+                int row = row0 + (int)(k / bins.columns);
+                drawTile(bins, edgeIndices, 1.0f, column, row, width, height, canvases[worker]);
+                int tileWidth = std::min(T, width - column * T);
+                int tileHeight = std::min(T, height - row * T);
+                toBytes(canvases[worker], T, tileWidth, tileHeight,
+                    &strip[(size_t)(row * T - yBegin) * stride + (size_t)column * T * 3], stride);
+            }
+        });
+        rasterSeconds += secondsSince(rasterBegin);
+
+        auto encodeBegin = std::chrono::steady_clock::now();
+        const int stripRows = yEnd - yBegin;
+        const size_t groups = (size_t)(stripRows + groupRows - 1) / groupRows;
+        pieces.resize(groups);
+        parallelFor(groups, 1, [&](size_t first, size_t last, int worker) {
+            for (size_t g = first; g < last; ++g) {
+                int rows = std::min(groupRows, stripRows - (int)g * groupRows);
+                deflateRows(&strip[g * groupRows * stride], width, rows, scratch[worker], pieces[g]);
+            }
+        });
+        std::vector<const std::string*> data;
+        for (size_t g = 0; g < groups; ++g) {
+            adler = adler32Combine(adler, pieces[g].adler, pieces[g].length);
+            data.push_back(&pieces[g].bytes);
+        }
+        bytesWritten += writeChunk(file, "IDAT", data);
+        encodeSeconds += secondsSince(encodeBegin);
+
+        if (!file.good()) {
+            error = "write failed: " + filename;
+            std::cerr << "Unable to write PNG file: " << filename << std::endl;
+            return false;
+        }
+    }
+
+    bytesWritten += writeTrailer(file, adler);
+    file.close();
+    if (!file.good()) {
+        error = "write failed: " + filename;
+        std::cerr << "Unable to write PNG file: " << filename << std::endl;
+        return false;
+    }
+
+    std::cout << "PNG exported successfully: " << filename << " (" << width << "x" << height << ", "
+              << bytesWritten / 1048576.0 << " MB, bin " << binSeconds << " s, raster " << rasterSeconds
+              << " s, encode " << encodeSeconds << " s)" << std::endl;
+    return true;
+}
+
+bool RasterExporter::exportPyramid(const Graph& graph, const std::string& filename, const glm::mat4& viewMatrix,
+    const glm::mat4& projectionMatrix, int width, int height) {
+    std::vector<glm::vec3> positions;
+    std::vector<uint32_t> edgeIndices;
+    flatten(graph, positions, edgeIndices);
+    return exportPyramid(positions, edgeIndices, filename, viewMatrix, projectionMatrix, width, height);
+}
+
+bool RasterExporter::exportPyramid(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& edgeIndices,
+    const std::string& filename, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix, int width, int height) {
+    error.clear();
+    binSeconds = rasterSeconds = encodeSeconds = 0.0;
+    tileReferences = 0;
+    bytesWritten = 0;
+    if (width <= 0 || height <= 0 || tileSize <= 0) {
+        error = "invalid image size";
+        return false;
+    }
+
+    std::string base = filename;
+    if (base.size() > 4 && base.compare(base.size() - 4, 4, ".dzi") == 0) base.resize(base.size() - 4);
+    const std::string directory = base + "_files";
+    if (!makeDirectory(directory)) {
+        error = "cannot create " + directory;
+        std::cerr << "Unable to create tile directory: " << directory << std::endl;
+        return false;
+    }
+    {
+        std::ofstream descriptor(base + ".dzi");
+        descriptor << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+        descriptor << "<Image xmlns=\"http://schemas.microsoft.com/deepzoom/2008\" TileSize=\"" << tileSize
+                   << "\" Overlap=\"0\" Format=\"png\">\n";
+        descriptor << "  <Size Width=\"" << width << "\" Height=\"" << height << "\"/>\n";
+        descriptor << "</Image>\n";
+        if (!descriptor.good()) {
+            error = "cannot write " + base + ".dzi";
+            std::cerr << "Unable to create DZI file: " << base << ".dzi" << std::endl;
+            return false;
+        }
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    project(positions, viewMatrix, projectionMatrix, width, height);
+    binSeconds += secondsSince(begin);
+
+    // Level L is the full image scaled by 2^(L - top); level 0 is 1x1.
+    int top = 0;
+    while ((1 << top) < std::max(width, height)) ++top;
+
+    const int T = tileSize;
+    const int workers = ThreadPool::instance().size();
+    std::vector<std::vector<float>> canvases(workers);
+    std::vector<std::vector<unsigned char>> pixels(workers);
+    std::vector<std::vector<unsigned char>> scratch(workers);
+    std::vector<Deflated> pieces(workers);
+    std::atomic<size_t> written(0);
+    std::atomic<bool> failed(false);
+
+    for (int level = top; level >= 0 && !failed.load(); --level) {
+        const float scale = std::ldexp(1.0f, level - top);
+        const int levelWidth = std::max(1, (int)std::ceil(width * scale));
+        const int levelHeight = std::max(1, (int)std::ceil(height * scale));
+        std::ostringstream levelDirectory;
+        levelDirectory << directory << "/" << level;
+        if (!makeDirectory(levelDirectory.str())) {
+            error = "cannot create " + levelDirectory.str();
+            std::cerr << "Unable to create tile directory: " << levelDirectory.str() << std::endl;
+            return false;
+        }
+
+        auto binBegin = std::chrono::steady_clock::now();
+        Bins bins;
+        bin(edgeIndices, scale, levelWidth, levelHeight, bins);
+        tileReferences += bins.edgeItems.size() + bins.nodeItems.size();
+        binSeconds += secondsSince(binBegin);
+
+        auto rasterBegin = std::chrono::steady_clock::now();
+        parallelFor((size_t)bins.columns * bins.rows, 1, [&](size_t first, size_t last, int worker) {
+            for (size_t k = first; k < last && !failed.load(); ++k) {
+                int column = (int)(k % bins.columns);
+                int row = (int)(k / bins.columns);
+                int tileWidth = std::min(T, levelWidth - column * T);
+                int tileHeight = std::min(T, levelHeight - row * T);
+                drawTile(bins, edgeIndices, scale, column, row, levelWidth, levelHeight, canvases[worker]);
+                pixels[worker].resize((size_t)tileWidth * tileHeight * 3);
+                toBytes(canvases[worker], T, tileWidth, tileHeight, pixels[worker].data(), (size_t)tileWidth * 3);
+                deflateRows(pixels[worker].data(), tileWidth, tileHeight, scratch[worker], pieces[worker]);
+
+                std::ostringstream path;
+                path << levelDirectory.str() << "/" << column << "_" << row << ".png";
+                std::ofstream file(path.str(), std::ios::binary);
+                size_t bytes = writeHeader(file, tileWidth, tileHeight);
+                bytes += writeChunk(file, "IDAT", pieces[worker].bytes);
+                bytes += writeTrailer(file, pieces[worker].adler);
+                if (!file.good()) failed.store(true);
+                written += bytes;
+            }
+        });
+        rasterSeconds += secondsSince(rasterBegin);
+    }
+
+    bytesWritten = written.load();
+    if (failed.load()) {
+        error = "cannot write tiles under " + directory;
+        std::cerr << "Unable to write tiles under " << directory << std::endl;
+        return false;
+    }
+    std::cout << "Tile pyramid exported successfully: " << base << ".dzi (" << top + 1 << " levels, "
+              << bytesWritten / 1048576.0 << " MB, " << secondsSince(begin) << " s)" << std::endl;
+    return true;
+}
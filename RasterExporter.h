@@ -0,0 +1,66 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+class Graph;
+
+// Software rasterizer for poster-size PNG exports. Uses the same projection
+// as Graph::exportToSVG and needs no GPU or window. The image is split into
+// square tiles; edges and nodes are binned into the tiles they touch and the
+// tiles are drawn (anti-aliased) in parallel. Only `stripHeight` rows of the
+// image are held at once: each strip is filtered, deflated in parallel and
+// appended to the file before the next one is drawn, so the output may be
+// larger than memory.
+//
+// exportPyramid writes a Deep Zoom image (.dzi plus a _files directory with
+// one folder of tiles per level) for viewers such as OpenSeadragon; every
+// level is rendered from the geometry rather than downsampled.
+class RasterExporter {
+public:
+    int tileSize = 256;
+    int stripHeight = 2048;   // rounded up to whole tile rows
+    float nodeRadius = 4.0f;
+    float edgeWidth = 1.5f;
+    glm::vec3 backgroundColor = glm::vec3(0x1a / 255.0f);
+    glm::vec3 edgeColor = glm::vec3(0xb3 / 255.0f);
+    glm::vec3 nodeColor = glm::vec3(0.0f, 1.0f, 0.0f);
+
+    bool exportPNG(const Graph& graph, const std::string& filename, const glm::mat4& viewMatrix,
+        const glm::mat4& projectionMatrix, int width, int height);
+    bool exportPNG(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& edgeIndices,
+        const std::string& filename, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix, int width, int height);
+
+    // `filename` names the .dzi descriptor; tiles go to <name>_files/.
+    bool exportPyramid(const Graph& graph, const std::string& filename, const glm::mat4& viewMatrix,
+        const glm::mat4& projectionMatrix, int width, int height);
+    bool exportPyramid(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& edgeIndices,
+        const std::string& filename, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix, int width, int height);
+
+    // Filled by the last export.
+    std::string error;
+    double binSeconds = 0.0;
+    double rasterSeconds = 0.0;
+    double encodeSeconds = 0.0;
+    size_t tileReferences = 0;   // edge and node entries over all tile bins
+    size_t bytesWritten = 0;
+
+private:
+    struct Bins {
+        int columns = 0;
+        int rows = 0;
+        std::vector<size_t> edgeStart, nodeStart;   // per tile, CSR into the item lists
+        std::vector<uint32_t> edgeItems, nodeItems;
+    };
+
+    void project(const std::vector<glm::vec3>& positions, const glm::mat4& viewMatrix,
+        const glm::mat4& projectionMatrix, int width, int height);
+    void bin(const std::vector<uint32_t>& edgeIndices, float scale, int width, int height, Bins& bins) const;
+    void drawTile(const Bins& bins, const std::vector<uint32_t>& edgeIndices, float scale, int column, int row,
+        int width, int height, std::vector<float>& canvas) const;
+
+    // Pixel coordinates at full size; nodes behind the camera are flagged.
+    std::vector<glm::vec2> screen;
+    std::vector<unsigned char> visible;
+};
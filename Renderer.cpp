@@ -1,23 +1,33 @@
 #include "Renderer.h"
+#include <algorithm>
 #include <iostream>
 
-Renderer::Renderer() : VAO(0), VBO(0), EBO(0), shaderProgram(0) {
-    edgeVerticesCache.reserve(10000);
+Renderer::Renderer() : VAO(0), VBO(0), EBO(0), colorVBO(0), pathEBO(0), nodeVAO(0), radiusVBO(0), flagVBO(0),
+    shaderProgram(0), nodeShaderProgram(0) {
 }
 
 Renderer::~Renderer() {
     glDeleteVertexArrays(1, &VAO);
     glDeleteBuffers(1, &VBO);
     glDeleteBuffers(1, &EBO);
+    glDeleteBuffers(1, &colorVBO);
+    glDeleteBuffers(1, &pathEBO);
+    glDeleteVertexArrays(1, &nodeVAO);
+    glDeleteBuffers(1, &radiusVBO);
+    glDeleteBuffers(1, &flagVBO);
     glDeleteProgram(shaderProgram);
+    glDeleteProgram(nodeShaderProgram);
 }
 
 void Renderer::initialize() {
     shaderProgram = createShader(std::string(vertexShaderSource), std::string(fragmentShaderSource));
+    nodeShaderProgram = createShader(std::string(nodeVertexShaderSource), std::string(nodeFragmentShaderSource));
 
     glGenVertexArrays(1, &VAO);
     glGenBuffers(1, &VBO);
     glGenBuffers(1, &EBO);
+    glGenBuffers(1, &colorVBO);
+    glGenBuffers(1, &pathEBO);
 
     glBindVertexArray(VAO);
 
@@ -25,64 +35,233 @@ void Renderer::initialize() {
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
 
+    glBindBuffer(GL_ARRAY_BUFFER, colorVBO);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+
+    glBindVertexArray(0);
+
+    // Same position and colour buffers, read once per instance. The
+    // per-instance arrays are enabled at draw time only when they cover
+    // every node; otherwise the generic attribute values apply.
+    glGenVertexArrays(1, &nodeVAO);
+    glGenBuffers(1, &radiusVBO);
+    glGenBuffers(1, &flagVBO);
+
+    glBindVertexArray(nodeVAO);
+
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    glVertexAttribDivisor(0, 1);
+    glEnableVertexAttribArray(0);
+
+    glBindBuffer(GL_ARRAY_BUFFER, colorVBO);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    glVertexAttribDivisor(1, 1);
+
+    glBindBuffer(GL_ARRAY_BUFFER, radiusVBO);
+    glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, sizeof(float), (void*)0);
+    glVertexAttribDivisor(2, 1);
+
+    glBindBuffer(GL_ARRAY_BUFFER, flagVBO);
+    glVertexAttribIPointer(3, 1, GL_UNSIGNED_INT, sizeof(unsigned int), (void*)0);
+    glVertexAttribDivisor(3, 1);
+
     glBindVertexArray(0);
 }
 
-void Renderer::renderNodes(const std::vector<glm::vec3>& positions, const glm::mat4& MVP) {
-    if (positions.empty()) return;
+void Renderer::patchBuffer(GLenum target, size_t& capacity, const void* data, size_t elementSize,
+    size_t count, size_t begin, size_t end) {
+    if (count > capacity) {
+        // Grow geometrically so streaming inserts do not reallocate every frame.
+        capacity = std::max(count, std::max(capacity + capacity / 2, (size_t)1024));
+        glBufferData(target, capacity * elementSize, NULL, GL_DYNAMIC_DRAW);
+        begin = 0;
+        end = count;
+    }
 
-    glUseProgram(shaderProgram);
+    end = std::min(end, count);
+    if (begin < end) {
+        glBufferSubData(target, begin * elementSize, (end - begin) * elementSize,
+            static_cast<const char*>(data) + begin * elementSize);
+    }
+}
 
-    int colorLoc = glGetUniformLocation(shaderProgram, "color");
-    glUniform3f(colorLoc, 0.0f, 1.0f, 0.0f);
+void Renderer::setPositionFormat(bool quantized) {
+    if (quantized == quantizedPositions) return;
 
-    int mvpLoc = glGetUniformLocation(shaderProgram, "MVP");
-    glUniformMatrix4fv(mvpLoc, 1, GL_FALSE, &MVP[0][0]);
+    // The element size changes, so the old storage cannot be patched.
+    quantizedPositions = quantized;
+    positionCapacity = 0;
 
-    glBindVertexArray(VAO);
+    const GLuint arrays[] = { VAO, nodeVAO };
+    for (GLuint vao : arrays) {
+        glBindVertexArray(vao);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        if (quantized) {
+            glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, 3 * sizeof(unsigned short), (void*)0);
+        }
+        else {
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+        }
+    }
+    glBindVertexArray(0);
+    if (!quantized) {
+        positionOrigin = glm::vec3(0.0f);
+        positionExtent = glm::vec3(1.0f);
+    }
+}
+
+void Renderer::setPositionUniforms(GLuint program) {
+    glUniform3f(glGetUniformLocation(program, "positionOrigin"), positionOrigin.x, positionOrigin.y, positionOrigin.z);
+    glUniform3f(glGetUniformLocation(program, "positionExtent"), positionExtent.x, positionExtent.y, positionExtent.z);
+}
+
+void Renderer::uploadPositions(const std::vector<glm::vec3>& positions, size_t begin, size_t end) {
+    setPositionFormat(false);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    patchBuffer(GL_ARRAY_BUFFER, positionCapacity, positions.data(), sizeof(glm::vec3), positions.size(), begin, end);
+    nodeCount = positions.size();
+}
 
+void Renderer::uploadQuantizedPositions(const std::vector<unsigned short>& packed, size_t begin, size_t end,
+    const glm::vec3& origin, const glm::vec3& extent) {
+    setPositionFormat(true);
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, positions.size() * sizeof(glm::vec3), positions.data(), GL_DYNAMIC_DRAW);
+    patchBuffer(GL_ARRAY_BUFFER, positionCapacity, packed.data(), 3 * sizeof(unsigned short), packed.size() / 3, begin, end);
+    nodeCount = packed.size() / 3;
+    positionOrigin = origin;
+    positionExtent = extent;
+}
+
+size_t Renderer::gpuBytes() const {
+    size_t positionSize = quantizedPositions ? 3 * sizeof(unsigned short) : sizeof(glm::vec3);
+    return positionCapacity * positionSize + colorCapacity * sizeof(glm::vec3) + radiusCapacity * sizeof(float) +
+        (indexCapacity + pathCapacity + flagCapacity) * sizeof(unsigned int);
+}
+
+void Renderer::uploadColors(const std::vector<glm::vec3>& colors) {
+    uploadColors(colors, 0, colors.size());
+}
+
+void Renderer::uploadColors(const std::vector<glm::vec3>& colors, size_t begin, size_t end) {
+    glBindBuffer(GL_ARRAY_BUFFER, colorVBO);
+    patchBuffer(GL_ARRAY_BUFFER, colorCapacity, colors.data(), sizeof(glm::vec3), colors.size(), begin, end);
+    colorCount = colors.size();
+}
+
+void Renderer::uploadRadii(const std::vector<float>& radii, size_t begin, size_t end) {
+    glBindBuffer(GL_ARRAY_BUFFER, radiusVBO);
+    patchBuffer(GL_ARRAY_BUFFER, radiusCapacity, radii.data(), sizeof(float), radii.size(), begin, end);
+    radiusCount = radii.size();
+}
+
+void Renderer::uploadFlags(const std::vector<unsigned int>& flags, size_t begin, size_t end) {
+    glBindBuffer(GL_ARRAY_BUFFER, flagVBO);
+    patchBuffer(GL_ARRAY_BUFFER, flagCapacity, flags.data(), sizeof(unsigned int), flags.size(), begin, end);
+    flagCount = flags.size();
+}
 
-    glPointSize(8.0f);
-    glDrawArrays(GL_POINTS, 0, positions.size());
+void Renderer::uploadEdges(const std::vector<unsigned int>& indices, size_t begin, size_t end) {
+    // The element buffer binding is VAO state.
+    glBindVertexArray(VAO);
+    patchBuffer(GL_ELEMENT_ARRAY_BUFFER, indexCapacity, indices.data(), sizeof(unsigned int), indices.size(), begin, end);
+    glBindVertexArray(0);
+    edgeIndexCount = indices.size();
+}
 
+void Renderer::uploadPath(const std::vector<unsigned int>& nodes) {
+    pathCount = nodes.size();
+    if (pathCount == 0) return;
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, pathEBO);
+    patchBuffer(GL_ELEMENT_ARRAY_BUFFER, pathCapacity, nodes.data(), sizeof(unsigned int), nodes.size(), 0, nodes.size());
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
     glBindVertexArray(0);
 }
 
-void Renderer::renderEdges(const std::vector<glm::vec3>& positions, const std::vector<std::pair<int, int>>& edges, const glm::mat4& MVP) {
-    if (edges.empty() || positions.empty()) return;
+void Renderer::renderNodes(const glm::mat4& MVP) {
+    if (nodeCount == 0) return;
+
+    glUseProgram(nodeShaderProgram);
+
+    int mvpLoc = glGetUniformLocation(nodeShaderProgram, "MVP");
+    glUniformMatrix4fv(mvpLoc, 1, GL_FALSE, &MVP[0][0]);
+    setPositionUniforms(nodeShaderProgram);
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    glUniform2f(glGetUniformLocation(nodeShaderProgram, "viewport"), (float)std::max(1, viewport[2]), (float)std::max(1, viewport[3]));
+
+    glBindVertexArray(nodeVAO);
+
+    // Attributes without a full per-node array read these constants.
+    const bool useColors = colorCount == nodeCount;
+    const bool useRadii = radiusCount == nodeCount;
+    const bool useFlags = flagCount == nodeCount;
+    if (useColors) glEnableVertexAttribArray(1);
+    else glVertexAttrib3f(1, 0.0f, 1.0f, 0.0f);
+    if (useRadii) glEnableVertexAttribArray(2);
+    else glVertexAttrib1f(2, nodeRadius);
+    if (useFlags) glEnableVertexAttribArray(3);
+    else glVertexAttribI4ui(3, 0, 0, 0, 0);
+
+    // One draw call for every node.
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei)nodeCount);
+
+    if (useColors) glDisableVertexAttribArray(1);
+    if (useRadii) glDisableVertexAttribArray(2);
+    if (useFlags) glDisableVertexAttribArray(3);
+    glBindVertexArray(0);
+}
+
+void Renderer::renderEdges(const glm::mat4& MVP) {
+    if (edgeIndexCount == 0 || nodeCount == 0) return;
 
     glUseProgram(shaderProgram);
 
     int colorLoc = glGetUniformLocation(shaderProgram, "color");
     glUniform3f(colorLoc, 0.7f, 0.7f, 0.7f);
+    glUniform1i(glGetUniformLocation(shaderProgram, "useVertexColor"), 0);
 
     int mvpLoc = glGetUniformLocation(shaderProgram, "MVP");
     glUniformMatrix4fv(mvpLoc, 1, GL_FALSE, &MVP[0][0]);
+    setPositionUniforms(shaderProgram);
 
     glBindVertexArray(VAO);
 
-    edgeVerticesCache.clear();
-    edgeVerticesCache.reserve(edges.size() * 2);
+    glLineWidth(1.5f);
+    glDrawElements(GL_LINES, (GLsizei)edgeIndexCount, GL_UNSIGNED_INT, (void*)0);
 
-    for (const auto& edge : edges) {
-        if (edge.first < positions.size() && edge.second < positions.size()) {
-            edgeVerticesCache.push_back(positions[edge.first]);
-            edgeVerticesCache.push_back(positions[edge.second]);
-        }
-    }
+    glBindVertexArray(0);
+}
 
-    if (!edgeVerticesCache.empty()) {
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferData(GL_ARRAY_BUFFER, edgeVerticesCache.size() * sizeof(glm::vec3),
-            edgeVerticesCache.data(), GL_DYNAMIC_DRAW);
+void Renderer::renderPath(const glm::mat4& MVP) {
+    if (pathCount == 0 || nodeCount == 0) return;
 
-        glLineWidth(1.5f);
-        glDrawArrays(GL_LINES, 0, edgeVerticesCache.size());
-    }
+    glUseProgram(shaderProgram);
+
+    int colorLoc = glGetUniformLocation(shaderProgram, "color");
+    glUniform3f(colorLoc, 1.0f, 0.55f, 0.0f);
+    glUniform1i(glGetUniformLocation(shaderProgram, "useVertexColor"), 0);
+
+    int mvpLoc = glGetUniformLocation(shaderProgram, "MVP");
+    glUniformMatrix4fv(mvpLoc, 1, GL_FALSE, &MVP[0][0]);
+    setPositionUniforms(shaderProgram);
+
+    // Drawn on top of whatever nodes and edges are in front of the path.
+    GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+    glDisable(GL_DEPTH_TEST);
+
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, pathEBO);
+
+    glLineWidth(4.0f);
+    glDrawElements(GL_LINE_STRIP, (GLsizei)pathCount, GL_UNSIGNED_INT, (void*)0);
 
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
     glBindVertexArray(0);
+    if (depthTest) glEnable(GL_DEPTH_TEST);
 }
 
 GLuint Renderer::createShader(const std::string& vertexCode, const std::string& fragmentCode) {
@@ -7,34 +7,145 @@
 
 class Renderer {
 public:
-    GLuint VAO, VBO, EBO;
-    GLuint shaderProgram;
+    // Per-node flag bits (uploadFlags).
+    enum NodeFlag { NODE_SELECTED = 1 };
+
+    GLuint VAO, VBO, EBO, colorVBO, pathEBO;
+    GLuint nodeVAO, radiusVBO, flagVBO;
+    GLuint shaderProgram, nodeShaderProgram;
+
+    // Node radius in pixels when no per-node radii are uploaded.
+    float nodeRadius = 4.0f;
 
     Renderer();
     ~Renderer();
 
     void initialize();
-    void renderNodes(const std::vector<glm::vec3>& positions, const glm::mat4& MVP);
-    void renderEdges(const std::vector<glm::vec3>& positions, const std::vector<std::pair<int, int>>& edges, const glm::mat4& MVP);
+
+    // The node positions, colours and edge index pairs live in persistent GPU
+    // buffers. Each upload passes the full CPU mirror plus the [begin, end)
+    // element range that changed; only that range is sent unless the buffer
+    // has to grow.
+    void uploadPositions(const std::vector<glm::vec3>& positions, size_t begin, size_t end);
+    void uploadColors(const std::vector<glm::vec3>& colors);
+    void uploadColors(const std::vector<glm::vec3>& colors, size_t begin, size_t end);
+    void uploadEdges(const std::vector<unsigned int>& indices, size_t begin, size_t end);
+
+    // Compact mode: three 16-bit normalized coordinates per node, decoded in
+    // the vertex shader as origin + q * extent (see CompactGraph).
+    void uploadQuantizedPositions(const std::vector<unsigned short>& packed, size_t begin, size_t end,
+        const glm::vec3& origin, const glm::vec3& extent);
+
+    // Per-node radii (pixels) and NodeFlag bits. Colours, radii and flags
+    // are separate instance buffers, so changing one does not resend the
+    // others. An attribute whose array does not match the node count falls
+    // back to the default: uniform green, nodeRadius, no flags.
+    void uploadRadii(const std::vector<float>& radii, size_t begin, size_t end);
+    void uploadFlags(const std::vector<unsigned int>& flags, size_t begin, size_t end);
+
+    // Highlighted path: node indices in order, drawn over the graph as a
+    // line strip through the node positions already on the GPU.
+    void uploadPath(const std::vector<unsigned int>& nodes);
+
+    size_t gpuBytes() const;
+
+    void renderNodes(const glm::mat4& MVP);
+    void renderEdges(const glm::mat4& MVP);
+    void renderPath(const glm::mat4& MVP);
 
 private:
     GLuint createShader(const std::string& vertexCode, const std::string& fragmentCode);
+    void patchBuffer(GLenum target, size_t& capacity, const void* data, size_t elementSize,
+        size_t count, size_t begin, size_t end);
+    void setPositionFormat(bool quantized);
+    void setPositionUniforms(GLuint program);
+
+    size_t positionCapacity = 0;
+    size_t colorCapacity = 0;
+    size_t radiusCapacity = 0;
+    size_t flagCapacity = 0;
+    size_t indexCapacity = 0;
+    size_t nodeCount = 0;
+    size_t colorCount = 0;
+    size_t radiusCount = 0;
+    size_t flagCount = 0;
+    size_t edgeIndexCount = 0;
+    size_t pathCapacity = 0;
+    size_t pathCount = 0;
+
+    bool quantizedPositions = false;
+    glm::vec3 positionOrigin = glm::vec3(0.0f);
+    glm::vec3 positionExtent = glm::vec3(1.0f);
+
     const char* vertexShaderSource = R"(
         #version 330 core
         layout (location = 0) in vec3 aPos;
+        layout (location = 1) in vec3 aColor;
         uniform mat4 MVP;
+        uniform vec3 positionOrigin;
+        uniform vec3 positionExtent;
+        out vec3 vColor;
         void main() {
-            gl_Position = MVP * vec4(aPos, 1.0);
+            gl_Position = MVP * vec4(positionOrigin + aPos * positionExtent, 1.0);
+            vColor = aColor;
         }
     )";
 
     const char* fragmentShaderSource = R"(
         #version 330 core
+        in vec3 vColor;
         out vec4 FragColor;
         uniform vec3 color;
+        uniform bool useVertexColor;
+        void main() {
+            FragColor = vec4(useVertexColor ? vColor : color, 1.0);
+        }
+    )";
+
+    // Nodes: one instance per node, a screen-aligned quad expanded from
+    // gl_VertexID around the projected centre and shaded as a sphere.
+    const char* nodeVertexShaderSource = R"(
+        #version 330 core
+        layout (location = 0) in vec3 aPos;
+        layout (location = 1) in vec3 aColor;
+        layout (location = 2) in float aRadius;
+        layout (location = 3) in uint aFlags;
+        uniform mat4 MVP;
+        uniform vec3 positionOrigin;
+        uniform vec3 positionExtent;
+        uniform vec2 viewport;
+        out vec3 vColor;
+        out vec2 vCorner;
+        flat out uint vFlags;
+        void main() {
+            vec2 corner = vec2((gl_VertexID & 1) == 0 ? -1.0 : 1.0, (gl_VertexID & 2) == 0 ? -1.0 : 1.0);
+            float radius = (aFlags & 1u) != 0u ? aRadius * 1.5 : aRadius;
+            vec4 center = MVP * vec4(positionOrigin + aPos * positionExtent, 1.0);
+            gl_Position = center + vec4(corner * radius * 2.0 / viewport * center.w, 0.0, 0.0);
+            vColor = aColor;
+            vCorner = corner;
+            vFlags = aFlags;
+        }
+    )";
+
+    const char* nodeFragmentShaderSource = R"(
+        #version 330 core
+        in vec3 vColor;
+        in vec2 vCorner;
+        flat in uint vFlags;
+        out vec4 FragColor;
         void main() {
-            FragColor = vec4(color, 1.0);
+            float r2 = dot(vCorner, vCorner);
+            if (r2 > 1.0) discard;
+            if ((vFlags & 1u) != 0u && r2 > 0.6) {
+                FragColor = vec4(1.0);
+                return;
+            }
+            vec3 normal = vec3(vCorner, sqrt(1.0 - r2));
+            vec3 light = normalize(vec3(-0.4, 0.5, 0.8));
+            float diffuse = max(dot(normal, light), 0.0);
+            float specular = pow(max(dot(reflect(-light, normal), vec3(0.0, 0.0, 1.0)), 0.0), 24.0);
+            FragColor = vec4(vColor * (0.35 + 0.65 * diffuse) + vec3(0.3 * specular), 1.0);
         }
     )";
-    std::vector<glm::vec3> edgeVerticesCache;
 };
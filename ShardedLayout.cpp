@@ -0,0 +1,802 @@
+#include "ShardedLayout.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <thread>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    const uint32_t sharedMagic = 0x53484C59;  // "SHLY"
+    const float maxRepulsionDistance = 15.0f;
+    // As in CompactGraph: where nodes are denser than the 15-unit cut-off
+    // assumes, repulsion ends after this many mean node spacings, and no
+    // node moves more than maxStepSpacings spacings per step.
+    const float repulsionSpacings = 2.5f;
+    const float maxStepSpacings = 1.0f;
+    const int cellBias = 1 << 20;
+
+    // A shard's box and node count: enough to tell that a shard is farther
+    // away than the cut-off and needs no halo.
+    struct ShardBounds {
+        glm::vec3 lo;
+        glm::vec3 hi;
+        uint32_t count;
+    };
+
+    struct SharedShardStats {
+        std::atomic<int> nodes;
+        std::atomic<int> boundaryNodes;
+        std::atomic<int> ghostNodes;
+        std::atomic<int> haloNodes;
+        std::atomic<int> farShards;
+        std::atomic<float> stepMs;
+        std::atomic<float> maxStep;
+    };
+
+    size_t alignUp(size_t value) {
+        return (value + 63) & ~(size_t)63;
+    }
+
+    uint64_t packCell(int x, int y, int z) {
+        return ((uint64_t)(x + cellBias) << 42) | ((uint64_t)(y + cellBias) << 21) | (uint64_t)(z + cellBias);
+    }
+
+    // Clamped so that far-away (or non-finite) coordinates still map into
+    // the 21 bits per axis of packCell.
+    int cellCoord(float value, float cellSize) {
+        float cell = std::floor(value / cellSize);
+        if (!(cell > -(float)(cellBias - 2))) return -(cellBias - 2);
+        if (cell > (float)(cellBias - 2)) return cellBias - 2;
+        return (int)cell;
+    }
+
+    ShardBounds boundsOf(const glm::vec3* positions, size_t count) {
+        ShardBounds bounds = { glm::vec3(0.0f), glm::vec3(0.0f), (uint32_t)count };
+        if (count == 0) return bounds;
+        bounds.lo = bounds.hi = positions[0];
+        for (size_t i = 1; i < count; ++i) {
+            bounds.lo = glm::min(bounds.lo, positions[i]);
+            bounds.hi = glm::max(bounds.hi, positions[i]);
+        }
+        return bounds;
+    }
+
+    // Mean node spacing of the whole layout, estimated from the union of the
+    // shard boxes.
+    float meanSpacing(const ShardBounds* bounds, int shards, size_t n) {
+        glm::vec3 lo(0.0f), hi(0.0f);
+        bool any = false;
+        for (int s = 0; s < shards; ++s) {
+            if (bounds[s].count == 0) continue;
+            lo = any ? glm::min(lo, bounds[s].lo) : bounds[s].lo;
+            hi = any ? glm::max(hi, bounds[s].hi) : bounds[s].hi;
+            any = true;
+        }
+        glm::vec3 extent = hi - lo;
+        float largest = std::max(extent.x, std::max(extent.y, extent.z));
+        float spacing = extent.z > 0.0f
+            ? std::cbrt((double)extent.x * extent.y * extent.z / n)
+            : std::sqrt((double)extent.x * extent.y / n);
+        spacing = std::max(spacing, largest / n);
+        return std::isfinite(spacing) && spacing > 0.0f ? spacing : maxRepulsionDistance;
+    }
+}
+
+#ifndef _WIN32
+
+// Layout of the shared memory block: this header, then the arrays at the
+// recorded offsets. Positions exist twice per buffer: in global node order
+// (read by the GUI and for ghost nodes) and grouped by shard (scanned for
+// halo nodes).
+struct ShardedLayout::Shared {
+    uint32_t magic;
+    uint32_t shardCount;
+    uint32_t nodeCount;
+    uint64_t edgeCount;
+    uint64_t positionsOffset[2];
+    uint64_t blocksOffset[2];
+    uint64_t boundsOffset[2];
+    uint64_t shardBeginOffset;
+    uint64_t membersOffset;
+    uint64_t edgesOffset;
+    uint64_t ownerOffset;
+    uint64_t statsOffset;
+
+    pthread_barrier_t barrier;   // workers only
+    std::atomic<uint32_t> attached;
+    std::atomic<uint64_t> completedStep;
+
+    // Written by the GUI at any time.
+    std::atomic<float> repulsion;
+    std::atomic<float> attraction;
+    std::atomic<float> deltaTime;
+    std::atomic<uint32_t> paused;
+    std::atomic<uint32_t> stopRequested;
+
+    // Copied from the fields above by shard 0 between the two barriers of a
+    // step, so that every worker acts on the same values.
+    float latchedRepulsion;
+    float latchedAttraction;
+    float latchedDeltaTime;
+    uint32_t latchedPaused;
+    uint32_t latchedStop;
+    float latchedCutoff;         // repulsion cut-off and halo width
+    float latchedMaxStep;
+
+    // Derives the cut-off and step cap from the boxes the next step reads.
+    void latchSpacing(int buffer) {
+        float spacing = meanSpacing(bounds(buffer), (int)shardCount, nodeCount);
+        latchedCutoff = std::min(maxRepulsionDistance, repulsionSpacings * spacing);
+        latchedMaxStep = maxStepSpacings * spacing;
+    }
+
+    char* base() { return reinterpret_cast<char*>(this); }
+    glm::vec3* positions(int buffer) { return reinterpret_cast<glm::vec3*>(base() + positionsOffset[buffer]); }
+    glm::vec3* blocks(int buffer) { return reinterpret_cast<glm::vec3*>(base() + blocksOffset[buffer]); }
+    ShardBounds* bounds(int buffer) { return reinterpret_cast<ShardBounds*>(base() + boundsOffset[buffer]); }
+    uint32_t* shardBegin() { return reinterpret_cast<uint32_t*>(base() + shardBeginOffset); }
+    uint32_t* members() { return reinterpret_cast<uint32_t*>(base() + membersOffset); }
+    uint32_t* edges() { return reinterpret_cast<uint32_t*>(base() + edgesOffset); }
+    uint32_t* owner() { return reinterpret_cast<uint32_t*>(base() + ownerOffset); }
+    SharedShardStats* stats() { return reinterpret_cast<SharedShardStats*>(base() + statsOffset); }
+};
+
+#else
+
+struct ShardedLayout::Shared {
+};
+
+#endif
+
+ShardedLayout::ShardedLayout() {
+}
+
+ShardedLayout::~ShardedLayout() {
+    stop();
+}
+
+bool ShardedLayout::isWorkerInvocation(int argc, char** argv) {
+    return argc >= 4 && std::strcmp(argv[1], "--layout-worker") == 0;
+}
+
+void ShardedLayout::partition(const std::vector<glm::vec3>& positions, int shards, std::vector<unsigned int>& owner) const {
+    std::vector<uint32_t> order(positions.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = (uint32_t)i;
+    owner.assign(positions.size(), 0);
+
+    // Recursive coordinate bisection: split the longest axis of each range so
+    // that the node counts stay proportional to the shard counts.
+    struct Range { size_t begin, end; int firstShard, shards; };
+    std::vector<Range> stack;
+    stack.push_back({ 0, order.size(), 0, shards });
+    while (!stack.empty()) {
+        Range range = stack.back();
+        stack.pop_back();
+
+        if (range.shards == 1) {
+            for (size_t i = range.begin; i < range.end; ++i) owner[order[i]] = (unsigned int)range.firstShard;
+            continue;
+        }
+
+        glm::vec3 lo(1e30f), hi(-1e30f);
+        for (size_t i = range.begin; i < range.end; ++i) {
+            lo = glm::min(lo, positions[order[i]]);
+            hi = glm::max(hi, positions[order[i]]);
+        }
+        glm::vec3 size = hi - lo;
+        int axis = size.x >= size.y && size.x >= size.z ? 0 : (size.y >= size.z ? 1 : 2);
+
+        int leftShards = range.shards / 2;
+        size_t split = range.begin + (range.end - range.begin) * leftShards / range.shards;
+        std::nth_element(order.begin() + range.begin, order.begin() + split, order.begin() + range.end,
+            [&](uint32_t a, uint32_t b) { return positions[a][axis] < positions[b][axis]; });
+
+        stack.push_back({ range.begin, split, range.firstShard, leftShards });
+        stack.push_back({ split, range.end, range.firstShard + leftShards, range.shards - leftShards });
+    }
+}
+
+#ifndef _WIN32
+
+bool ShardedLayout::start(const std::vector<glm::vec3>& positions, const std::vector<unsigned int>& edgeIndices) {
+    stop();
+    error.clear();
+
+    const size_t n = positions.size();
+    const size_t m = edgeIndices.size() / 2;
+    if (n == 0) {
+        error = "empty graph";
+        return false;
+    }
+    int shards = std::max(1, std::min(shardCount, (int)std::min<size_t>(n, 256)));
+
+    std::vector<unsigned int> owner;
+    partition(positions, shards, owner);
+
+    cutEdges = 0;
+    for (size_t e = 0; e < m; ++e) {
+        if (owner[edgeIndices[2 * e]] != owner[edgeIndices[2 * e + 1]]) ++cutEdges;
+    }
+
+    std::vector<uint32_t> shardBegin(shards + 1, 0);
+    for (size_t i = 0; i < n; ++i) shardBegin[owner[i] + 1]++;
+    for (int s = 0; s < shards; ++s) shardBegin[s + 1] += shardBegin[s];
+    std::vector<uint32_t> members(n);
+    std::vector<uint32_t> fill(shardBegin.begin(), shardBegin.end() - 1);
+    for (size_t i = 0; i < n; ++i) members[fill[owner[i]]++] = (uint32_t)i;
+
+    size_t offset = alignUp(sizeof(Shared));
+    size_t positionsOffset[2], blocksOffset[2], boundsOffset[2];
+    for (int b = 0; b < 2; ++b) {
+        positionsOffset[b] = offset;
+        offset = alignUp(offset + n * sizeof(glm::vec3));
+        blocksOffset[b] = offset;
+        offset = alignUp(offset + n * sizeof(glm::vec3));
+        boundsOffset[b] = offset;
+        offset = alignUp(offset + (size_t)shards * sizeof(ShardBounds));
+    }
+    size_t shardBeginOffset = offset;
+    offset = alignUp(offset + (size_t)(shards + 1) * sizeof(uint32_t));
+    size_t membersOffset = offset;
+    offset = alignUp(offset + n * sizeof(uint32_t));
+    size_t edgesOffset = offset;
+    offset = alignUp(offset + m * 2 * sizeof(uint32_t));
+    size_t ownerOffset = offset;
+    offset = alignUp(offset + n * sizeof(uint32_t));
+    size_t statsOffset = offset;
+    offset = alignUp(offset + (size_t)shards * sizeof(SharedShardStats));
+
+    static int instanceCounter = 0;
+    sharedName = "/topology-layout-" + std::to_string((long)getpid()) + "-" + std::to_string(instanceCounter++);
+    int fd = shm_open(sharedName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+        error = "shm_open failed: " + std::string(std::strerror(errno));
+        return false;
+    }
+    sharedLinked = true;
+    if (ftruncate(fd, (off_t)offset) != 0) {
+        error = "ftruncate failed: " + std::string(std::strerror(errno));
+        close(fd);
+        release();
+        return false;
+    }
+    void* memory = mmap(NULL, offset, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) {
+        error = "mmap failed: " + std::string(std::strerror(errno));
+        release();
+        return false;
+    }
+    sharedBytes = offset;
+    shared = new (memory) Shared();
+
+    shared->magic = sharedMagic;
+    shared->shardCount = (uint32_t)shards;
+    shared->nodeCount = (uint32_t)n;
+    shared->edgeCount = m;
+    for (int b = 0; b < 2; ++b) {
+        shared->positionsOffset[b] = positionsOffset[b];
+        shared->blocksOffset[b] = blocksOffset[b];
+        shared->boundsOffset[b] = boundsOffset[b];
+    }
+    shared->shardBeginOffset = shardBeginOffset;
+    shared->membersOffset = membersOffset;
+    shared->edgesOffset = edgesOffset;
+    shared->ownerOffset = ownerOffset;
+    shared->statsOffset = statsOffset;
+
+    pthread_barrierattr_t attr;
+    pthread_barrierattr_init(&attr);
+    pthread_barrierattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    pthread_barrier_init(&shared->barrier, &attr, (unsigned)shards);
+    pthread_barrierattr_destroy(&attr);
+
+    shared->attached.store(0);
+    shared->completedStep.store(0);
+    shared->repulsion.store(100.0f);
+    shared->attraction.store(0.1f);
+    shared->deltaTime.store(0.16f);
+    shared->paused.store(0);
+    shared->stopRequested.store(0);
+    shared->latchedRepulsion = 100.0f;
+    shared->latchedAttraction = 0.1f;
+    shared->latchedDeltaTime = 0.16f;
+    shared->latchedPaused = 0;
+    shared->latchedStop = 0;
+
+    // Step 0 reads buffer 0; buffer 1 gets a copy too so that a snapshot
+    // taken before the first step completes is still the input layout.
+    for (int b = 0; b < 2; ++b) {
+        std::copy(positions.begin(), positions.end(), shared->positions(b));
+        glm::vec3* blocks = shared->blocks(b);
+        for (size_t k = 0; k < n; ++k) blocks[k] = positions[members[k]];
+        for (int s = 0; s < shards; ++s) {
+            shared->bounds(b)[s] = boundsOf(blocks + shardBegin[s], shardBegin[s + 1] - shardBegin[s]);
+        }
+    }
+    std::copy(shardBegin.begin(), shardBegin.end(), shared->shardBegin());
+    std::copy(members.begin(), members.end(), shared->members());
+    std::copy(edgeIndices.begin(), edgeIndices.begin() + m * 2, shared->edges());
+    std::copy(owner.begin(), owner.end(), shared->owner());
+    shared->latchSpacing(0);
+    SharedShardStats* sharedStats = shared->stats();
+    for (int s = 0; s < shards; ++s) {
+        new (&sharedStats[s]) SharedShardStats();
+        sharedStats[s].nodes.store(0);
+        sharedStats[s].boundaryNodes.store(0);
+        sharedStats[s].ghostNodes.store(0);
+        sharedStats[s].haloNodes.store(0);
+        sharedStats[s].farShards.store(0);
+        sharedStats[s].stepMs.store(0.0f);
+        sharedStats[s].maxStep.store(0.0f);
+    }
+
+    // Everything the children need is prepared before fork; between fork
+    // and exec only async-signal-safe calls are allowed.
+    std::vector<std::string> shardArgs;
+    for (int s = 0; s < shards; ++s) shardArgs.push_back(std::to_string(s));
+    long cpuCount = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpuCount < 1) cpuCount = 1;
+    pid_t parent = getpid();
+
+    for (int s = 0; s < shards; ++s) {
+        pid_t pid = fork();
+        if (pid < 0) {
+            error = "fork failed: " + std::string(std::strerror(errno));
+            stop();
+            return false;
+        }
+        if (pid == 0) {
+            prctl(PR_SET_PDEATHSIG, SIGTERM);
+            if (getppid() != parent) _exit(1);
+            if (pinWorkers) {
+                cpu_set_t set;
+                CPU_ZERO(&set);
+                long first = s * cpuCount / shards;
+                long last = std::max(first + 1, (long)(s + 1) * cpuCount / shards);
+                for (long c = first; c < last; ++c) CPU_SET((int)(c % cpuCount), &set);
+                sched_setaffinity(0, sizeof(set), &set);
+            }
+            const char* args[] = { workerExecutable.c_str(), "--layout-worker", sharedName.c_str(), shardArgs[s].c_str(), NULL };
+            execv(workerExecutable.c_str(), const_cast<char* const*>(args));
+            _exit(127);
+        }
+        workerPids.push_back((int)pid);
+    }
+
+    // Once every worker has mapped the block its name is no longer needed.
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (shared->attached.load() < (uint32_t)shards) {
+        if (!workersAlive() || std::chrono::steady_clock::now() > deadline) {
+            if (error.empty()) error = "layout workers failed to start";
+            stop();
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    shm_unlink(sharedName.c_str());
+    sharedLinked = false;
+
+    stats.assign(shards, ShardStats());
+    step = 0;
+    fetchedStep = 0;
+    return true;
+}
+
+void ShardedLayout::stop() {
+    if (!workerPids.empty() && shared) {
+        shared->stopRequested.store(1);
+
+        std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+        while (!workerPids.empty() && std::chrono::steady_clock::now() < deadline) {
+            workersAlive();
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    }
+    // Stragglers are stuck at a barrier whose peer died; nothing to save.
+    for (int pid : workerPids) {
+        kill(pid, SIGKILL);
+        waitpid(pid, NULL, 0);
+    }
+    workerPids.clear();
+    release();
+}
+
+void ShardedLayout::release() {
+    if (shared) {
+        // No pthread_barrier_destroy: glibc waits in it for threads still
+        // inside the barrier, which after a killed worker never leave.
+        munmap(shared, sharedBytes);
+        shared = nullptr;
+        sharedBytes = 0;
+    }
+    if (sharedLinked) {
+        shm_unlink(sharedName.c_str());
+        sharedLinked = false;
+    }
+}
+
+bool ShardedLayout::workersAlive() {
+    bool alive = true;
+    for (size_t i = 0; i < workerPids.size();) {
+        int status = 0;
+        if (waitpid(workerPids[i], &status, WNOHANG) == workerPids[i]) {
+            if (!(WIFEXITED(status) && WEXITSTATUS(status) == 0) && error.empty()) {
+                error = "a layout worker died";
+            }
+            workerPids.erase(workerPids.begin() + i);
+            alive = false;
+        }
+        else {
+            ++i;
+        }
+    }
+    return alive;
+}
+
+void ShardedLayout::setParameters(float repulsionStrength, float attractionStrength, float deltaTime) {
+    if (!shared) return;
+    shared->repulsion.store(repulsionStrength);
+    shared->attraction.store(attractionStrength);
+    shared->deltaTime.store(deltaTime);
+}
+
+void ShardedLayout::setPaused(bool paused) {
+    if (!shared) return;
+    shared->paused.store(paused ? 1 : 0);
+}
+
+bool ShardedLayout::fetchPositions(std::vector<glm::vec3>& positions) {
+    if (!shared) return false;
+    if (!workersAlive()) {
+        stop();
+        return false;
+    }
+
+    SharedShardStats* sharedStats = shared->stats();
+    for (size_t s = 0; s < stats.size(); ++s) {
+        stats[s].nodes = sharedStats[s].nodes.load();
+        stats[s].boundaryNodes = sharedStats[s].boundaryNodes.load();
+        stats[s].ghostNodes = sharedStats[s].ghostNodes.load();
+        stats[s].haloNodes = sharedStats[s].haloNodes.load();
+        stats[s].farShards = sharedStats[s].farShards.load();
+        stats[s].stepMs = sharedStats[s].stepMs.load();
+        stats[s].maxStep = sharedStats[s].maxStep.load();
+    }
+
+    uint64_t completed = shared->completedStep.load(std::memory_order_acquire);
+    if (completed == fetchedStep) return false;
+
+    // Step c + 1 starts overwriting buffer c & 1 only after publishing
+    // completedStep = c + 1, so an unchanged counter means a clean copy.
+    // Workers that keep outrunning the copy leave it for the next frame.
+    positions.resize(shared->nodeCount);
+    for (int attempt = 0; attempt < 4; ++attempt) {
+        const glm::vec3* source = shared->positions((int)(completed & 1));
+        std::copy(source, source + shared->nodeCount, positions.begin());
+        uint64_t after = shared->completedStep.load(std::memory_order_acquire);
+        if (after == completed) {
+            fetchedStep = completed;
+            step = completed;
+            return true;
+        }
+        completed = after;
+    }
+    return false;
+}
+
+namespace {
+    bool overlaps(const ShardBounds& a, const ShardBounds& b, float margin) {
+        return a.lo.x - margin <= b.hi.x && b.lo.x <= a.hi.x + margin &&
+            a.lo.y - margin <= b.hi.y && b.lo.y <= a.hi.y + margin &&
+            a.lo.z - margin <= b.hi.z && b.lo.z <= a.hi.z + margin;
+    }
+
+    bool inside(const glm::vec3& p, const ShardBounds& bounds, float margin) {
+        return p.x >= bounds.lo.x - margin && p.x <= bounds.hi.x + margin &&
+            p.y >= bounds.lo.y - margin && p.y <= bounds.hi.y + margin &&
+            p.z >= bounds.lo.z - margin && p.z <= bounds.hi.z + margin;
+    }
+
+    // True if any of the 27 cells around p is in the sorted `cells`.
+    bool nearCells(const std::vector<uint64_t>& cells, const glm::vec3& p, float cellSize) {
+        int cx = cellCoord(p.x, cellSize), cy = cellCoord(p.y, cellSize), cz = cellCoord(p.z, cellSize);
+        for (int dx = -1; dx <= 1; ++dx) {
+            for (int dy = -1; dy <= 1; ++dy) {
+                for (int dz = -1; dz <= 1; ++dz) {
+                    if (std::binary_search(cells.begin(), cells.end(), packCell(cx + dx, cy + dy, cz + dz))) return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    // Cut-off repulsion on the first targetCount sources from all sources,
+    // through a uniform grid with the cut-off as cell size.
+    void repulsion(const std::vector<glm::vec3>& sources, size_t targetCount, float strength, float cutoff,
+        std::vector<uint64_t>& keys, std::vector<uint32_t>& order, std::vector<uint64_t>& sortedKeys, std::vector<glm::vec3>& force) {
+        const float cellSize = cutoff;
+        const size_t count = sources.size();
+        keys.resize(count);
+        order.resize(count);
+        for (size_t i = 0; i < count; ++i) {
+            order[i] = (uint32_t)i;
+            keys[i] = packCell(cellCoord(sources[i].x, cellSize), cellCoord(sources[i].y, cellSize), cellCoord(sources[i].z, cellSize));
+        }
+        std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return keys[a] < keys[b] || (keys[a] == keys[b] && a < b); });
+        sortedKeys.resize(count);
+        for (size_t i = 0; i < count; ++i) sortedKeys[i] = keys[order[i]];
+
+        for (size_t i = 0; i < targetCount; ++i) {
+            const glm::vec3 p = sources[i];
+            int cx = cellCoord(p.x, cellSize), cy = cellCoord(p.y, cellSize), cz = cellCoord(p.z, cellSize);
+            glm::vec3 sum(0.0f);
+            for (int dx = -1; dx <= 1; ++dx) {
+                for (int dy = -1; dy <= 1; ++dy) {
+                    for (int dz = -1; dz <= 1; ++dz) {
+                        uint64_t key = packCell(cx + dx, cy + dy, cz + dz);
+                        size_t k = std::lower_bound(sortedKeys.begin(), sortedKeys.end(), key) - sortedKeys.begin();
+                        for (; k < count && sortedKeys[k] == key; ++k) {
+                            uint32_t j = order[k];
+                            if (j == i) continue;
+                            glm::vec3 diff = p - sources[j];
+                            float distance = glm::length(diff);
+                            if (distance > 0.001f && distance < cutoff) {
+                                sum += diff / distance * (strength / (distance * distance));
+                            }
+                        }
+                    }
+                }
+            }
+            force[i] = sum;
+        }
+    }
+}
+
+int ShardedLayout::runWorker(int argc, char** argv) {
+    if (!isWorkerInvocation(argc, argv)) return 2;
+    const int shard = std::atoi(argv[3]);
+
+    int fd = shm_open(argv[2], O_RDWR, 0);
+    if (fd < 0) {
+        std::cerr << "layout worker: shm_open failed: " << std::strerror(errno) << std::endl;
+        return 1;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        return 1;
+    }
+    void* memory = mmap(NULL, (size_t)info.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) return 1;
+
+    Shared* shared = static_cast<Shared*>(memory);
+    if (shared->magic != sharedMagic || shard < 0 || shard >= (int)shared->shardCount) return 1;
+
+    const int shards = (int)shared->shardCount;
+    const uint32_t n = shared->nodeCount;
+    const uint64_t m = shared->edgeCount;
+    const uint32_t* owner = shared->owner();
+    const uint32_t* edges = shared->edges();
+    const uint32_t* shardBegin = shared->shardBegin();
+    const uint32_t myBegin = shardBegin[shard];
+    const size_t ownCount = shardBegin[shard + 1] - myBegin;
+
+    // Local numbering: owned nodes first (in block order), then ghosts.
+    // Everything below is allocated and first touched by this process, so
+    // with pinned workers it lands on the worker's NUMA node.
+    std::vector<int32_t> localIndex(n, -1);
+    std::vector<uint32_t> globalIds(shared->members() + myBegin, shared->members() + myBegin + ownCount);
+    for (size_t i = 0; i < ownCount; ++i) localIndex[globalIds[i]] = (int32_t)i;
+
+    std::vector<int> offsets(ownCount + 1, 0);
+    for (uint64_t e = 0; e < m; ++e) {
+        uint32_t a = edges[2 * e], b = edges[2 * e + 1];
+        bool ownA = owner[a] == (uint32_t)shard, ownB = owner[b] == (uint32_t)shard;
+        if (ownA) {
+            offsets[localIndex[a] + 1]++;
+            if (!ownB && localIndex[b] < 0) {
+                localIndex[b] = (int32_t)globalIds.size();
+                globalIds.push_back(b);
+            }
+        }
+        if (ownB) {
+            offsets[localIndex[b] + 1]++;
+            if (!ownA && localIndex[a] < 0) {
+                localIndex[a] = (int32_t)globalIds.size();
+                globalIds.push_back(a);
+            }
+        }
+    }
+    for (size_t i = 0; i < ownCount; ++i) offsets[i + 1] += offsets[i];
+    std::vector<int> neighbors(offsets[ownCount]);
+    std::vector<int> fill(offsets.begin(), offsets.end() - 1);
+    for (uint64_t e = 0; e < m; ++e) {
+        uint32_t a = edges[2 * e], b = edges[2 * e + 1];
+        if (owner[a] == (uint32_t)shard) neighbors[fill[localIndex[a]]++] = localIndex[b];
+        if (owner[b] == (uint32_t)shard) neighbors[fill[localIndex[b]]++] = localIndex[a];
+    }
+    std::vector<int32_t>().swap(localIndex);
+
+    int boundary = 0;
+    for (size_t i = 0; i < ownCount; ++i) {
+        for (int k = offsets[i]; k < offsets[i + 1]; ++k) {
+            if (neighbors[k] >= (int)ownCount) {
+                ++boundary;
+                break;
+            }
+        }
+    }
+
+    std::vector<glm::vec3> pos(globalIds.size());
+    for (size_t i = 0; i < ownCount; ++i) pos[i] = shared->blocks(0)[myBegin + i];
+    std::vector<glm::vec3> velocity(ownCount, glm::vec3(0.0f));
+    std::vector<glm::vec3> force(ownCount);
+    std::vector<glm::vec3> sources;
+    std::vector<uint64_t> keys, sortedKeys;
+    std::vector<uint32_t> order;
+    std::vector<uint64_t> ownCells;
+
+    SharedShardStats& myStats = shared->stats()[shard];
+    myStats.nodes.store((int)ownCount);
+    myStats.boundaryNodes.store(boundary);
+    myStats.ghostNodes.store((int)(globalIds.size() - ownCount));
+    shared->attached.fetch_add(1);
+
+    uint64_t stepIndex = 0;
+    bool paused = false;
+    while (true) {
+        if (!paused) {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            const int cur = (int)(stepIndex & 1);
+            const int next = cur ^ 1;
+            const float repulsionStrength = shared->latchedRepulsion;
+            const float attractionStrength = shared->latchedAttraction;
+            const float dt = shared->latchedDeltaTime;
+            const float cutoff = shared->latchedCutoff;
+            const float maxStepLength = shared->latchedMaxStep;
+
+            // Ghosts: the foreign endpoints of cut edges.
+            const glm::vec3* current = shared->positions(cur);
+            for (size_t g = ownCount; g < globalIds.size(); ++g) pos[g] = current[globalIds[g]];
+
+            // Halo: foreign nodes in a cut-off sized cell next to one that
+            // holds an own node; they repel the own nodes exactly. Shards
+            // whose box is farther away than the cut-off exert no force and
+            // are not scanned at all.
+            const ShardBounds* bounds = shared->bounds(cur);
+            const ShardBounds& mine = bounds[shard];
+            const glm::vec3* blocks = shared->blocks(cur);
+            ownCells.resize(ownCount);
+            for (size_t i = 0; i < ownCount; ++i) {
+                ownCells[i] = packCell(cellCoord(pos[i].x, cutoff), cellCoord(pos[i].y, cutoff), cellCoord(pos[i].z, cutoff));
+            }
+            std::sort(ownCells.begin(), ownCells.end());
+            ownCells.erase(std::unique(ownCells.begin(), ownCells.end()), ownCells.end());
+
+            sources.assign(pos.begin(), pos.begin() + ownCount);
+            int farShards = 0;
+            for (int other = 0; other < shards; ++other) {
+                if (other == shard || bounds[other].count == 0) continue;
+                if (!overlaps(mine, bounds[other], cutoff)) {
+                    ++farShards;
+                    continue;
+                }
+                for (uint32_t k = shardBegin[other]; k < shardBegin[other + 1]; ++k) {
+                    const glm::vec3 p = blocks[k];
+                    if (inside(p, mine, cutoff) && nearCells(ownCells, p, cutoff)) sources.push_back(p);
+                }
+            }
+
+            repulsion(sources, ownCount, repulsionStrength, cutoff, keys, order, sortedKeys, force);
+
+            for (size_t i = 0; i < ownCount; ++i) {
+                for (int k = offsets[i]; k < offsets[i + 1]; ++k) {
+                    glm::vec3 diff = pos[neighbors[k]] - pos[i];
+                    float distance = glm::length(diff);
+                    if (distance > 0.001f) {
+                        force[i] += diff / distance * (attractionStrength * distance * distance);
+                    }
+                }
+            }
+
+            float maxStep = 0.0f;
+            glm::vec3* out = shared->positions(next);
+            glm::vec3* outBlock = shared->blocks(next) + myBegin;
+            for (size_t i = 0; i < ownCount; ++i) {
+                velocity[i] += force[i] * dt;
+                velocity[i] *= 0.9f;
+                glm::vec3 stepVector = velocity[i] * dt;
+                float stepLength = glm::length(stepVector);
+                if (stepLength > maxStepLength) {
+                    stepVector *= maxStepLength / stepLength;
+                    velocity[i] = stepVector / dt;
+                    stepLength = maxStepLength;
+                }
+                pos[i] += stepVector;
+                maxStep = std::max(maxStep, stepLength);
+                out[globalIds[i]] = pos[i];
+                outBlock[i] = pos[i];
+            }
+            shared->bounds(next)[shard] = boundsOf(outBlock, ownCount);
+
+            myStats.haloNodes.store((int)(sources.size() - ownCount));
+            myStats.farShards.store(farShards);
+            myStats.maxStep.store(maxStep);
+            myStats.stepMs.store((float)std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        }
+        else {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+
+        pthread_barrier_wait(&shared->barrier);
+        if (shard == 0) {
+            if (!paused) shared->completedStep.store(stepIndex + 1, std::memory_order_release);
+            shared->latchedRepulsion = shared->repulsion.load();
+            shared->latchedAttraction = shared->attraction.load();
+            shared->latchedDeltaTime = shared->deltaTime.load();
+            shared->latchedPaused = shared->paused.load();
+            shared->latchedStop = shared->stopRequested.load();
+            shared->latchSpacing((int)((paused ? stepIndex : stepIndex + 1) & 1));
+        }
+        pthread_barrier_wait(&shared->barrier);
+
+        if (!paused) ++stepIndex;
+        paused = shared->latchedPaused != 0;
+        if (shared->latchedStop) break;
+    }
+
+    munmap(memory, (size_t)info.st_size);
+    return 0;
+}
+
+#else
+
+bool ShardedLayout::start(const std::vector<glm::vec3>&, const std::vector<unsigned int>&) {
+    error = "sharded layout needs POSIX shared memory (Linux)";
+    return false;
+}
+
+void ShardedLayout::stop() {
+}
+
+void ShardedLayout::release() {
+}
+
+bool ShardedLayout::workersAlive() {
+    return false;
+}
+
+void ShardedLayout::setParameters(float, float, float) {
+}
+
+void ShardedLayout::setPaused(bool) {
+}
+
+bool ShardedLayout::fetchPositions(std::vector<glm::vec3>&) {
+    return false;
+}
+
+int ShardedLayout::runWorker(int, char**) {
+    return 1;
+}
+
+#endif
@@ -0,0 +1,79 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+
+// Force-directed layout split across K local worker processes (Linux).
+//
+// The nodes are partitioned spatially (recursive coordinate bisection) into
+// K shards. Every worker owns one shard and keeps its nodes, velocities and
+// adjacency in its own memory; the shards meet in a POSIX shared memory
+// block that holds double-buffered positions and per-shard summaries (box
+// and node count) plus the edge list. Each step a worker
+//   - reads its ghost nodes (foreign endpoints of cut edges) for attraction,
+//   - reads its halo (foreign nodes within the repulsion cut-off of its own
+//     nodes) for repulsion, skipping shards whose box is beyond the cut-off,
+//   - publishes its positions and summary, then meets the others at a
+//     process-shared barrier.
+// The force model is CompactGraph's: the cut-off and the largest step per
+// node shrink with the mean node spacing, so dense layouts keep small halos,
+// and nothing beyond the cut-off repels. The workers run at their own pace
+// with the time step given to setParameters, so the result is a layout of
+// the same model, not a replay of the GUI's steps.
+// The GUI process only copies finished snapshots out for rendering.
+class ShardedLayout {
+public:
+    struct ShardStats {
+        int nodes = 0;
+        int boundaryNodes = 0;   // owned nodes with a neighbour in another shard
+        int ghostNodes = 0;      // foreign endpoints of cut edges
+        int haloNodes = 0;       // foreign nodes within the repulsion cut-off
+        int farShards = 0;       // shards beyond the cut-off, not scanned
+        float stepMs = 0.0f;
+        float maxStep = 0.0f;
+    };
+
+    int shardCount = 4;
+    bool pinWorkers = false;     // bind worker i to the i-th block of CPUs
+    std::string workerExecutable = "/proc/self/exe";
+
+    std::vector<ShardStats> stats;
+    size_t cutEdges = 0;
+    unsigned long long step = 0;
+    std::string error;
+
+    ShardedLayout();
+    ~ShardedLayout();
+
+    bool start(const std::vector<glm::vec3>& positions, const std::vector<unsigned int>& edgeIndices);
+    void stop();
+    bool isRunning() const { return shared != nullptr; }
+
+    void setParameters(float repulsionStrength, float attractionStrength, float deltaTime);
+    void setPaused(bool paused);
+
+    // Copies the newest finished step into `positions`; false if there is
+    // nothing new, the workers overwrote it during every copy attempt, or the
+    // workers died (see `error`).
+    bool fetchPositions(std::vector<glm::vec3>& positions);
+
+    // Worker processes are this executable started as
+    //   <exe> --layout-worker <shared memory name> <shard>
+    // main() must hand such invocations to runWorker before anything else.
+    static bool isWorkerInvocation(int argc, char** argv);
+    static int runWorker(int argc, char** argv);
+
+private:
+    struct Shared;
+
+    Shared* shared = nullptr;
+    size_t sharedBytes = 0;
+    std::string sharedName;
+    bool sharedLinked = false;
+    std::vector<int> workerPids;
+    unsigned long long fetchedStep = 0;
+
+    void partition(const std::vector<glm::vec3>& positions, int shards, std::vector<unsigned int>& owner) const;
+    bool workersAlive();
+    void release();
+};
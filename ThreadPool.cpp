@@ -0,0 +1,93 @@
+#include "ThreadPool.h"
+#include <algorithm>
+
+namespace {
+    thread_local bool insidePoolTask = false;
+}
+
+ThreadPool& ThreadPool::instance() {
+    static ThreadPool pool;
+    return pool;
+}
+
+ThreadPool::ThreadPool(int threadCount) : nextChunk(0) {
+    if (threadCount <= 0) {
+        threadCount = (int)std::thread::hardware_concurrency();
+        if (threadCount <= 0) threadCount = 1;
+    }
+
+    for (int i = 1; i < threadCount; ++i) {
+        workers.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeCv.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::parallelFor(size_t count, size_t grain, const Task& task) {
+    if (count == 0) return;
+    if (grain == 0) grain = 1;
+
+    size_t chunks = (count + grain - 1) / grain;
+    if (workers.empty() || chunks == 1 || insidePoolTask) {
+        task(0, count, 0);
+        return;
+    }
+
+    std::lock_guard<std::mutex> callLock(callMutex);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job = &task;
+        jobCount = count;
+        jobGrain = grain;
+        jobChunks = chunks;
+        nextChunk.store(0);
+        activeWorkers = (int)workers.size();
+        ++generation;
+    }
+    wakeCv.notify_all();
+
+    runChunks(0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    doneCv.wait(lock, [this]() { return activeWorkers == 0; });
+    job = nullptr;
+}
+
+void ThreadPool::workerLoop(int index) {
+    unsigned long long seen = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wakeCv.wait(lock, [&]() { return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+        }
+
+        runChunks(index);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--activeWorkers == 0) {
+            doneCv.notify_one();
+        }
+    }
+}
+
+void ThreadPool::runChunks(int worker) {
+    insidePoolTask = true;
+    size_t chunk;
+    while ((chunk = nextChunk.fetch_add(1)) < jobChunks) {
+        size_t begin = chunk * jobGrain;
+        size_t end = std::min(begin + jobGrain, jobCount);
+        (*job)(begin, end, worker);
+    }
+    insidePoolTask = false;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Persistent worker pool shared by the analytics and layout code.
+// parallelFor splits [0, count) into chunks of `grain` items and hands them
+// out dynamically; the calling thread takes part as worker 0. Nested calls
+// from inside a task run inline on the current thread.
+class ThreadPool {
+public:
+    typedef std::function<void(size_t begin, size_t end, int worker)> Task;
+
+    static ThreadPool& instance();
+
+    explicit ThreadPool(int threadCount = 0);
+    ~ThreadPool();
+
+    // Number of workers including the calling thread; use it to size
+    // per-worker scratch buffers indexed by the `worker` argument.
+    int size() const { return (int)workers.size() + 1; }
+
+    void parallelFor(size_t count, size_t grain, const Task& task);
+
+private:
+    void workerLoop(int index);
+    void runChunks(int worker);
+
+    std::vector<std::thread> workers;
+    std::mutex callMutex;
+    std::mutex mutex;
+    std::condition_variable wakeCv;
+    std::condition_variable doneCv;
+
+    const Task* job = nullptr;
+    size_t jobCount = 0;
+    size_t jobGrain = 1;
+    size_t jobChunks = 0;
+    std::atomic<size_t> nextChunk;
+    unsigned long long generation = 0;
+    int activeWorkers = 0;
+    bool stopping = false;
+};
+
+// Convenience wrapper over the shared pool.
+inline void parallelFor(size_t count, size_t grain, const ThreadPool::Task& task) {
+    ThreadPool::instance().parallelFor(count, grain, task);
+}
@@ -0,0 +1,366 @@
+// Graph benchmark suite.
+//
+// Measures the generators, the layout passes, normalizePositions,
+// exportToSVG, the raster PNG export, overlap removal, the landmark distance
+// oracle and the CompactGraph equivalents over a range of graph sizes with fixed seeds and densities,
+// and writes the results as JSON so that two runs can be compared with
+// bench/compare_bench.py.
+//
+// Usage:
+//   GraphBench [--sizes 100,1000,...] [--seed N] [--degree D]
+//              [--max-quadratic N] [--min-time SEC] [--out FILE]
+
+#include "../Graph.h"
+#include "../CompactGraph.h"
+#include "../RasterExporter.h"
+#include "../OverlapRemover.h"
+#include "../DistanceOracle.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+struct BenchConfig {
+    std::vector<int> sizes = { 100, 1000, 10000, 100000, 1000000 };
+    unsigned int seed = 12345;
+    float averageDegree = 8.0f;
+    // Cases whose cost grows with n^2 are skipped above this node count.
+    int maxQuadratic = 20000;
+    double minTime = 0.2;
+    std::string output = "bench_output.json";
+};
+
+struct BenchResult {
+    std::string name;
+    int nodes = 0;
+    size_t edges = 0;
+    int iterations = 0;
+    double meanNs = 0.0;
+    double minNs = 0.0;
+    long peakRssKb = 0;
+    bool skipped = false;
+};
+
+static long peakRssKb() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) {
+        return (long)(pmc.PeakWorkingSetSize / 1024);
+    }
+    return 0;
+#else
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+#endif
+}
+
+// Runs setup + body repeatedly until minTime has elapsed, timing only body.
+static BenchResult runCase(const std::string& name, const BenchConfig& config, Graph& graph,
+    const std::function<void()>& setup, const std::function<void()>& body) {
+    typedef std::chrono::steady_clock Clock;
+
+    BenchResult result;
+    result.name = name;
+    result.minNs = 1e300;
+
+    double totalNs = 0.0;
+    while (result.iterations == 0 || totalNs < config.minTime * 1e9) {
+        if (setup) setup();
+        Clock::time_point start = Clock::now();
+        body();
+        Clock::time_point end = Clock::now();
+
+        double ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+        totalNs += ns;
+        if (ns < result.minNs) result.minNs = ns;
+        result.iterations++;
+    }
+
+    result.meanNs = totalNs / result.iterations;
+    result.nodes = (int)graph.nodes.size();
+    result.edges = graph.edges.size();
+    result.peakRssKb = peakRssKb();
+    return result;
+}
+
+static BenchResult compactCase(const std::string& name, const BenchConfig& config, CompactGraph& compact,
+    const std::function<void()>& setup, const std::function<void()>& body) {
+    Graph unused;
+    BenchResult result = runCase(name, config, unused, setup, body);
+    result.nodes = (int)compact.nodeCount();
+    result.edges = compact.edgeCount();
+    return result;
+}
+
+static BenchResult skippedCase(const std::string& name, int nodes) {
+    BenchResult result;
+    result.name = name;
+    result.nodes = nodes;
+    result.skipped = true;
+    return result;
+}
+
+// Builds a square 2D grid fixture directly, bypassing addEdge's duplicate
+// scan so that large fixtures can be prepared in linear time.
+static void buildGridFixture(Graph& graph, int nodeCount) {
+    int cols = (int)std::ceil(std::sqrt((double)nodeCount));
+    int rows = (nodeCount + cols - 1) / cols;
+
+    graph.clear();
+    graph.nodes.reserve(nodeCount);
+    graph.edges.reserve((size_t)nodeCount * 2);
+
+    for (int i = 0; i < nodeCount; ++i) {
+        int r = i / cols;
+        int c = i % cols;
+        graph.nodes.emplace_back(i, glm::vec3(c * 1.5f - (cols - 1) * 0.75f,
+            r * 1.5f - (rows - 1) * 0.75f, 0.0f));
+    }
+    for (int i = 0; i < nodeCount; ++i) {
+        int c = i % cols;
+        if (c < cols - 1 && i + 1 < nodeCount) graph.edges.emplace_back(i, i + 1);
+        if (i + cols < nodeCount) graph.edges.emplace_back(i, i + cols);
+    }
+    graph.nodeCount = nodeCount;
+}
+
+static std::vector<int> parseSizes(const char* text) {
+    std::vector<int> sizes;
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (!item.empty()) sizes.push_back(std::atoi(item.c_str()));
+    }
+    return sizes;
+}
+
+static bool parseArgs(int argc, char** argv, BenchConfig& config) {
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--sizes") == 0 && hasValue) {
+            config.sizes = parseSizes(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--seed") == 0 && hasValue) {
+            config.seed = (unsigned int)std::strtoul(argv[++i], NULL, 10);
+        }
+        else if (std::strcmp(argv[i], "--degree") == 0 && hasValue) {
+            config.averageDegree = (float)std::atof(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--max-quadratic") == 0 && hasValue) {
+            config.maxQuadratic = std::atoi(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--min-time") == 0 && hasValue) {
+            config.minTime = std::atof(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--out") == 0 && hasValue) {
+            config.output = argv[++i];
+        }
+        else {
+            std::cerr << "Unknown or incomplete argument: " << argv[i] << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+static void writeJson(std::ostream& out, const BenchConfig& config, const std::vector<BenchResult>& results) {
+    out << "{\n";
+    out << "  \"seed\": " << config.seed << ",\n";
+    out << "  \"average_degree\": " << config.averageDegree << ",\n";
+    out << "  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchResult& r = results[i];
+        out << "    {\"case\": \"" << r.name << "\", \"nodes\": " << r.nodes;
+        if (r.skipped) {
+            out << ", \"skipped\": true}";
+        }
+        else {
+            double seconds = r.meanNs * 1e-9;
+            out << ", \"edges\": " << r.edges
+                << ", \"iterations\": " << r.iterations
+                << ", \"mean_ns\": " << r.meanNs
+                << ", \"min_ns\": " << r.minNs
+                << ", \"ns_per_node\": " << (r.nodes > 0 ? r.meanNs / r.nodes : 0.0)
+                << ", \"ns_per_edge\": " << (r.edges > 0 ? r.meanNs / r.edges : 0.0)
+                << ", \"nodes_per_sec\": " << (seconds > 0.0 ? r.nodes / seconds : 0.0)
+                << ", \"edges_per_sec\": " << (seconds > 0.0 ? r.edges / seconds : 0.0)
+                << ", \"peak_rss_kb\": " << r.peakRssKb << "}";
+        }
+        out << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n";
+    out << "}\n";
+}
+
+int main(int argc, char** argv) {
+    BenchConfig config;
+    if (!parseArgs(argc, argv, config)) {
+        return 1;
+    }
+
+    std::vector<BenchResult> results;
+    const std::string svgPath = "bench_export.svg";
+    const std::string pngPath = "bench_export.png";
+
+    for (size_t s = 0; s < config.sizes.size(); ++s) {
+        const int n = config.sizes[s];
+        const bool quadraticOk = n <= config.maxQuadratic;
+        Graph graph;
+        graph.seed = config.seed;
+        graph.nodeCount = n;
+        graph.is3D = true;
+
+        std::cerr << "[bench] n = " << n << std::endl;
+
+        // Generators. All of them go through addEdge, whose duplicate check
+        // scans the edge list, so they are treated as quadratic.
+        if (quadraticOk) {
+            graph.edgeProbability = n > 1 ? std::min(1.0f, config.averageDegree / (n - 1)) : 0.0f;
+            results.push_back(runCase("generateRandomGraph", config, graph, nullptr,
+                [&]() { graph.generateRandomGraph(); }));
+
+            int side = (int)std::ceil(std::sqrt((double)n));
+            results.push_back(runCase("generateGridGraph", config, graph, nullptr,
+                [&]() { graph.generateGridGraph(side, side); }));
+
+            results.push_back(runCase("generateRingGraph", config, graph,
+                [&]() { graph.nodeCount = n; },
+                [&]() { graph.generateRingGraph(); }));
+
+            results.push_back(runCase("generateStarGraph", config, graph,
+                [&]() { graph.nodeCount = n; },
+                [&]() { graph.generateStarGraph(); }));
+        }
+        else {
+            results.push_back(skippedCase("generateRandomGraph", n));
+            results.push_back(skippedCase("generateGridGraph", n));
+            results.push_back(skippedCase("generateRingGraph", n));
+            results.push_back(skippedCase("generateStarGraph", n));
+        }
+
+        buildGridFixture(graph, n);
+
+        // Cases that move nodes start every iteration from the fixture, so
+        // each one times the same work whatever ran before it.
+        std::vector<glm::vec3> fixturePositions(graph.nodes.size());
+        for (size_t i = 0; i < graph.nodes.size(); ++i) fixturePositions[i] = graph.nodes[i].position;
+        auto restoreFixture = [&]() {
+            for (size_t i = 0; i < graph.nodes.size(); ++i) {
+                graph.nodes[i].position = fixturePositions[i];
+                graph.nodes[i].velocity = glm::vec3(0.0f);
+            }
+        };
+
+        // Layout passes are all-pairs in the repulsion step.
+        if (quadraticOk) {
+            results.push_back(runCase("applyForceDirectedLayout", config, graph, restoreFixture,
+                [&]() { graph.applyForceDirectedLayout(); }));
+            results.push_back(runCase("updateLayout", config, graph, restoreFixture,
+                [&]() { graph.updateLayout(0.016f); }));
+        }
+        else {
+            results.push_back(skippedCase("applyForceDirectedLayout", n));
+            results.push_back(skippedCase("updateLayout", n));
+        }
+
+        results.push_back(runCase("normalizePositions", config, graph, restoreFixture,
+            [&]() { graph.normalizePositions(); }));
+
+        glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 10.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+        glm::mat4 projection = glm::perspective(glm::radians(45.0f), 1200.0f / 800.0f, 0.1f, 100.0f);
+        std::streambuf* coutBuf = std::cout.rdbuf(NULL);
+        results.push_back(runCase("exportToSVG", config, graph, nullptr,
+            [&]() { graph.exportToSVG(svgPath, view, projection, 1200, 800); }));
+        RasterExporter raster;
+        results.push_back(runCase("exportPNG", config, graph, nullptr,
+            [&]() { raster.exportPNG(graph, pngPath, view, projection, 1200, 800); }));
+        std::cout.rdbuf(coutBuf);
+        std::cout.clear();
+
+        // Compact storage. The random generator samples edges directly; the
+        // layout's repulsion cut-off follows the node spacing, so its step
+        // stays linear even on the normalized fixture.
+        CompactGraph compact;
+        compact.seed = config.seed;
+        results.push_back(compactCase("compactGenerateRandomGraph", config, compact, nullptr,
+            [&]() { compact.generateRandomGraph(n, config.averageDegree); }));
+
+        // Every iteration is a first step from the normalized fixture, so
+        // it includes allocating the velocity and grid buffers.
+        compact.assign(graph);
+        const std::vector<glm::vec3> compactFixture = compact.positions;
+        results.push_back(compactCase("compactUpdateLayout", config, compact,
+            [&]() { compact.positions = compactFixture; compact.releaseScratch(); },
+            [&]() { compact.updateLayout(0.016f); }));
+        compact.positions = compactFixture;
+
+        std::vector<uint16_t> packed;
+        glm::vec3 origin, extent;
+        results.push_back(compactCase("compactQuantizePositions", config, compact, nullptr,
+            [&]() { compact.quantizePositions(packed, origin, extent); }));
+
+        // Landmark BFS over the grid fixture, then exact queries between
+        // fixed random pairs (the grid's long paths are the slow case for
+        // ALT). The query case times 64 paths per iteration.
+        DistanceOracle oracle;
+        results.push_back(compactCase("oracleBuild", config, compact, nullptr,
+            [&]() { oracle.build(compact); }));
+        std::mt19937 pairRng(config.seed);
+        std::uniform_int_distribution<uint32_t> pickNode(0, (uint32_t)std::max(1, n) - 1);
+        std::vector<uint32_t> pairs(128), path;
+        for (auto& v : pairs) v = pickNode(pairRng);
+        results.push_back(compactCase("oracleShortestPath", config, compact, nullptr,
+            [&]() {
+                for (size_t q = 0; q + 1 < pairs.size(); q += 2) oracle.shortestPath(pairs[q], pairs[q + 1], path);
+            }));
+
+        // Uniformly scattered nodes whose squares would cover about a
+        // quarter of the box if they did not overlap.
+        std::mt19937 rng(config.seed);
+        std::uniform_real_distribution<float> spread(-5.0f, 5.0f);
+        std::vector<glm::vec3> scattered((size_t)n), overlapping;
+        for (auto& p : scattered) p = glm::vec3(spread(rng), spread(rng), 0.0f);
+        OverlapRemover remover;
+        OverlapRemover::Stats overlapStats;
+        remover.radius = 2.5f / std::sqrt((float)std::max(1, n));
+        BenchResult overlapResult = runCase("removeOverlaps", config, graph,
+            [&]() { overlapping = scattered; },
+            [&]() { remover.removeOverlaps(overlapping, overlapStats); });
+        overlapResult.nodes = n;
+        overlapResult.edges = 0;
+        results.push_back(overlapResult);
+    }
+    std::remove(svgPath.c_str());
+    std::remove(pngPath.c_str());
+
+    std::ofstream file(config.output);
+    if (!file.is_open()) {
+        std::cerr << "Unable to write benchmark results: " << config.output << std::endl;
+        writeJson(std::cout, config, results);
+        return 1;
+    }
+    writeJson(file, config, results);
+    std::cerr << "Benchmark results written to " << config.output << std::endl;
+    return 0;
+}
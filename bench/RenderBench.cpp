@@ -0,0 +1,479 @@
+// Offscreen Renderer benchmark and pixel regression harness.
+//
+// Creates a headless OpenGL 3.3 core context through EGL (Mesa llvmpipe
+// works, no GPU or window needed), renders fixed graphs from fixed Camera
+// poses into an FBO, measures frames per second and time per draw call,
+// and compares the read-back pixels against golden images.
+//
+// Usage:
+//   RenderBench [--golden-dir DIR] [--update-golden] [--frames N]
+//               [--width W] [--height H] [--tolerance T]
+//               [--max-mismatch F] [--quantized] [--out FILE]
+//
+// --quantized draws through the compact 16-bit position path (CompactGraph)
+// and checks it against the same float goldens.
+//
+// Golden images are binary PPM files named <scene>_<pose>.ppm. On a
+// mismatch a <scene>_<pose>.actual.ppm is written next to the golden.
+// Goldens depend on the standard library's random distributions, so they
+// should be regenerated with --update-golden on the reference toolchain.
+
+#include <glad/glad.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include "../Graph.h"
+#include "../CompactGraph.h"
+#include "../Camera.h"
+#include "../Renderer.h"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#endif
+
+struct RenderBenchConfig {
+    std::string goldenDir = "bench/golden";
+    bool updateGolden = false;
+    int frames = 60;
+    int width = 512;
+    int height = 512;
+    int tolerance = 8;          // per-channel difference still treated as equal
+    double maxMismatch = 0.002; // fraction of pixels allowed to exceed tolerance
+    bool quantized = false;
+    std::string output = "render_bench_output.json";
+};
+
+struct Scene {
+    std::string name;
+    Graph graph;
+};
+
+struct Pose {
+    std::string name;
+    float yaw;
+    float pitch;
+    float distance;
+};
+
+struct RenderResult {
+    std::string scene;
+    std::string pose;
+    int nodes = 0;
+    size_t edges = 0;
+    double fps = 0.0;
+    double frameMs = 0.0;
+    double edgeDrawMs = 0.0;
+    double nodeDrawMs = 0.0;
+    double mismatch = 0.0;
+    std::string status;
+};
+
+class OffscreenContext {
+public:
+    EGLDisplay display = EGL_NO_DISPLAY;
+    EGLContext context = EGL_NO_CONTEXT;
+    GLuint fbo = 0, colorRb = 0, depthRb = 0;
+
+    bool create(int width, int height) {
+        PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+            (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+        if (getPlatformDisplay) {
+            display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+        }
+        if (display == EGL_NO_DISPLAY) {
+            display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+        }
+        EGLint major, minor;
+        if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor)) {
+            std::cerr << "EGL initialization failed" << std::endl;
+            return false;
+        }
+
+        const EGLint configAttribs[] = {
+            EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+            EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+            EGL_NONE
+        };
+        EGLConfig config;
+        EGLint numConfigs = 0;
+        if (!eglChooseConfig(display, configAttribs, &config, 1, &numConfigs) || numConfigs == 0) {
+            std::cerr << "No suitable EGL config" << std::endl;
+            return false;
+        }
+
+        eglBindAPI(EGL_OPENGL_API);
+        const EGLint contextAttribs[] = {
+            EGL_CONTEXT_MAJOR_VERSION, 3,
+            EGL_CONTEXT_MINOR_VERSION, 3,
+            EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+            EGL_NONE
+        };
+        context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttribs);
+        if (context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+            std::cerr << "Unable to create a surfaceless OpenGL 3.3 context" << std::endl;
+            return false;
+        }
+
+        if (!gladLoadGLLoader((GLADloadproc)eglGetProcAddress)) {
+            std::cerr << "GLAD initialization failed" << std::endl;
+            return false;
+        }
+
+        glGenRenderbuffers(1, &colorRb);
+        glBindRenderbuffer(GL_RENDERBUFFER, colorRb);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+        glGenRenderbuffers(1, &depthRb);
+        glBindRenderbuffer(GL_RENDERBUFFER, depthRb);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+
+        glGenFramebuffers(1, &fbo);
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorRb);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthRb);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            std::cerr << "Offscreen framebuffer is incomplete" << std::endl;
+            return false;
+        }
+
+        glViewport(0, 0, width, height);
+        std::cerr << "Renderer: " << glGetString(GL_RENDERER) << std::endl;
+        return true;
+    }
+
+    void destroy() {
+        if (fbo) glDeleteFramebuffers(1, &fbo);
+        if (colorRb) glDeleteRenderbuffers(1, &colorRb);
+        if (depthRb) glDeleteRenderbuffers(1, &depthRb);
+        if (display != EGL_NO_DISPLAY) {
+            eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+            if (context != EGL_NO_CONTEXT) eglDestroyContext(display, context);
+            eglTerminate(display);
+        }
+    }
+};
+
+static bool readPPM(const std::string& path, int& width, int& height, std::vector<unsigned char>& rgb) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) return false;
+    std::string magic;
+    int maxValue;
+    file >> magic >> width >> height >> maxValue;
+    file.get();
+    if (magic != "P6" || maxValue != 255) return false;
+    rgb.resize((size_t)width * height * 3);
+    file.read((char*)rgb.data(), rgb.size());
+    return (bool)file;
+}
+
+static bool writePPM(const std::string& path, int width, int height, const std::vector<unsigned char>& rgb) {
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Unable to write image: " << path << std::endl;
+        return false;
+    }
+    file << "P6\n" << width << " " << height << "\n255\n";
+    file.write((const char*)rgb.data(), rgb.size());
+    return true;
+}
+
+// Creates `path` and any missing parents; true if it exists afterwards.
+static bool makeDirectories(const std::string& path) {
+    for (size_t end = 0; end != std::string::npos;) {
+        end = path.find_first_of("/\\", end + 1);
+        std::string prefix = path.substr(0, end);
+        if (prefix.empty()) continue;
+#ifdef _WIN32
+        _mkdir(prefix.c_str());
+#else
+        mkdir(prefix.c_str(), 0755);
+#endif
+    }
+    struct stat info;
+    return stat(path.c_str(), &info) == 0 && (info.st_mode & S_IFDIR);
+}
+
+static std::vector<unsigned char> readFramebuffer(int width, int height) {
+    std::vector<unsigned char> rgba((size_t)width * height * 4);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, rgba.data());
+
+    // Flip to top-down rows and drop alpha.
+    std::vector<unsigned char> rgb((size_t)width * height * 3);
+    for (int y = 0; y < height; ++y) {
+        const unsigned char* src = &rgba[(size_t)(height - 1 - y) * width * 4];
+        unsigned char* dst = &rgb[(size_t)y * width * 3];
+        for (int x = 0; x < width; ++x) {
+            dst[x * 3 + 0] = src[x * 4 + 0];
+            dst[x * 3 + 1] = src[x * 4 + 1];
+            dst[x * 3 + 2] = src[x * 4 + 2];
+        }
+    }
+    return rgb;
+}
+
+static double mismatchFraction(const std::vector<unsigned char>& a, const std::vector<unsigned char>& b, int tolerance) {
+    size_t pixels = a.size() / 3;
+    size_t bad = 0;
+    for (size_t i = 0; i < pixels; ++i) {
+        for (int c = 0; c < 3; ++c) {
+            if (std::abs((int)a[i * 3 + c] - (int)b[i * 3 + c]) > tolerance) {
+                bad++;
+                break;
+            }
+        }
+    }
+    return pixels > 0 ? (double)bad / pixels : 0.0;
+}
+
+static void buildScenes(std::vector<Scene>& scenes) {
+    scenes.resize(3);
+
+    scenes[0].name = "grid";
+    scenes[0].graph.is3D = true;
+    scenes[0].graph.generateGridGraph(20, 20);
+
+    scenes[1].name = "random";
+    scenes[1].graph.seed = 12345;
+    scenes[1].graph.nodeCount = 300;
+    scenes[1].graph.edgeProbability = 0.02f;
+    scenes[1].graph.generateRandomGraph();
+
+    scenes[2].name = "ring";
+    scenes[2].graph.seed = 12345;
+    scenes[2].graph.nodeCount = 500;
+    scenes[2].graph.generateRingGraph();
+
+    for (auto& scene : scenes) {
+        scene.graph.normalizePositions();
+    }
+}
+
+static bool parseArgs(int argc, char** argv, RenderBenchConfig& config) {
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--golden-dir") == 0 && hasValue) {
+            config.goldenDir = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--update-golden") == 0) {
+            config.updateGolden = true;
+        }
+        else if (std::strcmp(argv[i], "--frames") == 0 && hasValue) {
+            config.frames = std::atoi(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--width") == 0 && hasValue) {
+            config.width = std::atoi(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--height") == 0 && hasValue) {
+            config.height = std::atoi(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--tolerance") == 0 && hasValue) {
+            config.tolerance = std::atoi(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--max-mismatch") == 0 && hasValue) {
+            config.maxMismatch = std::atof(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--quantized") == 0) {
+            config.quantized = true;
+        }
+        else if (std::strcmp(argv[i], "--out") == 0 && hasValue) {
+            config.output = argv[++i];
+        }
+        else {
+            std::cerr << "Unknown or incomplete argument: " << argv[i] << std::endl;
+            return false;
+        }
+    }
+    if (config.frames < 1) config.frames = 1;
+    return true;
+}
+
+static void writeJson(std::ostream& out, const RenderBenchConfig& config, const std::vector<RenderResult>& results) {
+    out << "{\n";
+    out << "  \"width\": " << config.width << ",\n";
+    out << "  \"height\": " << config.height << ",\n";
+    out << "  \"frames\": " << config.frames << ",\n";
+    out << "  \"quantized\": " << (config.quantized ? "true" : "false") << ",\n";
+    out << "  \"renderer\": \"" << (const char*)glGetString(GL_RENDERER) << "\",\n";
+    out << "  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const RenderResult& r = results[i];
+        out << "    {\"case\": \"" << r.scene << "_" << r.pose << "\""
+            << ", \"nodes\": " << r.nodes
+            << ", \"edges\": " << r.edges
+            << ", \"fps\": " << r.fps
+            << ", \"mean_ns\": " << r.frameMs * 1e6
+            << ", \"frame_ms\": " << r.frameMs
+            << ", \"edge_draw_ms\": " << r.edgeDrawMs
+            << ", \"node_draw_ms\": " << r.nodeDrawMs
+            << ", \"pixel_mismatch\": " << r.mismatch
+            << ", \"status\": \"" << r.status << "\"}"
+            << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n";
+    out << "}\n";
+}
+
+int main(int argc, char** argv) {
+    typedef std::chrono::steady_clock Clock;
+
+    RenderBenchConfig config;
+    if (!parseArgs(argc, argv, config)) {
+        return 1;
+    }
+    if (config.updateGolden && !makeDirectories(config.goldenDir)) {
+        std::cerr << "Unable to create golden directory: " << config.goldenDir << std::endl;
+        return 1;
+    }
+
+    OffscreenContext offscreen;
+    if (!offscreen.create(config.width, config.height)) {
+        offscreen.destroy();
+        return 1;
+    }
+
+    glEnable(GL_DEPTH_TEST);
+
+    std::vector<Scene> scenes;
+    buildScenes(scenes);
+
+    const Pose poses[] = {
+        { "front", -90.0f, 0.0f, 10.0f },
+        { "orbit", -45.0f, 30.0f, 12.0f },
+        { "close", -120.0f, -20.0f, 5.0f }
+    };
+
+    std::vector<RenderResult> results;
+    bool failed = false;
+
+    {
+        Renderer renderer;
+        renderer.initialize();
+
+        for (auto& scene : scenes) {
+            std::vector<glm::vec3> positions;
+            for (const auto& node : scene.graph.nodes) {
+                positions.push_back(node.position);
+            }
+            std::vector<unsigned int> edgeIndices;
+            for (const auto& edge : scene.graph.edges) {
+                edgeIndices.push_back((unsigned int)edge.from);
+                edgeIndices.push_back((unsigned int)edge.to);
+            }
+            renderer.uploadEdges(edgeIndices, 0, edgeIndices.size());
+            renderer.uploadColors(std::vector<glm::vec3>());
+
+            CompactGraph compact;
+            if (config.quantized) {
+                compact.assign(scene.graph);
+            }
+            std::vector<unsigned short> packed;
+            glm::vec3 origin, extent;
+
+            for (const auto& pose : poses) {
+                Camera camera;
+                camera.yaw = pose.yaw;
+                camera.pitch = pose.pitch;
+                camera.distance = pose.distance;
+                camera.updateCameraVectors();
+                camera.setTarget(glm::vec3(0.0f));
+
+                glm::mat4 projection = camera.getProjectionMatrix((float)config.width / (float)config.height, camera.zoom);
+                glm::mat4 MVP = projection * camera.getViewMatrix();
+
+                RenderResult result;
+                result.scene = scene.name;
+                result.pose = pose.name;
+                result.nodes = (int)positions.size();
+                result.edges = scene.graph.edges.size();
+
+                // One untimed frame to warm up shader compilation and buffers.
+                for (int frame = -1; frame < config.frames; ++frame) {
+                    Clock::time_point frameStart = Clock::now();
+                    glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+                    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+                    // Re-send every position, as a frame of a running layout would.
+                    if (config.quantized) {
+                        compact.quantizePositions(packed, origin, extent);
+                        renderer.uploadQuantizedPositions(packed, 0, compact.nodeCount(), origin, extent);
+                    }
+                    else {
+                        renderer.uploadPositions(positions, 0, positions.size());
+                    }
+
+                    Clock::time_point edgeStart = Clock::now();
+                    renderer.renderEdges(MVP);
+                    glFinish();
+                    Clock::time_point nodeStart = Clock::now();
+                    renderer.renderNodes(MVP);
+                    glFinish();
+                    Clock::time_point frameEnd = Clock::now();
+
+                    if (frame >= 0) {
+                        result.edgeDrawMs += std::chrono::duration<double, std::milli>(nodeStart - edgeStart).count();
+                        result.nodeDrawMs += std::chrono::duration<double, std::milli>(frameEnd - nodeStart).count();
+                        result.frameMs += std::chrono::duration<double, std::milli>(frameEnd - frameStart).count();
+                    }
+                }
+                result.edgeDrawMs /= config.frames;
+                result.nodeDrawMs /= config.frames;
+                result.frameMs /= config.frames;
+                result.fps = result.frameMs > 0.0 ? 1000.0 / result.frameMs : 0.0;
+
+                std::vector<unsigned char> pixels = readFramebuffer(config.width, config.height);
+                std::string goldenPath = config.goldenDir + "/" + scene.name + "_" + pose.name + ".ppm";
+
+                if (config.updateGolden) {
+                    result.status = writePPM(goldenPath, config.width, config.height, pixels) ? "updated" : "error";
+                }
+                else {
+                    int goldenWidth, goldenHeight;
+                    std::vector<unsigned char> golden;
+                    if (!readPPM(goldenPath, goldenWidth, goldenHeight, golden)) {
+                        result.status = "missing_golden";
+                        failed = true;
+                    }
+                    else if (goldenWidth != config.width || goldenHeight != config.height) {
+                        result.status = "size_mismatch";
+                        failed = true;
+                    }
+                    else {
+                        result.mismatch = mismatchFraction(pixels, golden, config.tolerance);
+                        if (result.mismatch > config.maxMismatch) {
+                            result.status = "fail";
+                            failed = true;
+                            writePPM(config.goldenDir + "/" + scene.name + "_" + pose.name + ".actual.ppm",
+                                config.width, config.height, pixels);
+                        }
+                        else {
+                            result.status = "pass";
+                        }
+                    }
+                }
+
+                std::cerr << scene.name << "/" << pose.name << ": " << result.fps << " fps, "
+                    << result.frameMs << " ms/frame, " << result.status << std::endl;
+                results.push_back(result);
+            }
+        }
+
+        std::ofstream file(config.output);
+        if (file.is_open()) {
+            writeJson(file, config, results);
+        }
+        else {
+            std::cerr << "Unable to write benchmark results: " << config.output << std::endl;
+            writeJson(std::cout, config, results);
+        }
+    }
+
+    offscreen.destroy();
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,68 @@
+#!/usr/bin/env python3
+"""Compare two GraphBench JSON outputs and flag regressions.
+
+Usage:
+    compare_bench.py BASELINE.json CURRENT.json [--threshold 0.10] [--metric mean_ns]
+
+Cases are matched by (case, nodes). A case regresses when the chosen metric
+grows by more than the threshold (10% by default). The exit code is 1 if any
+case regressed, so the script can gate a CI job.
+"""
+
+import argparse
+import json
+import sys
+
+
+def load(path):
+    with open(path, "r", encoding="utf-8") as f:
+        data = json.load(f)
+    results = {}
+    for r in data.get("results", []):
+        if r.get("skipped"):
+            continue
+        results[(r["case"], r["nodes"])] = r
+    return results
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("baseline")
+    parser.add_argument("current")
+    parser.add_argument("--threshold", type=float, default=0.10,
+                        help="relative slowdown treated as a regression")
+    parser.add_argument("--metric", default="mean_ns",
+                        help="lower-is-better metric to compare (mean_ns, min_ns, ns_per_node, peak_rss_kb, ...)")
+    args = parser.parse_args()
+
+    baseline = load(args.baseline)
+    current = load(args.current)
+
+    regressions = 0
+    print("%-28s %10s %14s %14s %9s" % ("case", "nodes", "baseline", "current", "change"))
+    for key in sorted(set(baseline) & set(current), key=lambda k: (k[0], k[1])):
+        old = baseline[key].get(args.metric)
+        new = current[key].get(args.metric)
+        if old is None or new is None or old <= 0:
+            continue
+        change = (new - old) / old
+        flag = ""
+        if change > args.threshold:
+            flag = "  REGRESSION"
+            regressions += 1
+        elif change < -args.threshold:
+            flag = "  improved"
+        print("%-28s %10d %14.4g %14.4g %+8.1f%%%s" % (key[0], key[1], old, new, change * 100.0, flag))
+
+    for key in sorted(set(baseline) ^ set(current)):
+        side = "baseline" if key in baseline else "current"
+        print("%-28s %10d only in %s" % (key[0], key[1], side))
+
+    if regressions:
+        print("\n%d regression(s) above %.0f%%" % (regressions, args.threshold * 100.0))
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
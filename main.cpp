@@ -9,25 +9,132 @@
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <thread>
 #include <vector>
 #include <ctime>
 #include "Graph.h"
 #include "Camera.h"
 #include "Renderer.h"
 #include "GuiController.h"
+#include "GraphAnalytics.h"
+#include "CommunityDetector.h"
+#include "MutationStream.h"
+#include "CompactGraph.h"
+#include "FrameScheduler.h"
+#include "ShardedLayout.h"
+#include "LayoutServer.h"
+#include "LayoutClient.h"
+#include "LayoutTuner.h"
+#include "RasterExporter.h"
+#include "OutOfCoreLayout.h"
+#include "LayoutTelemetry.h"
+#include "OverlapRemover.h"
+#include "DistanceOracle.h"
 
 GLFWwindow* window = nullptr;
 Camera camera;
 Renderer renderer;
 Graph graph;
 GuiController gui;
+GraphAnalytics analytics;
+CommunityDetector communities;
+MutationStream mutationStream;
+std::vector<glm::vec3> nodeColors;
+int appliedColorMode = -1;
+unsigned long long appliedTopology = 0;
+// Per-node radii and flags as last sent to the renderer; an empty array
+// means the renderer's default. Updates only upload the span that changed.
+std::vector<float> nodeRadii;
+std::vector<unsigned int> nodeFlags;
+int appliedSizeMode = -1;
+
+// CPU copies of the GPU buffers; only the dirty ranges are refreshed.
+std::vector<glm::vec3> positionMirror;
+std::vector<unsigned int> edgeIndexMirror;
+
+// Compact mode replaces `graph` with a CompactGraph drawn from 16-bit positions.
+CompactGraph compactGraph;
+std::vector<unsigned short> quantizedPositions;
+bool compactActive = false;
+bool compactPositionsDirty = false;
+FrameScheduler scheduler;
+// While the sharded layout runs, worker processes own the positions and the
+// loop only copies their snapshots in.
+ShardedLayout shardedLayout;
+std::vector<glm::vec3> shardedPositions;
+// With --connect the window only shows a layout computed by a --serve process.
+LayoutClient layoutClient;
+// Lays out copies of the graph with different settings in the background.
+LayoutTuner tuner;
+int tunerShown = 0;
+bool tunerReported = true;
+// Per-step energy, displacement and force plus periodic quality samples of
+// the in-process layout, plotted in the GUI and optionally logged.
+LayoutTelemetry telemetry;
+// Pushes overlapping nodes apart in the background once the layout is idle.
+// layoutVersion counts position changes made by the layout; a result is
+// only applied if nothing moved while it was computed.
+OverlapRemover overlapRemover;
+unsigned long long layoutVersion = 1;
+unsigned long long overlapVersion = 0;
+bool overlapCompact = false;
+// Landmark distances for approximate distance and exact path queries; the
+// last path found is highlighted over the graph.
+DistanceOracle oracle;
+std::vector<unsigned int> highlightedPath;
+// Auto layout stops stepping once it has settled and resumes on the next
+// input event. Sparse layouts converge below layoutSettleThreshold; dense
+// ones keep jittering at a small amplitude, so a largest step that has not
+// improved for layoutStallSteps steps counts as settled as well.
+const float layoutSettleThreshold = 1e-4f;
+const float layoutJitterLimit = 0.05f;
+const int layoutStallSteps = 180;
+bool layoutSettled = false;
+float layoutBestStep = 1e30f;
+int layoutStalled = 0;
+
+bool layoutHasSettled(float moved) {
+    if (moved < layoutSettleThreshold) return true;
+    if (moved < layoutBestStep * 0.99f) {
+        layoutBestStep = moved;
+        layoutStalled = 0;
+        return false;
+    }
+    return ++layoutStalled >= layoutStallSteps && moved < layoutJitterLimit;
+}
 bool firstMouse = true;
 float lastX = 400.0f, lastY = 300.0f;
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
+void fitCameraToBounds(const glm::vec3& min_pos, const glm::vec3& max_pos) {
+    glm::vec3 center = (min_pos + max_pos) * 0.5f;
+    glm::vec3 size = max_pos - min_pos;
+    float max_size = glm::max(glm::max(size.x, size.y), size.z);
+
+    camera.setTarget(center);
+
+    camera.distance = max_size * 2.0f;
+    if (camera.distance < 5.0f) camera.distance = 10.0f;
+    if (camera.distance > 50.0f) camera.distance = 50.0f;
+
+    camera.position = center - camera.front * camera.distance;
+}
+
 void adjustCameraToFitGraph() {
+    if (compactActive) {
+        if (compactGraph.nodeCount() == 0) return;
+        glm::vec3 min_pos, max_pos;
+        compactGraph.bounds(min_pos, max_pos);
+        fitCameraToBounds(min_pos, max_pos);
+        return;
+    }
+
     if (graph.nodes.empty()) return;
 
     glm::vec3 min_pos = graph.nodes[0].position;
@@ -38,24 +145,543 @@ void adjustCameraToFitGraph() {
         max_pos = glm::max(max_pos, node.position);
     }
 
-    glm::vec3 center = (min_pos + max_pos) * 0.5f;
-    glm::vec3 size = max_pos - min_pos;
-    float max_size = glm::max(glm::max(size.x, size.y), size.z);
+    fitCameraToBounds(min_pos, max_pos);
+}
 
-    camera.setTarget(center);
+void generateCompactGraph() {
+    compactGraph.is3D = gui.params.is3D;
+    int n = gui.params.compactNodeCount;
 
-    camera.distance = max_size * 2.0f;
-    if (camera.distance < 5.0f) camera.distance = 10.0f;
-    if (camera.distance > 50.0f) camera.distance = 50.0f;
+    switch (gui.params.graphType) {
+    case 0:
+        compactGraph.generateRandomGraph(n, gui.params.compactDegree);
+        break;
+    case 1: {
+        int side = (int)std::ceil(std::sqrt((double)n));
+        compactGraph.generateGridGraph(side, side);
+        break;
+    }
+    case 2:
+        compactGraph.generateRingGraph(n);
+        break;
+    case 3:
+        compactGraph.generateStarGraph(n);
+        break;
+    }
+    compactGraph.normalizePositions();
 
-    camera.position = center - camera.front * camera.distance;
+    renderer.uploadEdges(compactGraph.edgeIndices, 0, compactGraph.edgeIndices.size());
+    compactPositionsDirty = true;
 }
+
+void startShardedLayout() {
+    if (layoutClient.isConnected()) {
+        std::cout << "Sharded layout is not available while viewing a remote layout" << std::endl;
+        return;
+    }
+
+    std::vector<glm::vec3> positions;
+    std::vector<unsigned int> edgeIndices;
+    if (compactActive) {
+        positions = compactGraph.positions;
+        edgeIndices = compactGraph.edgeIndices;
+    }
+    else {
+        positions.reserve(graph.nodes.size());
+        for (const auto& node : graph.nodes) positions.push_back(node.position);
+        edgeIndices.reserve(graph.edges.size() * 2);
+        for (const auto& edge : graph.edges) {
+            edgeIndices.push_back((unsigned int)edge.from);
+            edgeIndices.push_back((unsigned int)edge.to);
+        }
+    }
+
+    shardedLayout.shardCount = gui.params.shardCount;
+    shardedLayout.pinWorkers = gui.params.pinWorkers;
+    if (!shardedLayout.start(positions, edgeIndices)) {
+        std::cout << "Sharded layout failed: " << shardedLayout.error << std::endl;
+    }
+}
+
+void startTuning() {
+    if (compactActive) {
+        std::cout << "Parameter tuning is not available in compact mode" << std::endl;
+        return;
+    }
+    tuner.search = gui.params.tuneSearch;
+    tuner.budget = gui.params.tuneBudget;
+    tuner.maxSteps = gui.params.tuneMaxSteps;
+    if (tuner.start(graph)) {
+        tunerReported = false;
+    }
+}
+
+void reportTuning() {
+    std::vector<TuneResult> results = tuner.results();
+    std::cout << "Tuned " << results.size() << " layouts in " << tuner.elapsedSeconds() << " s" << std::endl;
+    for (const auto& result : results) {
+        std::cout << "  repulsion " << result.repulsion << ", attraction " << result.attraction
+                  << ": score " << result.score << " (stress " << result.stress << ", edge length cv " << result.edgeLengthCV
+                  << ", crossings " << result.crossingRate << "), " << result.steps << " steps"
+                  << (result.converged ? "" : " without settling") << ", within 5% after " << result.timeToQuality << " s"
+                  << std::endl;
+    }
+}
+
+// World size of one pixel at the camera target.
+float worldUnitsPerPixel() {
+    int width, height;
+    glfwGetFramebufferSize(window, &width, &height);
+    float distance = glm::length(camera.position - camera.target);
+    return 2.0f * distance * std::tan(glm::radians(camera.zoom) * 0.5f) / std::max(1, height);
+}
+
+void startOverlapRemoval() {
+    overlapRemover.radius = gui.params.overlapRadius * worldUnitsPerPixel();
+    overlapVersion = layoutVersion;
+    overlapCompact = compactActive;
+
+    // Degree-sized nodes keep their drawn size relative to the overlap radius.
+    const size_t nodes = compactActive ? compactGraph.nodeCount() : graph.nodes.size();
+    std::vector<float> radii;
+    if (gui.params.nodeSizeMode == NODE_SIZE_DEGREE && nodeRadii.size() == nodes && renderer.nodeRadius > 0.0f) {
+        radii.resize(nodes);
+        for (size_t i = 0; i < nodes; ++i) radii[i] = nodeRadii[i] / renderer.nodeRadius * overlapRemover.radius;
+    }
+
+    if (compactActive) {
+        overlapRemover.start(compactGraph.positions, radii);
+        return;
+    }
+    std::vector<glm::vec3> positions(graph.nodes.size());
+    for (size_t i = 0; i < graph.nodes.size(); ++i) {
+        positions[i] = graph.nodes[i].position;
+    }
+    overlapRemover.start(positions, radii);
+}
+
+bool applyOverlapRemoval() {
+    std::vector<glm::vec3> positions;
+    if (!overlapRemover.takeResult(positions)) return false;
+    if (overlapVersion != layoutVersion || overlapCompact != compactActive) return false;
+
+    const OverlapRemover::Stats& stats = overlapRemover.lastStats;
+    std::cout << "Overlaps removed: " << stats.moved << " of " << stats.nodes << " nodes moved (at most "
+              << stats.maxMove << "), " << stats.seconds * 1000.0 << " ms" << std::endl;
+    if (compactActive && positions.size() == compactGraph.positions.size()) {
+        compactGraph.positions.swap(positions);
+        compactPositionsDirty = true;
+    }
+    else if (!compactActive && positions.size() == graph.nodes.size()) {
+        for (size_t i = 0; i < graph.nodes.size(); ++i) {
+            graph.nodes[i].position = positions[i];
+        }
+        graph.dirtyNodes.markAll();
+    }
+    return true;
+}
+
+void showPath(const std::vector<uint32_t>& path) {
+    // Path nodes are drawn enlarged with a ring. Only the flags of the old
+    // and new path nodes change, so only their span is uploaded.
+    const size_t nodes = compactActive ? compactGraph.nodeCount() : graph.nodes.size();
+    size_t begin = nodes, end = 0;
+    if (nodeFlags.size() != nodes) {
+        nodeFlags.assign(nodes, 0);
+        begin = 0;
+        end = nodes;
+    }
+    for (unsigned int v : highlightedPath) {
+        if (v >= nodes) continue;
+        nodeFlags[v] &= ~(unsigned int)Renderer::NODE_SELECTED;
+        begin = std::min(begin, (size_t)v);
+        end = std::max(end, (size_t)v + 1);
+    }
+    for (uint32_t v : path) {
+        if (v >= nodes) continue;
+        nodeFlags[v] |= Renderer::NODE_SELECTED;
+        begin = std::min(begin, (size_t)v);
+        end = std::max(end, (size_t)v + 1);
+    }
+    if (begin < end) renderer.uploadFlags(nodeFlags, begin, end);
+
+    highlightedPath.assign(path.begin(), path.end());
+    renderer.uploadPath(highlightedPath);
+}
+
+// The topology changed: landmark distances and the path are stale.
+void resetPaths() {
+    oracle.clear();
+    showPath(std::vector<uint32_t>());
+}
+
+void buildOracle() {
+    oracle.landmarkCount = gui.params.landmarkCount;
+    if (compactActive) {
+        oracle.build(compactGraph);
+    }
+    else {
+        oracle.build(graph);
+    }
+    std::cout << "Distance oracle: " << oracle.landmarks().size() << " landmarks, " << oracle.buildMs << " ms" << std::endl;
+}
+
+void findPath() {
+    if (!oracle.valid()) {
+        buildOracle();
+    }
+
+    std::vector<uint32_t> path;
+    if (!oracle.shortestPath((uint32_t)gui.params.pathSource, (uint32_t)gui.params.pathTarget, path)) {
+        std::cout << "No path from " << gui.params.pathSource << " to " << gui.params.pathTarget << std::endl;
+    }
+    showPath(path);
+}
+
+// Degree-sized radii are scaled against the mean degree of the last full
+// update, so a mutation only changes the radii of the nodes it touched.
+float sizeMeanDegree = 0.0f;
+
+float degreeRadius(int degree) {
+    float scale = std::sqrt((degree + 1.0f) / (sizeMeanDegree + 1.0f));
+    return gui.params.nodeRadius * std::min(4.0f, std::max(0.5f, scale));
+}
+
+// Radius per node: uniform, or scaled by sqrt(degree / mean degree) so hubs
+// stand out without dwarfing the rest.
+void updateNodeSizes() {
+    renderer.nodeRadius = gui.params.nodeRadius;
+    graph.dirtyDegrees.clear();
+    if (gui.params.nodeSizeMode == NODE_SIZE_UNIFORM) {
+        if (!nodeRadii.empty()) {
+            nodeRadii.clear();
+            renderer.uploadRadii(nodeRadii, 0, 0);
+        }
+        return;
+    }
+
+    const size_t nodes = compactActive ? compactGraph.nodeCount() : graph.nodes.size();
+    std::vector<int> degree(nodes, 0);
+    if (compactActive) {
+        for (uint32_t v : compactGraph.edgeIndices) degree[v]++;
+    }
+    else {
+        for (const auto& edge : graph.edges) {
+            degree[edge.from]++;
+            degree[edge.to]++;
+        }
+    }
+    size_t degreeSum = 0;
+    for (int d : degree) degreeSum += d;
+    sizeMeanDegree = nodes > 0 ? (float)degreeSum / nodes : 0.0f;
+
+    std::vector<float> radii(nodes);
+    for (size_t i = 0; i < nodes; ++i) {
+        radii[i] = degreeRadius(degree[i]);
+    }
+
+    // Upload from the first to the last radius that differs.
+    size_t begin = 0, end = nodes;
+    if (radii.size() == nodeRadii.size()) {
+        while (begin < end && radii[begin] == nodeRadii[begin]) ++begin;
+        while (end > begin && radii[end - 1] == nodeRadii[end - 1]) --end;
+    }
+    nodeRadii.swap(radii);
+    if (begin < end || nodeRadii.empty()) renderer.uploadRadii(nodeRadii, begin, end);
+}
+
+// Recomputes and uploads only the radii of nodes whose degree changed.
+void patchNodeSizes() {
+    if (compactActive || graph.dirtyDegrees.empty()) return;
+    if (gui.params.nodeSizeMode == NODE_SIZE_UNIFORM || graph.dirtyDegrees.all) {
+        updateNodeSizes();
+        return;
+    }
+
+    const size_t nodes = graph.nodes.size();
+    nodeRadii.resize(nodes, gui.params.nodeRadius);
+    for (const auto& range : graph.dirtyDegrees.coalesce(nodes)) {
+        for (size_t i = range.first; i < range.second; ++i) {
+            nodeRadii[i] = degreeRadius(graph.degree((int)i));
+        }
+        renderer.uploadRadii(nodeRadii, range.first, range.second);
+    }
+    // An empty range still updates the count after removals.
+    renderer.uploadRadii(nodeRadii, 0, 0);
+    graph.dirtyDegrees.clear();
+}
+
+void syncRenderBuffers() {
+    if (compactActive) {
+        // Layout moves every node, so the whole array is re-quantized against
+        // the new bounding box.
+        if (compactPositionsDirty) {
+            glm::vec3 origin, extent;
+            compactGraph.quantizePositions(quantizedPositions, origin, extent);
+            renderer.uploadQuantizedPositions(quantizedPositions, 0, compactGraph.nodeCount(), origin, extent);
+            compactPositionsDirty = false;
+        }
+        return;
+    }
+
+    size_t nodeTotal = graph.nodes.size();
+    size_t edgeTotal = graph.edges.size();
+    positionMirror.resize(nodeTotal);
+    edgeIndexMirror.resize(edgeTotal * 2);
+
+    if (!graph.dirtyNodes.empty()) {
+        for (const auto& range : graph.dirtyNodes.coalesce(nodeTotal)) {
+            for (size_t i = range.first; i < range.second; ++i) {
+                positionMirror[i] = graph.nodes[i].position;
+            }
+            renderer.uploadPositions(positionMirror, range.first, range.second);
+        }
+    }
+    // An empty range still updates the draw count after removals.
+    renderer.uploadPositions(positionMirror, 0, 0);
+
+    if (!graph.dirtyEdges.empty()) {
+        for (const auto& range : graph.dirtyEdges.coalesce(edgeTotal)) {
+            for (size_t i = range.first; i < range.second; ++i) {
+                edgeIndexMirror[2 * i] = (unsigned int)graph.edges[i].from;
+                edgeIndexMirror[2 * i + 1] = (unsigned int)graph.edges[i].to;
+            }
+            renderer.uploadEdges(edgeIndexMirror, 2 * range.first, 2 * range.second);
+        }
+    }
+    renderer.uploadEdges(edgeIndexMirror, 0, 0);
+
+    graph.dirtyNodes.clear();
+    graph.dirtyEdges.clear();
+}
+
+// Input may change the camera or GUI parameters: draw again and let a
+// settled layout take another look.
+void wake() {
+    scheduler.requestRedraw();
+    layoutSettled = false;
+    layoutBestStep = 1e30f;
+    layoutStalled = 0;
+}
+
+volatile std::sig_atomic_t serverStopRequested = 0;
+
+void requestServerStop(int) {
+    serverStopRequested = 1;
+}
+
+// Headless --serve mode: lays out a random graph and publishes every step
+// to the connected viewers until interrupted.
+int runLayoutServer(const std::string& endpoint, int nodeCount, float edgeProbability, int stepsPerSecond, int kilobytesPerSecond) {
+    graph.nodeCount = nodeCount;
+    graph.edgeProbability = edgeProbability;
+    graph.generateRandomGraph();
+    graph.normalizePositions();
+
+    LayoutServer server;
+    server.bytesPerSecond = (size_t)kilobytesPerSecond * 1024;
+    if (!server.listen(endpoint)) {
+        std::cout << "Cannot listen on " << endpoint << ": " << server.error << std::endl;
+        return 1;
+    }
+    std::cout << "Serving " << graph.nodes.size() << " nodes, " << graph.edges.size() << " edges on " << endpoint << std::endl;
+
+    std::signal(SIGINT, requestServerStop);
+    std::signal(SIGTERM, requestServerStop);
+
+    typedef std::chrono::steady_clock Clock;
+    const Clock::time_point start = Clock::now();
+    const Clock::duration period = std::chrono::microseconds(1000000 / std::max(1, stepsPerSecond));
+    Clock::time_point nextStep = start;
+    Clock::time_point nextReport = start + std::chrono::seconds(2);
+    size_t reportedBytes = 0;
+    unsigned long long step = 0;
+
+    while (!serverStopRequested) {
+        graph.updateLayout(0.16f);
+        ++step;
+        server.publish(graph, step, std::chrono::duration<double>(Clock::now() - start).count());
+
+        Clock::time_point now = Clock::now();
+        if (now >= nextReport) {
+            std::cout << "step " << step << ", clients " << server.clientCount()
+                << ", " << (server.bytesSent - reportedBytes) / 2048 << " KB/s"
+                << ", frames sent " << server.framesSent << ", skipped " << server.framesSkipped << std::endl;
+            reportedBytes = server.bytesSent;
+            nextReport = now + std::chrono::seconds(2);
+        }
+
+        nextStep += period;
+        if (nextStep < now) nextStep = now;
+        std::this_thread::sleep_until(nextStep);
+    }
+
+    server.close();
+    return 0;
+}
+
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
+void mouse_button_callback(GLFWwindow* window, int button, int action, int mods);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
+void char_callback(GLFWwindow* window, unsigned int codepoint);
+void refresh_callback(GLFWwindow* window);
 void processInput(GLFWwindow* window);
 
-int main() {
+// Headless layout of an edge file that may be larger than memory; prints
+// time per step and how fast the edges were streamed.
+int runOutOfCoreLayout(const std::string& path, int steps, int blockMegabytes, int readAhead, const char* positionsPath, const char* telemetryPath, float overlapRadius) {
+    OutOfCoreLayout layout;
+    layout.edges.blockBytes = (size_t)std::max(1, blockMegabytes) << 20;
+    layout.readAheadBlocks = readAhead;
+    if (!layout.open(path)) {
+        std::cout << "Cannot open edge file " << path << ": " << layout.error << std::endl;
+        return 1;
+    }
+    std::cout << "Laying out " << layout.edges.nodeCount() << " nodes, " << layout.edges.edgeCount() << " edges in "
+              << layout.edges.blocks().size() << " blocks of " << blockMegabytes << " MB" << std::endl;
+
+    // The quality measures need the edges in memory; energy, displacement
+    // and force come from the integration pass as usual.
+    LayoutTelemetry stepLog;
+    stepLog.qualityInterval = 0;
+    if (telemetryPath && !stepLog.openLog(telemetryPath)) {
+        std::cout << "Cannot write telemetry: " << stepLog.error << std::endl;
+        return 1;
+    }
+
+    std::signal(SIGINT, requestServerStop);
+    std::signal(SIGTERM, requestServerStop);
+    for (int step = 0; step < steps && !serverStopRequested; ++step) {
+        float moved = layout.step(0.16f);
+        const OutOfCoreLayout::StepStats& stats = layout.lastStep;
+        stepLog.record(layout.graph, stats.seconds);
+        std::cout << "step " << layout.steps << ": " << stats.seconds * 1000.0 << " ms (edges "
+                  << stats.attractionSeconds * 1000.0 << " ms, scanned " << stats.scanRate() / 1048576.0 << " MB/s, read from disk "
+                  << stats.diskRate() / 1048576.0 << " MB/s, " << stats.majorFaults << " major faults), largest move " << moved << std::endl;
+    }
+    const OutOfCoreLayout::StepStats& total = layout.total;
+    if (layout.steps > 0) {
+        std::cout << layout.steps << " steps, " << total.seconds / layout.steps * 1000.0 << " ms per step, "
+                  << total.bytesScanned / 1048576.0 << " MB scanned at " << total.scanRate() / 1048576.0 << " MB/s, "
+                  << total.diskBytes / 1048576.0 << " MB read from disk" << std::endl;
+    }
+
+    if (overlapRadius > 0.0f) {
+        OverlapRemover remover;
+        OverlapRemover::Stats overlapStats;
+        remover.radius = overlapRadius;
+        remover.removeOverlaps(layout.graph.positions, overlapStats);
+        std::cout << "Overlaps removed: " << overlapStats.moved << " nodes moved (at most " << overlapStats.maxMove
+                  << "), " << overlapStats.seconds << " s" << std::endl;
+    }
+
+    if (positionsPath && !layout.savePositions(positionsPath)) {
+        std::cout << "Cannot write positions to " << positionsPath << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (ShardedLayout::isWorkerInvocation(argc, argv)) {
+        return ShardedLayout::runWorker(argc, argv);
+    }
+
+    const char* streamPath = nullptr;
+    const char* serveEndpoint = nullptr;
+    const char* connectEndpoint = nullptr;
+    int serveNodes = 1000;
+    float serveEdgeProbability = 0.004f;
+    int serveRate = 60;
+    int serveBandwidth = 4096;
+    const char* edgeListPath = nullptr;
+    const char* edgeFilePath = nullptr;
+    const char* positionsPath = nullptr;
+    bool buildEdgeFile = false;
+    int layoutSteps = 100;
+    int memoryMegabytes = 1024;
+    int blockMegabytes = 64;
+    const char* telemetryPath = nullptr;
+    float overlapRadius = 0.0f;
+    int readAhead = 2;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--stream") == 0 && i + 1 < argc) {
+            streamPath = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--serve") == 0 && i + 1 < argc) {
+            serveEndpoint = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--connect") == 0 && i + 1 < argc) {
+            connectEndpoint = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--nodes") == 0 && i + 1 < argc) {
+            serveNodes = std::atoi(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--edge-probability") == 0 && i + 1 < argc) {
+            serveEdgeProbability = (float)std::atof(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--rate") == 0 && i + 1 < argc) {
+            serveRate = std::atoi(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--bandwidth") == 0 && i + 1 < argc) {
+            serveBandwidth = std::atoi(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--build-edge-file") == 0 && i + 2 < argc) {
+            buildEdgeFile = true;
+            edgeListPath = argv[++i];
+            edgeFilePath = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--edge-file") == 0 && i + 1 < argc) {
+            edgeFilePath = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--steps") == 0 && i + 1 < argc) {
+            layoutSteps = std::atoi(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--positions-out") == 0 && i + 1 < argc) {
+            positionsPath = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--memory") == 0 && i + 1 < argc) {
+            memoryMegabytes = std::atoi(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--block") == 0 && i + 1 < argc) {
+            blockMegabytes = std::atoi(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--read-ahead") == 0 && i + 1 < argc) {
+            readAhead = std::atoi(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--telemetry") == 0 && i + 1 < argc) {
+            telemetryPath = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--remove-overlaps") == 0 && i + 1 < argc) {
+            overlapRadius = (float)std::atof(argv[++i]);
+        }
+        else {
+            std::cout << "Usage: " << argv[0] << " [--stream <mutation file | ->] [--connect <endpoint>] [--telemetry <file.csv | file.json>]" << std::endl;
+            std::cout << "       " << argv[0] << " --serve <endpoint> [--nodes N] [--edge-probability P] [--rate steps/s] [--bandwidth KB/s]" << std::endl;
+            std::cout << "       " << argv[0] << " --build-edge-file <edge list> <edge file> [--memory MB]" << std::endl;
+            std::cout << "       " << argv[0] << " --edge-file <edge file> [--steps N] [--block MB] [--read-ahead blocks] [--positions-out file] [--telemetry file] [--remove-overlaps radius]" << std::endl;
+            std::cout << "endpoint: unix:<path> or [host:]port" << std::endl;
+            return 1;
+        }
+    }
+
+    if (buildEdgeFile) {
+        std::string error;
+        if (!EdgeFile::build(edgeListPath, edgeFilePath, (size_t)std::max(1, memoryMegabytes) << 20, error)) {
+            std::cout << "Cannot build edge file: " << error << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+    if (edgeFilePath) {
+        return runOutOfCoreLayout(edgeFilePath, layoutSteps, blockMegabytes, readAhead, positionsPath, telemetryPath, overlapRadius);
+    }
+    if (serveEndpoint) {
+        return runLayoutServer(serveEndpoint, serveNodes, serveEdgeProbability, serveRate, serveBandwidth);
+    }
+
     if (!glfwInit()) {
         std::cout << u8"GLFW初始化失败!" << std::endl;
         return -1;
@@ -74,6 +700,11 @@ int main() {
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
     glfwSetCursorPosCallback(window, mouse_callback);
     glfwSetScrollCallback(window, scroll_callback);
+    // Installed before ImGui so that its handlers chain to these.
+    glfwSetMouseButtonCallback(window, mouse_button_callback);
+    glfwSetKeyCallback(window, key_callback);
+    glfwSetCharCallback(window, char_callback);
+    glfwSetWindowRefreshCallback(window, refresh_callback);
 
     if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
         std::cout << u8"GLAD初始化失败!" << std::endl;
@@ -84,29 +715,187 @@ int main() {
 
     renderer.initialize();
     gui.initialize(window);
+    gui.analytics = &analytics;
+    gui.communities = &communities;
+    gui.stream = &mutationStream;
+    gui.compact = &compactGraph;
+    gui.renderer = &renderer;
+    gui.scheduler = &scheduler;
+    gui.sharded = &shardedLayout;
+    gui.client = &layoutClient;
+    gui.tuner = &tuner;
+    gui.telemetry = &telemetry;
+    gui.overlaps = &overlapRemover;
+    gui.oracle = &oracle;
 
     camera = Camera(glm::vec3(0.0f, 0.0f, 10.0f));
 
     graph.generateRandomGraph();
     adjustCameraToFitGraph();
+    appliedTopology = graph.topologyVersion;
+
+    mutationStream.onQueued = []() { glfwPostEmptyEvent(); };
+    if (streamPath && !mutationStream.open(streamPath)) {
+        gui.shutdown();
+        glfwTerminate();
+        return -1;
+    }
+    layoutClient.onReceived = []() { glfwPostEmptyEvent(); };
+    tuner.onProgress = []() { glfwPostEmptyEvent(); };
+    overlapRemover.onFinished = []() { glfwPostEmptyEvent(); };
+    if (telemetryPath && !telemetry.openLog(telemetryPath)) {
+        std::cout << "Cannot write telemetry: " << telemetry.error << std::endl;
+    }
+    if (connectEndpoint && !layoutClient.connect(connectEndpoint)) {
+        gui.shutdown();
+        glfwTerminate();
+        return -1;
+    }
 
+    const double idleTimeout = scheduler.idleTimeout;
     while (!glfwWindowShouldClose(window)) {
         float currentFrame = glfwGetTime();
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
 
         processInput(window);
+        scheduler.renderOnDemand = gui.params.renderOnDemand;
+        scheduler.maxFps = gui.params.maxFps;
+        // Worker snapshots arrive without an event to wake the loop, so an
+        // idle loop polls for them briefly while the workers are stepping.
+        scheduler.idleTimeout = shardedLayout.isRunning() && gui.params.autoLayout ? 0.01 : idleTimeout;
 
-        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        if (gui.shouldStartSharded()) {
+            startShardedLayout();
+            gui.resetStartShardedFlag();
+            scheduler.requestRedraw();
+        }
+        if (gui.shouldStopSharded()) {
+            shardedLayout.stop();
+            gui.resetStopShardedFlag();
+            wake();
+        }
+
+        if (gui.shouldStartTuning()) {
+            startTuning();
+            gui.resetStartTuningFlag();
+            scheduler.requestRedraw();
+        }
+        if (gui.shouldCancelTuning()) {
+            tuner.cancel();
+            gui.resetCancelTuningFlag();
+            scheduler.requestRedraw();
+        }
+        if (tuner.completed() != tunerShown) {
+            tunerShown = tuner.completed();
+            scheduler.requestRedraw();
+        }
+        if (!tuner.isRunning() && !tunerReported) {
+            reportTuning();
+            tunerReported = true;
+            scheduler.requestRedraw();
+        }
 
-        if (gui.params.autoLayout) {
+        if (layoutClient.isConnected()) {
+            if (layoutClient.apply(graph)) {
+                scheduler.requestRedraw();
+            }
+        }
+        else if (shardedLayout.isRunning()) {
+            shardedLayout.setParameters(gui.params.repulsionStrength, gui.params.attractionStrength, 0.16f);
+            shardedLayout.setPaused(!gui.params.autoLayout);
+            if (shardedLayout.fetchPositions(shardedPositions)) {
+                if (compactActive) {
+                    compactGraph.positions.swap(shardedPositions);
+                    compactPositionsDirty = true;
+                }
+                else {
+                    for (size_t i = 0; i < graph.nodes.size(); ++i) {
+                        graph.nodes[i].position = shardedPositions[i];
+                    }
+                    graph.dirtyNodes.markAll();
+                }
+                scheduler.requestRedraw();
+            }
+            else if (!shardedLayout.isRunning()) {
+                // The workers died; show the error.
+                scheduler.requestRedraw();
+            }
+        }
+        else if (compactActive) {
+            if (gui.params.autoLayout && !layoutSettled) {
+                compactGraph.repulsionStrength = gui.params.repulsionStrength;
+                compactGraph.attractionStrength = gui.params.attractionStrength;
+                auto stepStart = std::chrono::steady_clock::now();
+                float moved = compactGraph.updateLayout(deltaTime * 10.0f);
+                ++layoutVersion;
+                telemetry.record(compactGraph, std::chrono::duration<double>(std::chrono::steady_clock::now() - stepStart).count());
+                compactPositionsDirty = true;
+                layoutSettled = layoutHasSettled(moved);
+                scheduler.requestRedraw();
+            }
+            else if (!gui.params.autoLayout) {
+                compactGraph.releaseScratch();
+            }
+        }
+        else if (gui.params.autoLayout && !layoutSettled) {
+            graph.layoutStrength = gui.params.layoutStrength;
+            graph.repulsionStrength = gui.params.repulsionStrength;
+            graph.attractionStrength = gui.params.attractionStrength;
+            graph.communityAttractionBoost = gui.params.communityBoost;
+            auto stepStart = std::chrono::steady_clock::now();
+            float moved = graph.updateLayout(deltaTime * 10.0f);
+            ++layoutVersion;
+            telemetry.record(graph, std::chrono::duration<double>(std::chrono::steady_clock::now() - stepStart).count());
+            layoutSettled = layoutHasSettled(moved);
+            scheduler.requestRedraw();
+        }
+        const bool remoteLayout = shardedLayout.isRunning() || layoutClient.isConnected();
+        if (!compactActive && !remoteLayout) {
+            if (mutationStream.applyPending(graph, (size_t)gui.params.mutationsPerFrame) > 0) {
+                ++layoutVersion;
+                wake();
+            }
+        }
+        if (!compactActive && !remoteLayout && !gui.params.autoLayout && gui.params.incrementalLayout) {
             graph.layoutStrength = gui.params.layoutStrength;
             graph.repulsionStrength = gui.params.repulsionStrength;
             graph.attractionStrength = gui.params.attractionStrength;
-            graph.updateLayout(deltaTime * 10.0f);
+            if (graph.updateLocalLayout(deltaTime * 10.0f)) {
+                ++layoutVersion;
+                scheduler.requestRedraw();
+            }
+        }
+        if (!remoteLayout && !overlapRemover.isRunning()) {
+            const bool layoutIdle = !gui.params.autoLayout || layoutSettled;
+            if (gui.shouldRemoveOverlaps()
+                || (gui.params.removeOverlaps && layoutIdle && !graph.hasActiveRegion() && overlapVersion != layoutVersion)) {
+                startOverlapRemoval();
+                scheduler.requestRedraw();
+            }
+        }
+        gui.resetRemoveOverlapsFlag();
+        if (!overlapRemover.isRunning() && applyOverlapRemoval()) {
+            scheduler.requestRedraw();
         }
         if (gui.shouldRegenerate()) {
+            shardedLayout.stop();
+        }
+        if (gui.shouldRegenerate() && gui.params.compactMode) {
+            graph.clear();
+            compactActive = true;
+            generateCompactGraph();
+            adjustCameraToFitGraph();
+            resetPaths();
+            appliedSizeMode = -1;
+            telemetry.reset();
+            ++layoutVersion;
+            wake();
+            gui.resetRegenerateFlag();
+        }
+        if (gui.shouldRegenerate()) {
+            compactActive = false;
+            compactGraph.clear();
             graph.nodeCount = gui.params.nodeCount;
             graph.edgeProbability = gui.params.edgeProbability;
             graph.is3D = gui.params.is3D;
@@ -128,8 +917,79 @@ int main() {
 
             graph.normalizePositions();
             adjustCameraToFitGraph();
+            analytics.clear();
+            communities.clear();
+            resetPaths();
+            appliedColorMode = -1;
+            appliedTopology = graph.topologyVersion;
+            telemetry.reset();
+            ++layoutVersion;
+            wake();
             gui.resetRegenerateFlag();
         }
+        if (graph.topologyVersion != appliedTopology) {
+            // Metrics, colours and paths describe the old topology. Only what
+            // was actually computed is dropped, so a mutation stream does not
+            // rebuild and re-upload per-node arrays every frame.
+            if (analytics.valid() || communities.valid()) {
+                analytics.clear();
+                communities.clear();
+                appliedColorMode = -1;
+            }
+            if (oracle.valid() || !highlightedPath.empty()) {
+                resetPaths();
+            }
+            appliedTopology = graph.topologyVersion;
+        }
+        patchNodeSizes();
+        if (gui.shouldComputeAnalytics()) {
+            int source = gui.params.bfsSource < (int)graph.nodes.size() ? gui.params.bfsSource : 0;
+            analytics.computeAll(graph, source);
+            appliedColorMode = -1;
+            gui.resetAnalyticsFlag();
+        }
+        if (gui.shouldDetectCommunities()) {
+            communities.resolution = gui.params.communityResolution;
+            communities.detect(graph);
+            graph.nodeCommunity = communities.community;
+            appliedColorMode = -1;
+            gui.resetCommunitiesFlag();
+        }
+        if (gui.shouldBuildOracle()) {
+            buildOracle();
+            gui.resetBuildOracleFlag();
+            scheduler.requestRedraw();
+        }
+        if (gui.shouldFindPath()) {
+            findPath();
+            gui.resetFindPathFlag();
+            scheduler.requestRedraw();
+        }
+        if (gui.shouldClearPath()) {
+            showPath(std::vector<uint32_t>());
+            gui.resetClearPathFlag();
+            scheduler.requestRedraw();
+        }
+        if (gui.params.colorMode != appliedColorMode) {
+            if (gui.params.colorMode == COLOR_COMMUNITY) {
+                communities.buildNodeColors(nodeColors);
+            }
+            else {
+                analytics.buildNodeColors(gui.params.colorMode, nodeColors);
+            }
+            renderer.uploadColors(nodeColors);
+            appliedColorMode = gui.params.colorMode;
+            scheduler.requestRedraw();
+        }
+        if (gui.params.nodeSizeMode != appliedSizeMode || gui.params.nodeRadius != renderer.nodeRadius) {
+            updateNodeSizes();
+            appliedSizeMode = gui.params.nodeSizeMode;
+            scheduler.requestRedraw();
+        }
+        if (gui.shouldExportSVG() && compactActive) {
+            std::cout << "SVG export is not available in compact mode" << std::endl;
+            gui.resetExportFlag();
+        }
         if (gui.shouldExportSVG()) {
             time_t now = time(0);
             struct tm tstruct;
@@ -144,41 +1004,100 @@ int main() {
 
             graph.exportToSVG(filename, view, projection, width, height);
             gui.resetExportFlag();
+            scheduler.requestRedraw();
+        }
+        if (gui.shouldResetTelemetry()) {
+            telemetry.reset();
+            gui.resetResetTelemetryFlag();
+            scheduler.requestRedraw();
         }
+        if (gui.shouldToggleTelemetryLog()) {
+            if (telemetry.isLogging()) {
+                std::cout << "Telemetry written to " << telemetry.logPath() << std::endl;
+                telemetry.closeLog();
+            }
+            else {
+                time_t now = time(0);
+                struct tm tstruct;
+                char filename[80];
+                localtime_s(&tstruct, &now);
+                strftime(filename, sizeof(filename), gui.params.telemetryJson ? "layout_%Y%m%d_%H%M%S.json" : "layout_%Y%m%d_%H%M%S.csv", &tstruct);
+                if (!telemetry.openLog(filename)) {
+                    std::cout << "Cannot write telemetry: " << telemetry.error << std::endl;
+                }
+            }
+            gui.resetToggleTelemetryLogFlag();
+            scheduler.requestRedraw();
+        }
+        if (gui.shouldExportPNG()) {
+            time_t now = time(0);
+            struct tm tstruct;
+            char filename[80];
+            localtime_s(&tstruct, &now);
+            const int width = gui.params.pngWidth;
+            const int height = gui.params.pngHeight;
+            strftime(filename, sizeof(filename), gui.params.pngPyramid ? "graph_%Y%m%d_%H%M%S.dzi" : "graph_%Y%m%d_%H%M%S.png", &tstruct);
 
-        int width, height;
-        glfwGetFramebufferSize(window, &width, &height);
-        glm::mat4 projection = camera.getProjectionMatrix((float)width / (float)height, camera.zoom);
-        glm::mat4 view = camera.getViewMatrix();
-        glm::mat4 MVP = projection * view;
+            // Same camera as the SVG export, with the poster's aspect ratio.
+            glm::mat4 projection = camera.getProjectionMatrix((float)width / (float)height, camera.zoom);
+            glm::mat4 view = camera.getViewMatrix();
 
-        std::vector<std::pair<int, int>> edgePairs;
-        for (const auto& edge : graph.edges) {
-            edgePairs.emplace_back(edge.from, edge.to);
+            RasterExporter raster;
+            if (compactActive && gui.params.pngPyramid) {
+                raster.exportPyramid(compactGraph.positions, compactGraph.edgeIndices, filename, view, projection, width, height);
+            }
+            else if (compactActive) {
+                raster.exportPNG(compactGraph.positions, compactGraph.edgeIndices, filename, view, projection, width, height);
+            }
+            else if (gui.params.pngPyramid) {
+                raster.exportPyramid(graph, filename, view, projection, width, height);
+            }
+            else {
+                raster.exportPNG(graph, filename, view, projection, width, height);
+            }
+            gui.resetExportPNGFlag();
+            scheduler.requestRedraw();
         }
 
-        if (gui.params.showEdges && !graph.edges.empty()) {
-            std::vector<glm::vec3> positions;
-            for (const auto& node : graph.nodes) {
-                positions.push_back(node.position);
+        if (scheduler.shouldRender()) {
+            int width, height;
+            glfwGetFramebufferSize(window, &width, &height);
+            glm::mat4 projection = camera.getProjectionMatrix((float)width / (float)height, camera.zoom);
+            glm::mat4 view = camera.getViewMatrix();
+            glm::mat4 MVP = projection * view;
+
+            glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+            syncRenderBuffers();
+
+            if (gui.params.showEdges) {
+                renderer.renderEdges(MVP);
             }
-            renderer.renderEdges(positions, edgePairs, MVP);
-        }
 
-        if (gui.params.showNodes && !graph.nodes.empty()) {
-            std::vector<glm::vec3> positions;
-            for (const auto& node : graph.nodes) {
-                positions.push_back(node.position);
+            if (gui.params.showNodes) {
+                renderer.renderNodes(MVP);
             }
-            renderer.renderNodes(positions, MVP);
-        }
 
-        gui.render();
+            renderer.renderPath(MVP);
+
+            gui.render();
+
+            glfwSwapBuffers(window);
+            scheduler.frameRendered(glfwGetTime());
+        }
 
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        // Time spent idle is not simulation time.
+        if (scheduler.waitForNextFrame()) {
+            lastFrame = glfwGetTime();
+        }
     }
 
+    shardedLayout.stop();
+    tuner.cancel();
+    overlapRemover.cancel();
+    layoutClient.close();
+    mutationStream.close();
     gui.shutdown();
     glfwTerminate();
     return 0;
@@ -188,22 +1107,19 @@ void processInput(GLFWwindow* window) {
     if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
         glfwSetWindowShouldClose(window, true);
 
-    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
-        camera.processKeyboard(1, deltaTime);
-    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
-        camera.processKeyboard(2, deltaTime);
-    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
-        camera.processKeyboard(3, deltaTime);
-    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
-        camera.processKeyboard(4, deltaTime);
-    if (glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS)
-        camera.processKeyboard(5, deltaTime);
-    if (glfwGetKey(window, GLFW_KEY_E) == GLFW_PRESS)
-        camera.processKeyboard(6, deltaTime);
+    const int movementKeys[] = { GLFW_KEY_W, GLFW_KEY_S, GLFW_KEY_A, GLFW_KEY_D, GLFW_KEY_Q, GLFW_KEY_E };
+    for (int i = 0; i < 6; ++i) {
+        if (glfwGetKey(window, movementKeys[i]) == GLFW_PRESS) {
+            camera.processKeyboard(i + 1, deltaTime);
+            // Held keys only send repeat events at the OS rate; keep drawing.
+            scheduler.requestRedraw();
+        }
+    }
 }
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
     glViewport(0, 0, width, height);
+    scheduler.requestRedraw();
 }
 
 void mouse_callback(GLFWwindow* window, double xpos, double ypos) {
@@ -222,8 +1138,27 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos) {
     if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS) {
         camera.processMouseMovement(xoffset, yoffset);
     }
+    // Hover feedback in the GUI needs a frame too.
+    scheduler.requestRedraw();
+}
+
+void mouse_button_callback(GLFWwindow* window, int button, int action, int mods) {
+    wake();
 }
 
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset) {
     camera.processMouseScroll(yoffset);
+    scheduler.requestRedraw();
+}
+
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods) {
+    wake();
+}
+
+void char_callback(GLFWwindow* window, unsigned int codepoint) {
+    wake();
+}
+
+void refresh_callback(GLFWwindow* window) {
+    scheduler.requestRedraw();
 }